@@ -0,0 +1,412 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+#pragma once
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+enum class BinaryFormat : std::uint8_t { none = 0, msgpack = 1, cbor = 2 };
+
+inline bool parseBinaryFormat(std::string_view name, BinaryFormat& format)
+{
+    if (name == "msgpack") {
+        format = BinaryFormat::msgpack;
+    }
+    else if (name == "cbor") {
+        format = BinaryFormat::cbor;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+inline const char* getString(BinaryFormat format)
+{
+    switch (format) {
+    case BinaryFormat::msgpack:
+        return "msgpack";
+    case BinaryFormat::cbor:
+        return "cbor";
+    default:
+        return "none";
+    }
+}
+
+// Streaming writer for MessagePack and CBOR with the same interface as JsonWriter.
+// Both formats need the element count of objects and arrays upfront, so the size given to
+// beginObject and beginArray must be exact. Strings are written as utf-8, invalid sequences
+// are replaced by U+FFFD like in the json output.
+class BinaryWriter {
+public:
+    static constexpr std::size_t max_depth = 32u;
+
+    explicit BinaryWriter(BinaryFormat format = BinaryFormat::msgpack) : _format(format)
+    {
+    }
+
+    void clear(BinaryFormat format)
+    {
+        assert(format != BinaryFormat::none);
+        _format = format;
+        _buffer.clear();
+        _depth = 0u;
+        _remaining[0] = 1u;
+    }
+
+    void beginObject(std::size_t size)
+    {
+        element();
+        if (_format == BinaryFormat::msgpack) {
+            writeMsgpackHeader(size, 0x80u, 15u, 0xDEu, 0xDFu);
+        }
+        else {
+            writeCborHeader(cbor_map, size);
+        }
+        open(size * 2u);
+    }
+
+    void endObject()
+    {
+        close();
+    }
+
+    void beginArray(std::size_t size)
+    {
+        element();
+        if (_format == BinaryFormat::msgpack) {
+            writeMsgpackHeader(size, 0x90u, 15u, 0xDCu, 0xDDu);
+        }
+        else {
+            writeCborHeader(cbor_array, size);
+        }
+        open(size);
+    }
+
+    void endArray()
+    {
+        close();
+    }
+
+    void key(std::string_view name)
+    {
+        value(name);
+    }
+
+    void value(std::string_view text)
+    {
+        element();
+        if (isValidUtf8(text)) {
+            writeText(text);
+        }
+        else {
+            writeText(replaceInvalidUtf8(text));
+        }
+    }
+
+    void value(const char* text)
+    {
+        value(std::string_view(text));
+    }
+
+    void value(const std::string& text)
+    {
+        value(std::string_view(text));
+    }
+
+    void value(std::int64_t number)
+    {
+        if (number >= 0) {
+            value(static_cast<std::uint64_t>(number));
+            return;
+        }
+        element();
+        if (_format == BinaryFormat::msgpack) {
+            if (number >= -32) {
+                _buffer += static_cast<char>(number);
+            }
+            else if (number >= INT8_MIN) {
+                _buffer += '\xD0';
+                _buffer += static_cast<char>(number);
+            }
+            else if (number >= INT16_MIN) {
+                _buffer += '\xD1';
+                writeBigEndian(static_cast<std::uint16_t>(number));
+            }
+            else if (number >= INT32_MIN) {
+                _buffer += '\xD2';
+                writeBigEndian(static_cast<std::uint32_t>(number));
+            }
+            else {
+                _buffer += '\xD3';
+                writeBigEndian(static_cast<std::uint64_t>(number));
+            }
+        }
+        else {
+            // cbor encodes -1 - n as negative integer n
+            writeCborHeader(cbor_negative_integer, static_cast<std::uint64_t>(-(number + 1)));
+        }
+    }
+
+    void value(std::uint64_t number)
+    {
+        element();
+        if (_format == BinaryFormat::msgpack) {
+            if (number <= 0x7Fu) {
+                _buffer += static_cast<char>(number);
+            }
+            else if (number <= UINT8_MAX) {
+                _buffer += '\xCC';
+                _buffer += static_cast<char>(number);
+            }
+            else if (number <= UINT16_MAX) {
+                _buffer += '\xCD';
+                writeBigEndian(static_cast<std::uint16_t>(number));
+            }
+            else if (number <= UINT32_MAX) {
+                _buffer += '\xCE';
+                writeBigEndian(static_cast<std::uint32_t>(number));
+            }
+            else {
+                _buffer += '\xCF';
+                writeBigEndian(number);
+            }
+        }
+        else {
+            writeCborHeader(cbor_unsigned_integer, number);
+        }
+    }
+
+    void value(double number)
+    {
+        element();
+        _buffer += _format == BinaryFormat::msgpack ? '\xCB' : '\xFB';
+        std::uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        writeBigEndian(bits);
+    }
+
+    void value(bool flag)
+    {
+        element();
+        if (_format == BinaryFormat::msgpack) {
+            _buffer += flag ? '\xC3' : '\xC2';
+        }
+        else {
+            _buffer += flag ? '\xF5' : '\xF4';
+        }
+    }
+
+    void nullValue()
+    {
+        element();
+        _buffer += _format == BinaryFormat::msgpack ? '\xC0' : '\xF6';
+    }
+
+    // appends one complete encoded value of the same format, e.g. a message written before
+    void rawValue(std::string_view encoded)
+    {
+        element();
+        _buffer.append(encoded.data(), encoded.size());
+    }
+
+    const std::string& str() const
+    {
+        return _buffer;
+    }
+
+private:
+    static constexpr std::uint8_t cbor_unsigned_integer = 0u;
+    static constexpr std::uint8_t cbor_negative_integer = 1u;
+    static constexpr std::uint8_t cbor_text = 3u;
+    static constexpr std::uint8_t cbor_array = 4u;
+    static constexpr std::uint8_t cbor_map = 5u;
+
+    // counts the written elements against the announced size of the enclosing container
+    void element()
+    {
+        assert(_remaining[_depth] > 0u);
+        --_remaining[_depth];
+    }
+
+    void open(std::size_t elements)
+    {
+        assert(_depth + 1u < max_depth);
+        _remaining[++_depth] = elements;
+    }
+
+    void close()
+    {
+        assert(_depth > 0u && _remaining[_depth] == 0u);
+        --_depth;
+    }
+
+    template <typename T>
+    void writeBigEndian(T number)
+    {
+        char bytes[sizeof(T)];
+        for (std::size_t i = 0u; i < sizeof(T); ++i) {
+            bytes[i] = static_cast<char>(number >> (8u * (sizeof(T) - 1u - i)));
+        }
+        _buffer.append(bytes, sizeof(T));
+    }
+
+    void writeMsgpackHeader(std::size_t size,
+                            std::uint8_t fix_type,
+                            std::size_t fix_max,
+                            std::uint8_t type_16,
+                            std::uint8_t type_32)
+    {
+        if (size <= fix_max) {
+            _buffer += static_cast<char>(fix_type | size);
+        }
+        else if (size <= UINT16_MAX) {
+            _buffer += static_cast<char>(type_16);
+            writeBigEndian(static_cast<std::uint16_t>(size));
+        }
+        else {
+            _buffer += static_cast<char>(type_32);
+            writeBigEndian(static_cast<std::uint32_t>(size));
+        }
+    }
+
+    void writeCborHeader(std::uint8_t major_type, std::uint64_t argument)
+    {
+        const auto type = static_cast<std::uint8_t>(major_type << 5u);
+        if (argument < 24u) {
+            _buffer += static_cast<char>(type | argument);
+        }
+        else if (argument <= UINT8_MAX) {
+            _buffer += static_cast<char>(type | 24u);
+            _buffer += static_cast<char>(argument);
+        }
+        else if (argument <= UINT16_MAX) {
+            _buffer += static_cast<char>(type | 25u);
+            writeBigEndian(static_cast<std::uint16_t>(argument));
+        }
+        else if (argument <= UINT32_MAX) {
+            _buffer += static_cast<char>(type | 26u);
+            writeBigEndian(static_cast<std::uint32_t>(argument));
+        }
+        else {
+            _buffer += static_cast<char>(type | 27u);
+            writeBigEndian(argument);
+        }
+    }
+
+    void writeText(std::string_view text)
+    {
+        if (_format == BinaryFormat::msgpack) {
+            if (text.size() <= 31u) {
+                _buffer += static_cast<char>(0xA0u | text.size());
+            }
+            else if (text.size() <= UINT8_MAX) {
+                _buffer += '\xD9';
+                _buffer += static_cast<char>(text.size());
+            }
+            else {
+                writeMsgpackHeader(text.size(), 0u, 0u, 0xDAu, 0xDBu);
+            }
+        }
+        else {
+            writeCborHeader(cbor_text, text.size());
+        }
+        _buffer.append(text.data(), text.size());
+    }
+
+    // returns the length of the valid utf-8 sequence at the begin of text, 0 if invalid
+    static std::size_t validSequenceLength(std::string_view text)
+    {
+        const auto byte = [&text](std::size_t index) {
+            return static_cast<std::uint8_t>(text[index]);
+        };
+        const std::uint8_t first_byte = byte(0u);
+        std::size_t length = 0u;
+        std::uint8_t second_min = 0x80u;
+        std::uint8_t second_max = 0xBFu;
+        if (first_byte < 0x80u) {
+            return 1u;
+        }
+        else if (first_byte >= 0xC2u && first_byte <= 0xDFu) {
+            length = 2u;
+        }
+        else if (first_byte >= 0xE0u && first_byte <= 0xEFu) {
+            length = 3u;
+            // no overlong encodings and no surrogates
+            second_min = first_byte == 0xE0u ? 0xA0u : 0x80u;
+            second_max = first_byte == 0xEDu ? 0x9Fu : 0xBFu;
+        }
+        else if (first_byte >= 0xF0u && first_byte <= 0xF4u) {
+            length = 4u;
+            second_min = first_byte == 0xF0u ? 0x90u : 0x80u;
+            second_max = first_byte == 0xF4u ? 0x8Fu : 0xBFu;
+        }
+        else {
+            return 0u;
+        }
+        if (text.size() < length || byte(1u) < second_min || byte(1u) > second_max) {
+            return 0u;
+        }
+        for (std::size_t index = 2u; index < length; ++index) {
+            if ((byte(index) & 0xC0u) != 0x80u) {
+                return 0u;
+            }
+        }
+        return length;
+    }
+
+    static bool isValidUtf8(std::string_view text)
+    {
+        while (!text.empty()) {
+            const std::size_t length = validSequenceLength(text);
+            if (length == 0u) {
+                return false;
+            }
+            text.remove_prefix(length);
+        }
+        return true;
+    }
+
+    static std::string replaceInvalidUtf8(std::string_view text)
+    {
+        std::string result;
+        result.reserve(text.size() + 2u);
+        while (!text.empty()) {
+            const std::size_t length = validSequenceLength(text);
+            if (length == 0u) {
+                result += "\xEF\xBF\xBD";
+                text.remove_prefix(1u);
+            }
+            else {
+                result.append(text.data(), length);
+                text.remove_prefix(length);
+            }
+        }
+        return result;
+    }
+
+    BinaryFormat _format;
+    std::string _buffer;
+    std::array<std::size_t, max_depth> _remaining{{1u}};
+    std::size_t _depth = 0u;
+};
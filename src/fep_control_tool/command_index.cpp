@@ -0,0 +1,132 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "command_index.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace {
+// a displacement this large does not occur for the few names of the command table
+constexpr std::uint32_t max_displacement = 1u << 20u;
+
+std::size_t roundUpToPowerOfTwo(std::size_t value)
+{
+    std::size_t result = 1u;
+    while (result < value) {
+        result <<= 1u;
+    }
+    return result;
+}
+
+// fnv-1a, the seed selects one of a family of hash functions
+std::uint64_t hashName(std::string_view name, std::uint32_t seed)
+{
+    std::uint64_t hash = 0xcbf29ce484222325u ^ (seed * 0x9e3779b97f4a7c15u);
+    for (const char character: name) {
+        hash ^= static_cast<unsigned char>(character);
+        hash *= 0x100000001b3u;
+    }
+    hash ^= hash >> 33u;
+    hash *= 0xff51afd7ed558ccdu;
+    hash ^= hash >> 33u;
+    return hash;
+}
+} // namespace
+
+CommandIndex::CommandIndex(const std::vector<std::string_view>& names)
+    : _names(names),
+      _displacements(std::max<std::size_t>(roundUpToPowerOfTwo(names.size()) / 2u, 1u), 0u),
+      _slots(roundUpToPowerOfTwo(names.size() * 2u), 0u)
+{
+    std::vector<std::string_view> sorted_names(names);
+    std::sort(sorted_names.begin(), sorted_names.end());
+    for (std::size_t index = 0u; index < sorted_names.size(); ++index) {
+        if (sorted_names[index].empty()) {
+            throw std::logic_error("empty command name");
+        }
+        if (index > 0u && sorted_names[index] == sorted_names[index - 1u]) {
+            throw std::logic_error("command '" + std::string(sorted_names[index]) +
+                                   "' is given twice");
+        }
+    }
+
+    std::vector<std::vector<std::uint32_t>> buckets(_displacements.size());
+    for (std::size_t position = 0u; position < _names.size(); ++position) {
+        buckets[hashName(_names[position], 0u) & (buckets.size() - 1u)].push_back(
+            static_cast<std::uint32_t>(position));
+    }
+    // the largest buckets are placed first, while most slots are free
+    std::vector<std::size_t> bucket_order(buckets.size());
+    std::iota(bucket_order.begin(), bucket_order.end(), 0u);
+    std::stable_sort(
+        bucket_order.begin(), bucket_order.end(), [&buckets](std::size_t left, std::size_t right) {
+            return buckets[left].size() > buckets[right].size();
+        });
+
+    std::vector<std::size_t> bucket_slots;
+    for (const std::size_t bucket: bucket_order) {
+        if (buckets[bucket].empty()) {
+            break;
+        }
+        for (std::uint32_t displacement = 1u;; ++displacement) {
+            if (displacement == max_displacement) {
+                throw std::logic_error("no perfect hash found for the command names");
+            }
+            bucket_slots.clear();
+            for (const std::uint32_t position: buckets[bucket]) {
+                const std::size_t slot =
+                    hashName(_names[position], displacement) & (_slots.size() - 1u);
+                if (_slots[slot] != 0u || std::find(bucket_slots.begin(), bucket_slots.end(),
+                                                    slot) != bucket_slots.end()) {
+                    break;
+                }
+                bucket_slots.push_back(slot);
+            }
+            if (bucket_slots.size() == buckets[bucket].size()) {
+                for (std::size_t index = 0u; index < bucket_slots.size(); ++index) {
+                    _slots[bucket_slots[index]] = buckets[bucket][index] + 1u;
+                }
+                _displacements[bucket] = displacement;
+                break;
+            }
+        }
+    }
+}
+
+std::size_t CommandIndex::find(std::string_view name) const
+{
+    const std::uint32_t displacement =
+        _displacements[hashName(name, 0u) & (_displacements.size() - 1u)];
+    if (displacement == 0u) {
+        return npos;
+    }
+    const std::uint32_t entry = _slots[hashName(name, displacement) & (_slots.size() - 1u)];
+    if (entry == 0u || _names[entry - 1u] != name) {
+        return npos;
+    }
+    return entry - 1u;
+}
+
+std::size_t CommandIndex::getSize() const
+{
+    return _names.size();
+}
@@ -0,0 +1,49 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef COMMAND_INDEX_H
+#define COMMAND_INDEX_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Perfect hash of the command names (hash and displace): the names are spread over buckets by a
+// first hash, each bucket has a displacement which puts its names into free slots by a second
+// hash. A lookup hashes the name twice and compares it with the single name of its slot.
+// The names must outlive the index.
+class CommandIndex {
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // throws std::logic_error if a name is empty or given twice
+    explicit CommandIndex(const std::vector<std::string_view>& names);
+
+    // returns the position of the name in the names given to the constructor, or npos
+    std::size_t find(std::string_view name) const;
+    std::size_t getSize() const;
+
+private:
+    std::vector<std::string_view> _names;
+    std::vector<std::uint32_t> _displacements;
+    // position of the name + 1, 0 if the slot is free
+    std::vector<std::uint32_t> _slots;
+};
+
+#endif // COMMAND_INDEX_H
@@ -0,0 +1,423 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "command_script.h"
+
+#include "line_tokenizer.h"
+#include "worker_pool.h"
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <condition_variable>
+
+bool parseCommandScript(std::istream& input, std::vector<ScriptStep>& steps, std::string& error)
+{
+    steps.clear();
+    LineTokenizer tokenizer;
+    std::string line;
+    std::size_t line_number = 0u;
+    // the line of the open parallel block, 0 if none is open
+    std::size_t block_line_number = 0u;
+    while (std::getline(input, line)) {
+        ++line_number;
+        const auto& tokens = tokenizer.tokenize(line);
+        if (tokens.empty() || tokens.front().substr(0u, 1u) == "#") {
+            continue;
+        }
+        const std::string location = "line " + std::to_string(line_number) + ": ";
+        if (tokens.front() == "parallel") {
+            if (tokens.size() != 2u || tokens[1] != "{") {
+                error = location + "expected 'parallel {'";
+                return false;
+            }
+            if (block_line_number != 0u) {
+                error = location + "parallel blocks cannot be nested";
+                return false;
+            }
+            block_line_number = line_number;
+            steps.push_back(ScriptStep{ScriptStep::Kind::parallel, {}});
+        }
+        else if (tokens.front() == "}") {
+            if (tokens.size() != 1u || block_line_number == 0u) {
+                error = location + "unexpected '}'";
+                return false;
+            }
+            block_line_number = 0u;
+        }
+        else if (tokens.front() == "wait") {
+            if (tokens.size() != 1u) {
+                error = location + "'wait' has no arguments";
+                return false;
+            }
+            if (block_line_number != 0u) {
+                error = location + "'wait' is not allowed in a parallel block";
+                return false;
+            }
+            steps.push_back(ScriptStep{ScriptStep::Kind::wait, {}});
+        }
+        else {
+            ScriptCommand command{line_number,
+                                  std::vector<std::string>(tokens.begin(), tokens.end())};
+            if (block_line_number != 0u) {
+                steps.back()._commands.push_back(std::move(command));
+            }
+            else {
+                steps.push_back(ScriptStep{ScriptStep::Kind::command, {std::move(command)}});
+            }
+        }
+    }
+    if (block_line_number != 0u) {
+        error = "line " + std::to_string(block_line_number) + ": parallel block is not closed";
+        return false;
+    }
+    return true;
+}
+
+namespace {
+bool parseJsonCommand(const Json::Value& entry,
+                      const std::string& position,
+                      std::vector<ChainedCommand>& commands,
+                      std::string& error)
+{
+    thread_local Json::StreamWriterBuilder compact_builder = []() {
+        Json::StreamWriterBuilder builder;
+        builder.settings_["indentation"] = "";
+        return builder;
+    }();
+
+    if (!entry.isObject()) {
+        error = position + "expected an object with the string 'cmd'";
+        return false;
+    }
+    commands.emplace_back();
+    ChainedCommand& command = commands.back();
+    const Json::Value& id = entry["id"];
+    if (!id.isNull() && !id.isString() && !id.isNumeric()) {
+        error = position + "'id' is not a string or a number";
+        return false;
+    }
+    command._id = id;
+    if (!entry["async"].isNull() && !entry["async"].isBool()) {
+        error = position + "'async' is not a boolean";
+        return false;
+    }
+    command._async = entry["async"].asBool();
+    if (!entry["cmd"].isString() || entry["cmd"].asString().empty()) {
+        error = position + "expected an object with the string 'cmd'";
+        return false;
+    }
+    const Json::Value& arguments = entry["args"];
+    if (!arguments.isNull() && !arguments.isArray()) {
+        error = position + "'args' is not an array";
+        return false;
+    }
+    command._tokens.push_back(entry["cmd"].asString());
+    for (const auto& argument: arguments) {
+        if (argument.isObject() || argument.isArray()) {
+            command._tokens.push_back(Json::writeString(compact_builder, argument));
+        }
+        else if (argument.isNull()) {
+            error = position + "an argument is null";
+            return false;
+        }
+        else {
+            command._tokens.push_back(argument.asString());
+        }
+    }
+    return true;
+}
+} // namespace
+
+bool parseCommandChain(std::string_view line,
+                       LineTokenizer& tokenizer,
+                       std::vector<ChainedCommand>& commands,
+                       std::string& error)
+{
+    commands.clear();
+    const auto& words = tokenizer.tokenize(line);
+    if (words.empty()) {
+        return true;
+    }
+    commands.emplace_back();
+    for (std::size_t index = 0u; index < words.size(); ++index) {
+        std::string_view word = words[index];
+        std::string_view chain_operator;
+        if (!tokenizer.isQuoted(index)) {
+            if (word == ";" || word == "&&") {
+                chain_operator = word;
+                word = {};
+            }
+            else if (word.back() == ';') {
+                // 'command argument;' like in a shell
+                chain_operator = word.substr(word.size() - 1u);
+                word.remove_suffix(1u);
+            }
+        }
+        if (!word.empty()) {
+            commands.back()._tokens.emplace_back(word);
+        }
+        if (chain_operator.empty()) {
+            continue;
+        }
+        if (commands.back()._tokens.empty()) {
+            error = "missing command before '" + std::string(chain_operator) + "'";
+            return false;
+        }
+        commands.emplace_back();
+        commands.back()._after_success = chain_operator == "&&";
+    }
+    if (commands.back()._tokens.empty()) {
+        if (commands.back()._after_success) {
+            error = "missing command after '&&'";
+            return false;
+        }
+        commands.pop_back();
+    }
+    return true;
+}
+
+bool parseJsonCommands(std::string_view text,
+                       std::vector<ChainedCommand>& commands,
+                       std::string& error)
+{
+    commands.clear();
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+    Json::Value document;
+    std::string parse_errors;
+    if (!reader->parse(text.data(), text.data() + text.size(), &document, &parse_errors)) {
+        error = "invalid json: " + parse_errors;
+        return false;
+    }
+    if (document.isObject()) {
+        return parseJsonCommand(document, "", commands, error);
+    }
+    if (!document.isArray() || document.empty()) {
+        error = "expected a command object or a non-empty array of them";
+        return false;
+    }
+    for (Json::ArrayIndex index = 0u; index < document.size(); ++index) {
+        const std::string position = "command " + std::to_string(index + 1u) + ": ";
+        if (!parseJsonCommand(document[index], position, commands, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t ScriptGraph::add(const CommandTarget& target)
+{
+    const std::size_t index = _dependencies.size();
+    std::vector<std::size_t> dependencies;
+    if (target._barrier) {
+        dependencies = _since_barrier;
+        _systems.clear();
+        _since_barrier.clear();
+    }
+    else if (!target._system_name.empty()) {
+        auto& system = _systems[target._system_name];
+        if (system._last_system_command != no_command) {
+            dependencies.push_back(system._last_system_command);
+        }
+        if (target._participant_name.empty()) {
+            dependencies.insert(dependencies.end(),
+                                system._participant_commands.begin(),
+                                system._participant_commands.end());
+            system._last_system_command = index;
+            system._participant_commands.clear();
+            system._last_participant_commands.clear();
+        }
+        else {
+            // cleared by each command on the whole system
+            const auto last_command = system._last_participant_commands.find(
+                target._participant_name);
+            if (last_command != system._last_participant_commands.end()) {
+                dependencies.push_back(last_command->second);
+            }
+            system._last_participant_commands[target._participant_name] = index;
+            system._participant_commands.push_back(index);
+        }
+    }
+    if (dependencies.empty() && _last_barrier != no_command) {
+        dependencies.push_back(_last_barrier);
+    }
+    if (target._barrier) {
+        _last_barrier = index;
+    }
+    else {
+        _since_barrier.push_back(index);
+    }
+    _dependencies.push_back(std::move(dependencies));
+    return index;
+}
+
+std::size_t ScriptGraph::getSize() const
+{
+    return _dependencies.size();
+}
+
+const std::vector<std::size_t>& ScriptGraph::getDependencies(std::size_t index) const
+{
+    return _dependencies[index];
+}
+
+void ScriptGraph::run(WorkerPool& workers,
+                      const std::function<void(std::size_t)>& run_command) const
+{
+    std::vector<std::vector<std::size_t>> dependents(_dependencies.size());
+    std::vector<std::size_t> waiting_for(_dependencies.size());
+    for (std::size_t index = 0u; index < _dependencies.size(); ++index) {
+        waiting_for[index] = _dependencies[index].size();
+        for (const std::size_t dependency: _dependencies[index]) {
+            dependents[dependency].push_back(index);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable all_done;
+    std::size_t done = 0u;
+    std::function<void(std::size_t)> start;
+    start = [&](std::size_t index) {
+        workers.submit([&, index]() {
+            run_command(index);
+            std::lock_guard<std::mutex> lck(mutex);
+            for (const std::size_t dependent: dependents[index]) {
+                if (--waiting_for[dependent] == 0u) {
+                    start(dependent);
+                }
+            }
+            if (++done == _dependencies.size()) {
+                all_done.notify_all();
+            }
+        });
+    };
+
+    std::unique_lock<std::mutex> lck(mutex);
+    for (std::size_t index = 0u; index < _dependencies.size(); ++index) {
+        if (waiting_for[index] == 0u) {
+            start(index);
+        }
+    }
+    all_done.wait(lck, [&]() { return done == _dependencies.size(); });
+}
+
+namespace {
+template <typename CommandPtr>
+void removeDone(std::vector<CommandPtr>& commands)
+{
+    commands.erase(std::remove_if(commands.begin(),
+                                  commands.end(),
+                                  [](const CommandPtr& command) { return command->_done; }),
+                   commands.end());
+}
+} // namespace
+
+CommandScheduler::CommandScheduler(WorkerPool& workers) : _workers(workers)
+{
+}
+
+CommandScheduler::~CommandScheduler()
+{
+    wait();
+}
+
+void CommandScheduler::submit(const CommandTarget& target, std::function<void()> run)
+{
+    auto command = std::make_shared<Command>();
+    command->_run = std::move(run);
+
+    std::lock_guard<std::mutex> lck(_mutex);
+    std::vector<CommandPtr> dependencies;
+    if (target._barrier) {
+        dependencies = std::move(_since_barrier);
+        _systems.clear();
+        _since_barrier.clear();
+    }
+    else if (!target._system_name.empty()) {
+        auto& system = _systems[target._system_name];
+        if (system._last_system_command) {
+            dependencies.push_back(system._last_system_command);
+        }
+        removeDone(system._participant_commands);
+        if (target._participant_name.empty()) {
+            dependencies.insert(dependencies.end(),
+                                system._participant_commands.begin(),
+                                system._participant_commands.end());
+            system._last_system_command = command;
+            system._participant_commands.clear();
+            system._last_participant_commands.clear();
+        }
+        else {
+            auto& last_command = system._last_participant_commands[target._participant_name];
+            if (last_command) {
+                dependencies.push_back(last_command);
+            }
+            last_command = command;
+            system._participant_commands.push_back(command);
+        }
+    }
+    if (dependencies.empty() && _last_barrier) {
+        dependencies.push_back(_last_barrier);
+    }
+    if (target._barrier) {
+        _last_barrier = command;
+    }
+    else {
+        removeDone(_since_barrier);
+        _since_barrier.push_back(command);
+    }
+
+    for (const auto& dependency: dependencies) {
+        if (!dependency->_done) {
+            dependency->_dependents.push_back(command);
+            ++command->_waiting_for;
+        }
+    }
+    if (command->_waiting_for == 0u) {
+        start(command);
+    }
+}
+
+void CommandScheduler::wait()
+{
+    // a command done starts its dependents before its task ends
+    _workers.wait();
+}
+
+void CommandScheduler::start(const CommandPtr& command)
+{
+    _workers.submit([this, command]() {
+        command->_run();
+        finish(command);
+    });
+}
+
+void CommandScheduler::finish(const CommandPtr& command)
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    command->_done = true;
+    command->_run = nullptr;
+    for (const auto& dependent: command->_dependents) {
+        if (--dependent->_waiting_for == 0u) {
+            start(dependent);
+        }
+    }
+    command->_dependents.clear();
+}
@@ -0,0 +1,164 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef COMMAND_SCRIPT_H
+#define COMMAND_SCRIPT_H
+
+#include <json/json.h>
+
+#include <functional>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class LineTokenizer;
+class WorkerPool;
+
+struct ScriptCommand {
+    std::size_t _line_number = 0u;
+    std::vector<std::string> _tokens;
+};
+
+// A script is a sequence of steps:
+//   a command on its own line runs after all commands started before are done,
+//   'parallel {' ... '}' starts the commands of the block at once, they run concurrently with
+//   the commands of following blocks,
+//   'wait' blocks until all commands started before are done.
+// Empty lines and lines starting with '#' are skipped.
+struct ScriptStep {
+    enum class Kind { command, parallel, wait };
+
+    Kind _kind = Kind::command;
+    // one command for Kind::command, none for Kind::wait
+    std::vector<ScriptCommand> _commands;
+};
+
+// returns false and the error with its line number if the script is malformed
+bool parseCommandScript(std::istream& input, std::vector<ScriptStep>& steps, std::string& error);
+
+// a command of a line or frame with several commands
+struct ChainedCommand {
+    std::vector<std::string> _tokens;
+    // runs only if the command before succeeded ('&&'), otherwise in any case (';')
+    bool _after_success = false;
+    // the id of a json command, echoed in the json messages written by the command
+    Json::Value _id;
+    // runs the command as job
+    bool _async = false;
+};
+
+// splits the line at the words ';' and '&&' which are neither quoted nor escaped, a word may also
+// end with ';' and the line with ';', returns false and the error if a command is missing; an
+// empty line has no commands
+bool parseCommandChain(std::string_view line,
+                       LineTokenizer& tokenizer,
+                       std::vector<ChainedCommand>& commands,
+                       std::string& error);
+// parses a json command '{"id": 1, "cmd": "name", "args": [...]}' or an array of them which run
+// one after the other; the id is optional, a string or a number; '"async": true' runs the command
+// as job; the arguments are scalars, or objects and arrays which are passed on as compact json
+// text. If an entry is invalid, the last command holds the id of this entry
+bool parseJsonCommands(std::string_view text,
+                       std::vector<ChainedCommand>& commands,
+                       std::string& error);
+
+// what a command of a script acts on, commands on the same target keep their order
+struct CommandTarget {
+    // waits for all commands before, all commands after wait for it
+    bool _barrier = false;
+    // no system: independent of all commands except barriers
+    std::string _system_name;
+    // no participant: acts on the whole system
+    std::string _participant_name;
+};
+
+// Dependencies of the commands of a script: a command waits for the commands before it on the
+// same participant, a command on a whole system also for those on its participants, and the
+// other way round. The dependencies form a DAG, independent commands run concurrently.
+class ScriptGraph {
+public:
+    // returns the index of the command
+    std::size_t add(const CommandTarget& target);
+    std::size_t getSize() const;
+    // the commands the command waits for directly, with smaller indices
+    const std::vector<std::size_t>& getDependencies(std::size_t index) const;
+    // runs each command on the workers once the commands it waits for are done, returns when all
+    // are done
+    void run(WorkerPool& workers, const std::function<void(std::size_t)>& run_command) const;
+
+private:
+    struct SystemState {
+        // the last command on the whole system and the commands on participants after it
+        std::size_t _last_system_command = no_command;
+        std::vector<std::size_t> _participant_commands;
+        std::map<std::string, std::size_t> _last_participant_commands;
+    };
+    static constexpr std::size_t no_command = static_cast<std::size_t>(-1);
+
+    std::vector<std::vector<std::size_t>> _dependencies;
+    std::map<std::string, SystemState> _systems;
+    std::size_t _last_barrier = no_command;
+    std::vector<std::size_t> _since_barrier;
+};
+
+// Runs the commands submitted one after the other on the workers, ordered like the commands of a
+// ScriptGraph: a command waits for the unfinished commands before it on the same target, the
+// others run concurrently. Only the unfinished commands are kept.
+class CommandScheduler {
+public:
+    explicit CommandScheduler(WorkerPool& workers);
+    // waits for the commands submitted before
+    ~CommandScheduler();
+
+    CommandScheduler(const CommandScheduler&) = delete;
+    CommandScheduler& operator=(const CommandScheduler&) = delete;
+
+    void submit(const CommandTarget& target, std::function<void()> run);
+    // blocks until all commands submitted before are done
+    void wait();
+
+private:
+    struct Command {
+        std::function<void()> _run;
+        std::size_t _waiting_for = 0u;
+        std::vector<std::shared_ptr<Command>> _dependents;
+        bool _done = false;
+    };
+    using CommandPtr = std::shared_ptr<Command>;
+    struct SystemState {
+        CommandPtr _last_system_command;
+        std::vector<CommandPtr> _participant_commands;
+        std::map<std::string, CommandPtr> _last_participant_commands;
+    };
+
+    void start(const CommandPtr& command);
+    void finish(const CommandPtr& command);
+
+    WorkerPool& _workers;
+    std::mutex _mutex;
+    std::map<std::string, SystemState> _systems;
+    CommandPtr _last_barrier;
+    std::vector<CommandPtr> _since_barrier;
+};
+
+#endif // COMMAND_SCRIPT_H
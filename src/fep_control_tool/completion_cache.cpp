@@ -0,0 +1,146 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+
+#include "completion_cache.h"
+
+#include <algorithm>
+
+namespace {
+std::vector<std::string> fetchParticipantNames(const fep3::System& system)
+{
+    std::vector<std::string> participant_names;
+    for (const auto& participant: system.getParticipants()) {
+        participant_names.push_back(participant.getName());
+    }
+    return participant_names;
+}
+} // namespace
+
+CompletionCache::CompletionCache() : CompletionCache(&fetchParticipantNames)
+{
+}
+
+CompletionCache::CompletionCache(Fetch fetch) : _fetch(std::move(fetch))
+{
+}
+
+CompletionCache::~CompletionCache()
+{
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        _stop = true;
+        _pending.clear();
+    }
+    _refresh_requested.notify_one();
+    if (_refresh_thread.joinable()) {
+        _refresh_thread.join();
+    }
+}
+
+void CompletionCache::enable()
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    if (!_enabled) {
+        _enabled = true;
+        _refresh_thread = std::thread([this]() { run(); });
+    }
+}
+
+bool CompletionCache::isEnabled() const
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    return _enabled;
+}
+
+void CompletionCache::refresh(const std::string& system_name, const fep3::System& system)
+{
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        if (!_enabled) {
+            return;
+        }
+        _pending[system_name] = system;
+    }
+    _refresh_requested.notify_one();
+}
+
+void CompletionCache::remove(const std::string& system_name)
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    _pending.erase(system_name);
+    _participant_names.erase(system_name);
+    if (_fetching == system_name) {
+        _fetch_removed = true;
+    }
+}
+
+bool CompletionCache::getParticipantNames(const std::string& system_name,
+                                          std::vector<std::string>& participant_names) const
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    const auto names = _participant_names.find(system_name);
+    if (names == _participant_names.end()) {
+        return false;
+    }
+    participant_names = names->second;
+    return true;
+}
+
+void CompletionCache::waitForRefresh()
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    _refreshed.wait(lck, [this]() { return _pending.empty() && _fetching.empty(); });
+}
+
+void CompletionCache::run()
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    for (;;) {
+        _refresh_requested.wait(lck, [this]() { return _stop || !_pending.empty(); });
+        if (_stop) {
+            return;
+        }
+        auto pending = _pending.begin();
+        _fetching = pending->first;
+        _fetch_removed = false;
+        const fep3::System system = std::move(pending->second);
+        _pending.erase(pending);
+        lck.unlock();
+
+        std::vector<std::string> participant_names;
+        bool fetched = true;
+        try {
+            participant_names = _fetch(system);
+        }
+        catch (const std::exception&) {
+            // the names fetched before are kept, the next refresh tries again
+            fetched = false;
+        }
+
+        // sorted for the completion by prefix
+        std::sort(participant_names.begin(), participant_names.end());
+        lck.lock();
+        if (fetched && !_fetch_removed) {
+            _participant_names[_fetching] = std::move(participant_names);
+        }
+        _fetching.clear();
+        _refreshed.notify_all();
+    }
+}
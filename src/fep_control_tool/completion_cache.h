@@ -0,0 +1,79 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+
+#ifndef COMPLETION_CACHE_H
+#define COMPLETION_CACHE_H
+
+#include <fep_system/fep_system.h>
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Keeps the participant names of the systems for the completion of the command line. The names
+// are fetched by a background thread when a refresh is requested after discovery or a state
+// change, so completing never waits for the service bus.
+class CompletionCache {
+public:
+    using Fetch = std::function<std::vector<std::string>(const fep3::System& system)>;
+
+    // fetches the names of the participants of the system
+    CompletionCache();
+    explicit CompletionCache(Fetch fetch);
+    // waits for a fetch in progress
+    ~CompletionCache();
+
+    CompletionCache(const CompletionCache&) = delete;
+    CompletionCache& operator=(const CompletionCache&) = delete;
+
+    // refreshes are ignored until enabled, only the command line completes
+    void enable();
+    bool isEnabled() const;
+    // fetches the names again in the background, replaces a refresh of the system not started yet
+    void refresh(const std::string& system_name, const fep3::System& system);
+    void remove(const std::string& system_name);
+    // the names fetched last sorted, false if none were fetched yet
+    bool getParticipantNames(const std::string& system_name,
+                             std::vector<std::string>& participant_names) const;
+    // waits until the refreshes requested before are done
+    void waitForRefresh();
+
+private:
+    void run();
+
+    const Fetch _fetch;
+    mutable std::mutex _mutex;
+    std::condition_variable _refresh_requested;
+    std::condition_variable _refreshed;
+    std::map<std::string, fep3::System> _pending;
+    std::map<std::string, std::vector<std::string>> _participant_names;
+    // the system whose names are fetched, its result is dropped if it is removed meanwhile
+    std::string _fetching;
+    bool _fetch_removed = false;
+    bool _enabled = false;
+    bool _stop = false;
+    std::thread _refresh_thread;
+};
+
+#endif // COMPLETION_CACHE_H
@@ -0,0 +1,130 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+
+#include "completion_index.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+std::vector<std::string> completePrefix(const std::vector<std::string>& sorted_names,
+                                        const std::string& prefix)
+{
+    std::vector<std::string> completions;
+    for (auto name = std::lower_bound(sorted_names.begin(), sorted_names.end(), prefix);
+         name != sorted_names.end() && name->compare(0u, prefix.size(), prefix) == 0;
+         ++name) {
+        completions.push_back(*name);
+    }
+    return completions;
+}
+
+CompletionIndex::CompletionIndex(std::size_t capacity)
+    : _capacity(std::max<std::size_t>(capacity, 1u))
+{
+}
+
+void CompletionIndex::add(const std::string& name)
+{
+    if (name.empty() || name.find('\n') != std::string::npos) {
+        return;
+    }
+    const auto compare = [](const Entry& entry, const std::string& value) {
+        return entry._name < value;
+    };
+    auto entry = std::lower_bound(_entries.begin(), _entries.end(), name, compare);
+    if (entry != _entries.end() && entry->_name == name) {
+        entry->_last_use = ++_use_count;
+        return;
+    }
+    if (_entries.size() >= _capacity) {
+        // only done for new names of a full index
+        const auto least_recently_used = std::min_element(
+            _entries.begin(), _entries.end(), [](const Entry& left, const Entry& right) {
+                return left._last_use < right._last_use;
+            });
+        _entries.erase(least_recently_used);
+        entry = std::lower_bound(_entries.begin(), _entries.end(), name, compare);
+    }
+    _entries.insert(entry, Entry{name, ++_use_count});
+}
+
+std::vector<std::string> CompletionIndex::complete(const std::string& prefix) const
+{
+    std::vector<std::string> completions;
+    for (auto entry = std::lower_bound(_entries.begin(),
+                                       _entries.end(),
+                                       prefix,
+                                       [](const Entry& entry, const std::string& value) {
+                                           return entry._name < value;
+                                       });
+         entry != _entries.end() && entry->_name.compare(0u, prefix.size(), prefix) == 0;
+         ++entry) {
+        completions.push_back(entry->_name);
+    }
+    return completions;
+}
+
+std::size_t CompletionIndex::getSize() const
+{
+    return _entries.size();
+}
+
+bool CompletionIndex::load(const std::string& file_path)
+{
+    std::ifstream file(file_path);
+    if (!file) {
+        return false;
+    }
+    std::string name;
+    while (std::getline(file, name)) {
+        add(name);
+    }
+    return true;
+}
+
+bool CompletionIndex::save(const std::string& file_path) const
+{
+    std::vector<const Entry*> entries;
+    for (const auto& entry: _entries) {
+        entries.push_back(&entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry* left, const Entry* right) {
+        return left->_last_use < right->_last_use;
+    });
+    std::ofstream file(file_path, std::ios::trunc);
+    for (const auto* entry: entries) {
+        file << entry->_name << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+std::string getCompletionFilePath()
+{
+#ifdef _WIN32
+    const char* home = std::getenv("USERPROFILE");
+#else
+    const char* home = std::getenv("HOME");
+#endif
+    if (home == nullptr || *home == '\0') {
+        return std::string();
+    }
+    return std::string(home) + "/.fep_control_completions";
+}
@@ -0,0 +1,67 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+
+#ifndef COMPLETION_INDEX_H
+#define COMPLETION_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// returns the names starting with the prefix, the names must be sorted
+std::vector<std::string> completePrefix(const std::vector<std::string>& sorted_names,
+                                        const std::string& prefix);
+
+// Names offered by the completion, e.g. the property paths used before. The names are kept
+// sorted, so the names with a prefix are found by binary search. The count of names is bounded,
+// the least recently used one is evicted first.
+class CompletionIndex {
+public:
+    static constexpr std::size_t default_capacity = 1024u;
+
+    explicit CompletionIndex(std::size_t capacity = default_capacity);
+
+    // adds the name or marks it as used recently
+    void add(const std::string& name);
+    // the names starting with the prefix, sorted
+    std::vector<std::string> complete(const std::string& prefix) const;
+    std::size_t getSize() const;
+    // the file has one name per line, the least recently used first. Loading adds the names to
+    // the ones known already.
+    bool load(const std::string& file_path);
+    bool save(const std::string& file_path) const;
+
+private:
+    struct Entry {
+        std::string _name;
+        std::uint64_t _last_use = 0u;
+    };
+
+    const std::size_t _capacity;
+    // sorted by name
+    std::vector<Entry> _entries;
+    std::uint64_t _use_count = 0u;
+};
+
+// the file keeping the completions between sessions in the home directory of the user, empty if
+// there is no home directory
+std::string getCompletionFilePath();
+
+#endif // COMPLETION_INDEX_H
@@ -20,42 +20,149 @@ You may add additional accurate notices of copyright ownership.
 
 #include "fep_control.h"
 
+#include "command_index.h"
+#include "command_script.h"
 #include "control_tool_common_helper.h"
 #include "helper.h"
+#include "line_tokenizer.h"
+#include "message_writer.h"
+#include "worker_pool.h"
 
 #include <a_util/filesystem.h>
 #include <a_util/strings.h>
 #include <fep_system/rpc_services/rpc_passthrough/rpc_passthrough_intf.h>
 #include <jsonrpccpp/client/rpcprotocolclient.h>
+#include <charconv>
+#include <fstream>
+#include <set>
+#include <shared_mutex>
 #include <sstream>
+#include <stdexcept>
+
+namespace {
+// set while a thread runs a command of a script whose output is written in script order, each
+// output is kept on its own, so a websocket client still gets one frame per message
+thread_local std::vector<std::string>* captured_output = nullptr;
+
+// only commands which neither add nor remove systems or monitors nor change settings of the
+// session run in parallel blocks or concurrently with other commands
+const std::set<std::string> parallel_commands = {
+    "getCurrentWorkingDirectory",
+    "help",
+    "loadSystem",
+    "unloadSystem",
+    "setInitPriority",
+    "getInitPriority",
+    "setStartPriority",
+    "getStartPriority",
+    "initializeSystem",
+    "deinitializeSystem",
+    "startSystem",
+    "stopSystem",
+    "pauseSystem",
+    "showLogs",
+    "getLogBufferStatistics",
+    "getLogLatency",
+    "logStats",
+    "getLogDropStatistics",
+    "queryLogArchive",
+    "loadParticipant",
+    "unloadParticipant",
+    "initializeParticipant",
+    "deinitializeParticipant",
+    "startParticipant",
+    "stopParticipant",
+    "pauseParticipant",
+    "shutdownParticipant",
+    "getParticipantPropertyNames",
+    "getParticipantProperties",
+    "getParticipantProperty",
+    "setParticipantProperty",
+    "getParticipantRPCObjects",
+    "getParticipantRPCObjectIIDs",
+    "getParticipantRPCObjectIIDDefinition",
+    "getSystemState",
+    "setSystemState",
+    "getParticipantState",
+    "setParticipantState",
+    "getParticipants",
+    "callRPC",
+    "getCurrentTimingMaster"};
+// set while a thread runs a json command with an id, the id is added to its json messages
+thread_local const Json::Value* request_id = nullptr;
+
+void addRequestId(Json::Value& message)
+{
+    if (request_id != nullptr && message.isObject() && message.isMember("action")) {
+        message["id"] = *request_id;
+    }
+}
 
-FepControl::FepControl(bool json_mode) : _json_mode(json_mode), monitor(*this, json_mode)
+// the command table does not change, so it is checked and indexed once, an inconsistent table
+// throws when the first FepControl is created
+const CommandIndex& indexControlCommands(const std::vector<ControlCommand>& commands)
 {
-   fep3::preloadServiceBusPlugin();
+    static const CommandIndex command_index = [&commands]() {
+        std::vector<std::string_view> names;
+        for (const auto& command: commands) {
+            if (command._action == nullptr ||
+                command._last_optional_parameters > command._arguments.size()) {
+                throw std::logic_error("invalid definition of command '" + command._name + "'");
+            }
+            for (const auto& argument: command._arguments) {
+                if (argument._completion == nullptr) {
+                    throw std::logic_error("argument '" + argument._description +
+                                           "' of command '" + command._name +
+                                           "' has no completion");
+                }
+            }
+            std::set<std::string> option_names;
+            for (const auto& option: command._options) {
+                if (option._name.size() <= 2u || option._name.compare(0u, 2u, "--") != 0 ||
+                    !option_names.insert(option._name).second) {
+                    throw std::logic_error("invalid option '" + option._name + "' of command '" +
+                                           command._name + "'");
+                }
+            }
+            names.push_back(command._name);
+        }
+        return CommandIndex(names);
+    }();
+    return command_index;
 }
+} // namespace
 
-void FepControl::discoverSystemByName(const std::string& name)
+FepControl::FepControl(bool json_mode, BinaryFormat binary_format)
+    : _json_mode(json_mode || binary_format != BinaryFormat::none),
+      _binary_format(binary_format),
+      _log_batcher([this](const std::vector<LogRecord>& records) { writeLogBatch(records); })
 {
-    auto system_name = name;
-    // this updates for completion
-    _last_system_name_used = system_name;
-    if (system_name == _empty_system_name) {
-        system_name = "";
-    }
-    auto system = fep3::discoverSystem(system_name);
-    _connected_or_discovered_systems[system.getSystemName()] = std::move(system);
+   indexControlCommands(getControlCommands());
+   fep3::preloadServiceBusPlugin();
+   for (const char* property_path: {"clock/main_clock", "clock/step_size", "clock/time_factor"}) {
+       _used_properties.add(property_path);
+   }
 }
 
 std::map<std::string, fep3::System>::iterator FepControl::getConnectedOrDiscoveredSystem(
     const std::string& name, const bool auto_discovery, const std::string& action)
 {
-    auto it = _connected_or_discovered_systems.find(name);
-    if (it != _connected_or_discovered_systems.end()) {
-        _last_system_name_used = name;
-        return it;
+    {
+        std::lock_guard<std::mutex> lck(_systems_mutex);
+        auto it = _connected_or_discovered_systems.find(name);
+        if (it != _connected_or_discovered_systems.end()) {
+            _last_system_name_used = name;
+            return it;
+        }
     }
-    else if (auto_discovery) {
-        discoverSystemByName(name);
+    if (auto_discovery) {
+        auto system = fep3::discoverSystem(name == _empty_system_name ? "" : name);
+        {
+            std::lock_guard<std::mutex> lck(_systems_mutex);
+            _last_system_name_used = name;
+            // a command of a script running in parallel may have discovered it meanwhile
+            _connected_or_discovered_systems.emplace(system.getSystemName(), std::move(system));
+        }
         return getConnectedOrDiscoveredSystem(name, false, action);
     }
 
@@ -66,15 +173,21 @@ std::map<std::string, fep3::System>::iterator FepControl::getConnectedOrDiscover
     return _connected_or_discovered_systems.end();
 }
 
+std::mutex& FepControl::getSystemMutex(const std::string& system_name)
+{
+    std::lock_guard<std::mutex> lck(_systems_mutex);
+    return _system_mutexes[system_name];
+}
+
 std::vector<std::string> FepControl::usedPropertiesCompletion(const std::string& word_prefix)
 {
-    std::vector<std::string> completions;
-    for (const auto& prop: _used_properties) {
-        if (prop.compare(0u, word_prefix.size(), word_prefix) == 0) {
-            completions.push_back(prop);
-        }
+    // jobs change the systems meanwhile, nothing is completed while a command runs exclusively
+    std::shared_lock<std::shared_mutex> session_lock(_session_mutex, std::try_to_lock);
+    if (!session_lock.owns_lock()) {
+        return {};
     }
-    return completions;
+    std::lock_guard<std::mutex> lck(_systems_mutex);
+    return _used_properties.complete(word_prefix);
 }
 
 std::vector<std::string> FepControl::noCompletion(const std::string&)
@@ -99,6 +212,11 @@ std::vector<std::string> FepControl::localFilesCompletion(const std::string& wor
 
 std::vector<std::string> FepControl::connectedSystemsCompletion(const std::string& word_prefix)
 {
+    std::shared_lock<std::shared_mutex> session_lock(_session_mutex, std::try_to_lock);
+    if (!session_lock.owns_lock()) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lck(_systems_mutex);
     std::vector<std::string> completions;
     for (const auto& system: _connected_or_discovered_systems) {
         if (system.first.compare(0u, word_prefix.size(), word_prefix) == 0) {
@@ -110,16 +228,52 @@ std::vector<std::string> FepControl::connectedSystemsCompletion(const std::strin
 
 std::vector<std::string> FepControl::connectedParticipantsCompletion(const std::string& word_prefix)
 {
-    std::vector<std::string> completions;
-    const auto& found_system = _connected_or_discovered_systems.find(_last_system_name_used);
-    if (found_system != _connected_or_discovered_systems.cend()) {
-        auto parts = found_system->second.getParticipants();
-        for (const auto& part: parts) {
-            if (part.getName().compare(0u, word_prefix.size(), word_prefix) == 0) {
-                completions.push_back(part.getName());
+    // never asks the service bus nor waits for a command, so the prompt does not block
+    std::shared_lock<std::shared_mutex> session_lock(_session_mutex, std::try_to_lock);
+    if (!session_lock.owns_lock()) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lck(_systems_mutex);
+    std::vector<std::string> participant_names;
+    if (!_completion_cache.getParticipantNames(_last_system_name_used, participant_names)) {
+        const auto found_system = _connected_or_discovered_systems.find(_last_system_name_used);
+        if (found_system != _connected_or_discovered_systems.end()) {
+            // the cache copies the system, a system used by a command meanwhile is refreshed
+            // by the next completion, which offers the names
+            std::unique_lock<std::mutex> system_lock(_system_mutexes[found_system->first],
+                                                     std::try_to_lock);
+            if (system_lock.owns_lock()) {
+                _completion_cache.refresh(found_system->first, found_system->second);
             }
         }
     }
+    return completePrefix(participant_names, word_prefix);
+}
+
+std::vector<std::string> FepControl::monitoredSystemsCompletion(const std::string& word_prefix)
+{
+    std::shared_lock<std::shared_mutex> session_lock(_session_mutex, std::try_to_lock);
+    if (!session_lock.owns_lock()) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lck(_systems_mutex);
+    std::vector<std::string> completions;
+    for (const auto& monitor: _monitors) {
+        if (monitor.first.compare(0u, word_prefix.size(), word_prefix) == 0) {
+            completions.push_back(monitor.first);
+        }
+    }
+    return completions;
+}
+
+std::vector<std::string> FepControl::binaryFormatCompletion(const std::string& word_prefix)
+{
+    std::vector<std::string> completions;
+    for (const char* format: {"msgpack", "cbor"}) {
+        if (std::string(format).compare(0u, word_prefix.size(), word_prefix) == 0) {
+            completions.push_back(format);
+        }
+    }
     return completions;
 }
 
@@ -144,37 +298,244 @@ std::string resolveFilesystemErrorCode(const a_util::filesystem::Error error_cod
     return "UNKNOWN_ERROR";
 }
 
-class JsonObject {
-    Json::Value jsonValue;
+namespace {
+MessageWriter& beginEnvelope(MessageWriter& writer,
+                             const std::string& action,
+                             CmdStatus cmd_status = CmdStatus::no_error)
+{
+    writer.beginObject(request_id != nullptr ? 4u : 3u);
+    writer.key("action");
+    writer.value(action);
+    if (request_id != nullptr) {
+        writer.key("id");
+        writer.value(*request_id);
+    }
+    writer.key("status");
+    writer.value(static_cast<std::int64_t>(cmd_status));
+    writer.key("value");
+    return writer;
+}
 
-public:
-    JsonObject(const std::string& action, CmdStatus cmdStatus = CmdStatus::no_error)
-    {
-        jsonValue["action"] = action;
-        jsonValue["status"] =
-            static_cast<typename std::underlying_type<CmdStatus>::type>(cmdStatus);
-        jsonValue["value"] = Json::Value();
+// json objects are written with ascending keys, later duplicates replace earlier ones
+void writeAttributes(MessageWriter& writer, const Attributes& attributes)
+{
+    if (attributes.empty()) {
+        writer.nullValue();
+        return;
     }
-    void setValue(const std::string& key, const std::string& value)
-    {
-        jsonValue["value"][key] = value;
+    thread_local std::vector<const Attribute*> sorted;
+    sorted.clear();
+    for (const auto& attribute: attributes) {
+        sorted.push_back(&attribute);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Attribute* lhs, const Attribute* rhs) {
+        return lhs->first < rhs->first;
+    });
+    auto unique_end = sorted.begin();
+    for (auto it = sorted.begin(); it != sorted.end(); ++it) {
+        if (std::next(it) == sorted.end() || (*std::next(it))->first != (*it)->first) {
+            *(unique_end++) = *it;
+        }
     }
+    sorted.erase(unique_end, sorted.end());
 
-    void setValue(const Json::Value& value)
-    {
-        jsonValue["value"] = value;
+    writer.beginObject(sorted.size());
+    for (const Attribute* attribute: sorted) {
+        writer.key(attribute->first);
+        writer.value(attribute->second);
     }
+    writer.endObject();
+}
 
-    void setValue(const std::string& key, const Json::Value& value)
-    {
-        jsonValue["value"][key] = value;
+void writeLogRecord(MessageWriter& writer, const LogRecord& record)
+{
+    const std::size_t size =
+        5u + (record._truncated ? 1u : 0u) + (record._system_name.empty() ? 0u : 1u);
+    writer.beginObject(size);
+    writer.key("logger_name");
+    writer.value(record._logger_name);
+    writer.key("message");
+    writer.value(record._message);
+    writer.key("participant_name");
+    writer.value(record._participant_name);
+    writer.key("severity_level");
+    writer.value(getString(record._severity));
+    if (!record._system_name.empty()) {
+        writer.key("system_name");
+        writer.value(record._system_name);
+    }
+    writer.key("timestamp");
+    writer.value(static_cast<std::int64_t>(record._time.count()));
+    if (record._truncated) {
+        writer.key("truncated");
+        writer.value(true);
+    }
+    writer.endObject();
+}
+
+// appends a table with columns as wide as their longest entry, the first text_columns are left
+// aligned, the numbers behind them right aligned
+template <std::size_t column_count>
+void appendTable(std::string& output,
+                 const std::vector<std::array<std::string, column_count>>& rows,
+                 std::size_t text_columns)
+{
+    std::array<std::size_t, column_count> widths{};
+    for (const auto& row: rows) {
+        for (std::size_t column = 0u; column < column_count; ++column) {
+            widths[column] = std::max(widths[column], row[column].size());
+        }
+    }
+    for (const auto& row: rows) {
+        for (std::size_t column = 0u; column < column_count; ++column) {
+            const std::string padding(widths[column] - row[column].size(), ' ');
+            if (column < text_columns) {
+                appendOutput(output, row[column]);
+                appendOutput(output, padding);
+            }
+            else {
+                appendOutput(output, padding);
+                appendOutput(output, row[column]);
+            }
+            if (column + 1u < column_count) {
+                appendOutput(output, "  ");
+            }
+        }
+        appendOutput(output, "\n");
+    }
+}
+
+void writeJobValue(MessageWriter& writer, const JobInfo& job)
+{
+    writer.beginObject(5u);
+    writer.key("command");
+    writer.value(job._command_line);
+    writer.key("duration_us");
+    writer.value(static_cast<std::int64_t>(job._duration.count()));
+    writer.key("job");
+    writer.value(static_cast<std::int64_t>(job._id));
+    writer.key("result");
+    writer.value(static_cast<std::int64_t>(job._result));
+    writer.key("state");
+    writer.value(getJobStateName(job._state));
+    writer.endObject();
+}
+
+bool hasEnded(const JobInfo& job)
+{
+    return job._state != JobInfo::State::queued && job._state != JobInfo::State::running;
+}
+} // namespace
+
+MessageWriter& FepControl::beginMessage()
+{
+    thread_local MessageWriter writer;
+    writer.clear(_binary_format);
+    return writer;
+}
+
+// writes the completed message, json as one line
+void FepControl::writeMessage(MessageWriter& writer)
+{
+    writer.endMessage();
+    sinkOutput(writer.str());
+}
+
+void FepControl::sinkOutput(const std::string& output)
+{
+    if (captured_output != nullptr) {
+        captured_output->push_back(output);
+        return;
+    }
+    writeOutputToSink(output);
+}
+
+LogBatcher& FepControl::getLogBatcher()
+{
+    return _log_batcher;
+}
+
+LogDelivery& FepControl::getLogDelivery()
+{
+    return _log_delivery;
+}
+
+void FepControl::enableCompletionCache()
+{
+    _completion_cache.enable();
+    const std::string file_path = getCompletionFilePath();
+    if (!file_path.empty()) {
+        _used_properties.load(file_path);
+    }
+}
+
+void FepControl::saveCompletions()
+{
+    const std::string file_path = getCompletionFilePath();
+    if (_completion_cache.isEnabled() && !file_path.empty()) {
+        _used_properties.save(file_path);
+    }
+}
+
+void FepControl::stopLogBatching()
+{
+    _log_batcher.stop();
+}
+
+void FepControl::stopLogOutput()
+{
+    for (auto& monitor: _monitors) {
+        monitor.second->stop();
     }
+    _log_delivery.stop();
+    stopLogBatching();
+}
 
-    const Json::Value& getObject()
+void FepControl::stopJobs()
+{
+    // the events of the cancelled jobs lock the mutex as well
+    std::unique_ptr<JobQueue> jobs;
     {
-        return jsonValue;
+        std::lock_guard<std::mutex> lck(_jobs_mutex);
+        jobs = std::move(_jobs);
     }
-};
+    jobs.reset();
+}
+
+BinaryFormat FepControl::getBinaryFormat() const
+{
+    return _binary_format;
+}
+
+// writes a json document given as Json::Value, e.g. the property trees
+void FepControl::writeJsonValue(const Json::Value& value)
+{
+    if (request_id != nullptr && value.isObject() && value.isMember("action") &&
+        !value.isMember("id")) {
+        Json::Value message = value;
+        addRequestId(message);
+        writeJsonValue(message);
+        return;
+    }
+    if (_binary_format != BinaryFormat::none) {
+        auto& writer = beginMessage();
+        writer.value(value);
+        writeMessage(writer);
+    }
+    else {
+        writeOutput(_builder.convertJson(value), "\n");
+    }
+}
+
+void FepControl::writeBinaryShutdownMessage()
+{
+    auto& writer = beginMessage();
+    writer.beginObject(1u);
+    writer.key("action");
+    writer.value("applicationShutdown");
+    writer.endObject();
+    writeMessage(writer);
+}
 
 // writes a simple json object with 'action' and 'note'
 // 'note' contains an arbitrary string with any information
@@ -182,9 +543,7 @@ public:
 void FepControl::writeNote(const std::string& action, const std::string& note)
 {
     if (_json_mode) {
-        JsonObject jsonObject(action);
-        jsonObject.setValue("note", note);
-        writeOutput(_builder.convertJson(jsonObject.getObject()), "\n");
+        writeNote(action, Attribute("note", note));
     }
     else {
         writeOutput(note, "\n");
@@ -198,9 +557,13 @@ void FepControl::writeNote(const std::string& action,
                            const Attribute& attribute)
 {
     if (_json_mode) {
-        JsonObject jsonObject(action);
-        jsonObject.setValue(attribute.first, attribute.second);
-        writeOutput(_builder.convertJson(jsonObject.getObject()), "\n");
+        auto& writer = beginEnvelope(beginMessage(), action);
+        writer.beginObject(1u);
+        writer.key(attribute.first);
+        writer.value(attribute.second);
+        writer.endObject();
+        writer.endObject();
+        writeMessage(writer);
     }
     else {
         writeOutput(attribute.first, " : ", attribute.second, "\n");
@@ -213,11 +576,10 @@ void FepControl::writeNote(const std::string& action,
 void FepControl::writeNotes(const std::string& action, const Attributes& attributes)
 {
     if (_json_mode) {
-        JsonObject jsonObject(action);
-        for (const auto& attribute: attributes) {
-            jsonObject.setValue(attribute.first, attribute.second);
-        }
-        writeOutput(_builder.convertJson(jsonObject.getObject()), "\n");
+        auto& writer = beginEnvelope(beginMessage(), action);
+        writeAttributes(writer, attributes);
+        writer.endObject();
+        writeMessage(writer);
     }
     else {
         std::vector<std::string> notes;
@@ -231,17 +593,19 @@ void FepControl::writeNotes(const std::string& action, const Attributes& attribu
 void FepControl::writeNotes(const std::string& action, 
                             const AttributesVec& attributes_vec) {
     if (_json_mode) {
-        JsonObject jsonObject(action);
-        Json::Value val;
-        for (const auto& attributes : attributes_vec) {
-            Json::Value tmp;
-            for (const auto& attr : attributes) {
-                tmp[attr.first] = attr.second;
+        auto& writer = beginEnvelope(beginMessage(), action);
+        if (attributes_vec.empty()) {
+            writer.nullValue();
+        }
+        else {
+            writer.beginArray(attributes_vec.size());
+            for (const auto& attributes: attributes_vec) {
+                writeAttributes(writer, attributes);
             }
-            val.append(tmp);
+            writer.endArray();
         }
-        jsonObject.setValue(val);
-        writeOutput(_builder.convertJson(jsonObject.getObject()), "\n");
+        writer.endObject();
+        writeMessage(writer);
     }
     else {
         for (const auto& attributes : attributes_vec) {
@@ -260,12 +624,17 @@ void FepControl::writeError(const std::string& action,
                             const std::string& reason = "")
 {
     if (_json_mode) {
-        JsonObject jsonObject(action, status);
-        jsonObject.setValue("error", error);
+        auto& writer = beginEnvelope(beginMessage(), action, status);
+        writer.beginObject(reason.empty() ? 1u : 2u);
+        writer.key("error");
+        writer.value(error);
         if (reason != "") {
-            jsonObject.setValue("reason", reason);
+            writer.key("reason");
+            writer.value(reason);
         }
-        writeOutput(_builder.convertJson(jsonObject.getObject()), "\n");
+        writer.endObject();
+        writer.endObject();
+        writeMessage(writer);
     }
     else {
         writeOutput(error);
@@ -284,10 +653,15 @@ void FepControl::writeException(const std::string& action,
                                 const std::exception& e)
 {
     if (_json_mode) {
-        JsonObject jsonObject(action, status);
-        jsonObject.setValue("exception", exception);
-        jsonObject.setValue("reason", (std::string) e.what());
-        writeOutput(_builder.convertJson(jsonObject.getObject()), "\n");
+        auto& writer = beginEnvelope(beginMessage(), action, status);
+        writer.beginObject(2u);
+        writer.key("exception");
+        writer.value(exception);
+        writer.key("reason");
+        writer.value(e.what());
+        writer.endObject();
+        writer.endObject();
+        writeMessage(writer);
     }
     else {
         writeOutput(exception, ", exception: ", e.what(), "\n");
@@ -337,6 +711,7 @@ bool FepControl::discoverAllSystems(TokenIterator first, TokenIterator)
             // special system name -
             system_name = _empty_system_name;
         }
+        std::lock_guard<std::mutex> lck(_systems_mutex);
         _connected_or_discovered_systems.emplace(system_name, std::move(system));
         // this updates for completion
         _last_system_name_used = system_name;
@@ -348,14 +723,18 @@ bool FepControl::discoverSystem(TokenIterator first, TokenIterator)
 {
     const std::string action = *(first++);
     std::string system_name = *first;
-    // this updates for completion
-    _last_system_name_used = system_name;
+    {
+        std::lock_guard<std::mutex> lck(_systems_mutex);
+        // this updates for completion
+        _last_system_name_used = system_name;
+    }
     if (system_name == _empty_system_name) {
         system_name = "";
     }
     auto system = fep3::discoverSystem(system_name);
     writeNotes(action, getSystemParticipants(system));
 
+    std::lock_guard<std::mutex> lck(_systems_mutex);
     _connected_or_discovered_systems[system.getSystemName()] = std::move(system);
     return true;
 }
@@ -557,6 +936,7 @@ bool FepControl::shutdownSystem(TokenIterator first, TokenIterator)
         [&](fep3::System& sys) {
             const std::string name = sys.getSystemName();
             sys.shutdown();
+            std::lock_guard<std::mutex> lck(_systems_mutex);
             _connected_or_discovered_systems.erase(name);
         },
         action,
@@ -564,22 +944,119 @@ bool FepControl::shutdownSystem(TokenIterator first, TokenIterator)
         "shutdown");
 }
 
-bool FepControl::startMonitoringSystem(TokenIterator first, TokenIterator)
+namespace {
+// returns the value of the last occurrence of the option, processCommandline puts the options
+// as name and value behind the positional arguments
+boost::optional<std::string> getOption(TokenIterator first,
+                                       TokenIterator last,
+                                       const std::string& name)
+{
+    boost::optional<std::string> value;
+    for (; first != last && std::next(first) != last; ++first) {
+        if (*first == name) {
+            value = *(++first);
+        }
+    }
+    return value;
+}
+
+template <typename T>
+bool parseNumber(const std::string& text, T& number)
+{
+    const char* end = text.data() + text.size();
+    const auto result = std::from_chars(text.data(), end, number);
+    return result.ec == std::errc() && result.ptr == end;
+}
+} // namespace
+
+Monitor& FepControl::getMonitor(const std::string& system_name)
+{
+    auto& monitor = _monitors[system_name];
+    if (!monitor) {
+        monitor = std::make_unique<Monitor>(
+            *this, _json_mode, LogHub::getInstance().getChannel(system_name));
+    }
+    return *monitor;
+}
+
+void FepControl::setMonitorsJsonMode(const bool json_mode)
+{
+    for (auto& monitor: _monitors) {
+        monitor.second->setJsonMode(json_mode);
+    }
+}
+
+void FepControl::writeLogBatch(const std::vector<LogRecord>& records)
+{
+    auto& writer = beginMessage();
+    writer.beginObject(2u);
+    writer.key("log_type");
+    writer.value("log_batch");
+    writer.key("messages");
+    writer.beginArray(records.size());
+    for (const auto& record: records) {
+        writeLogRecord(writer, record);
+    }
+    writer.endArray();
+    writer.endObject();
+    writeMessage(writer);
+}
+
+// builds the filter of the options of the monitoring commands, nullptr if none is given
+bool FepControl::getLogFilter(const std::string& action,
+                              TokenIterator first,
+                              TokenIterator last,
+                              std::shared_ptr<const LogFilter>& filter)
+{
+    const auto min_severity = getOption(first, last, "--min-severity");
+    const auto participant = getOption(first, last, "--participant");
+    const auto logger = getOption(first, last, "--logger");
+    const auto regex = getOption(first, last, "--regex");
+    boost::optional<fep3::LoggerSeverity> severity;
+    if (min_severity) {
+        fep3::LoggerSeverity value = fep3::LoggerSeverity::off;
+        if (!getSeverityFromString(*min_severity, value)) {
+            const std::string error =
+                "Invalid severity '" + *min_severity +
+                "' for --min-severity, use fatal, error, warning, info or debug";
+            writeError(action, error, CmdStatus::input_error);
+            return false;
+        }
+        severity = value;
+    }
+    // the filter is built once, onLog only applies it
+    filter.reset();
+    if (min_severity || participant || logger || regex) {
+        try {
+            filter = std::make_shared<const LogFilter>(severity, participant, logger, regex);
+        }
+        catch (const std::regex_error& e) {
+            const std::string error = "Invalid regular expression '" + *regex + "' for --regex";
+            writeError(action, error, CmdStatus::input_error, e.what());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FepControl::startMonitoringSystem(TokenIterator first, TokenIterator last)
 {
     const std::string action = *first;
 
+    std::shared_ptr<const LogFilter> filter;
+    if (!getLogFilter(action, first, last, filter)) {
+        return false;
+    }
+
     auto it = getConnectedOrDiscoveredSystem(*(++first), _auto_discovery_of_systems, action);
     if (it == _connected_or_discovered_systems.end()) {
         return false;
     }
     else {
-        try {
-            it->second.unregisterMonitoring(monitor);
-        }
-        catch (const std::exception&) {
-            //...
-        }
-        it->second.registerMonitoring(monitor);
+        auto& monitor = getMonitor(it->first);
+        monitor.setFilter(std::move(filter));
+        // registers once per system for all sessions
+        monitor.start(it->second);
         writeNote(action, "monitoring: enabled");
         return true;
     }
@@ -594,94 +1071,674 @@ bool FepControl::stopMonitoringSystem(TokenIterator first, TokenIterator)
         return false;
     }
     else {
-        try {
-            it->second.unregisterMonitoring(monitor);
-        }
-        catch (const std::exception&) {
-            //...
+        auto monitor = _monitors.find(it->first);
+        if (monitor != _monitors.end()) {
+            monitor->second->stop();
+            // the drops are not reported by later log messages anymore
+            monitor->second->writeDropSummaries(true);
         }
         writeNote(action, "monitoring: disabled");
         return true;
     }
 }
 
-bool FepControl::doParticipantStateChange(
-    TokenIterator& first,
-    std::function<void(fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine>&)> change_state,
-    const std::string& action,
-    const std::string& message_1,
-    const std::string& message_2)
+bool FepControl::startMonitoringAll(TokenIterator first, TokenIterator last)
 {
-    auto it = getConnectedOrDiscoveredSystem(*first, _auto_discovery_of_systems, action);
-    if (it == _connected_or_discovered_systems.end()) {
+    const std::string action = *(first++);
+    // the pattern is optional, the options follow the arguments
+    const std::string pattern =
+        first != last && first->compare(0u, 2u, "--") != 0 ? *first : std::string("*");
+
+    std::shared_ptr<const LogFilter> filter;
+    if (!getLogFilter(action, first, last, filter)) {
         return false;
     }
-    std::string partname = "";
-    try {
-        partname = *std::next(first);
-        auto part = it->second.getParticipant(partname);
-        if (part) {
-            auto state_machine =
-                part.getRPCComponentProxy<fep3::rpc::IRPCParticipantStateMachine>();
-            if (state_machine) {
-                change_state(state_machine);
-            }
-            else {
-                const std::string error =
-                    "participant '" + partname + "@" + *first + "' has no state machine";
-                writeError(action, error, CmdStatus::statechange_error);
-                return false;
-            }
-        }
-        else {
-            const std::string error =
-                "participant '" + partname + "' is not in system '" + *first + "'";
-            writeError(action, error, CmdStatus::statechange_error);
-            return false;
+
+    // systems appearing later are not monitored, the command has to be called again for them
+    for (auto&& system: fep3::discoverAllSystems()) {
+        std::string system_name = system.getSystemName();
+        if (system_name.empty()) {
+            system_name = _empty_system_name;
         }
+        std::lock_guard<std::mutex> lck(_systems_mutex);
+        _connected_or_discovered_systems.emplace(system_name, std::move(system));
+    }
 
-        // this updates for completion
-        _last_system_name_used = it->first;
+    // the log messages of all systems are written by the log delivery as one stream
+    const GlobPattern system_pattern(pattern);
+    std::vector<std::string> system_names;
+    for (auto& system: _connected_or_discovered_systems) {
+        if (!system_pattern.matches(system.first)) {
+            continue;
+        }
+        auto& monitor = getMonitor(system.first);
+        monitor.setFilter(filter);
+        monitor.start(system.second);
+        system_names.push_back(system.first);
     }
-    catch (const std::exception& e) {
-        const std::string exception =
-            "cannot " + message_1 + " participant '" + partname + "@" + *first + "'";
-        writeException(action, exception, CmdStatus::statechange_error, e);
-        return false;
+    const Attributes attributes = {{"monitoring", "enabled"},
+                                   {"systems", a_util::strings::join(system_names, ", ")}};
+    if (_json_mode) {
+        writeNotes(action, attributes);
+    }
+    else {
+        for (const auto& attribute: attributes) {
+            writeNote(action, attribute);
+        }
     }
-    const std::string note = partname + "@" + *first + " " + message_2;
-    writeNote(action, note);
     return true;
 }
 
-bool FepControl::loadParticipant(TokenIterator first, TokenIterator)
+bool FepControl::stopMonitoringAll(TokenIterator first, TokenIterator last)
 {
     const std::string action = *(first++);
-    return doParticipantStateChange(
-        first,
-        [](fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine>& part) { part->load(); },
-        action,
-        "load",
-        "loaded");
+    const GlobPattern system_pattern(first != last ? *first : std::string("*"));
+
+    std::vector<std::string> system_names;
+    for (auto& monitor: _monitors) {
+        if (!monitor.second->isStarted() || !system_pattern.matches(monitor.first)) {
+            continue;
+        }
+        monitor.second->stop();
+        // the drops are not reported by later log messages anymore
+        monitor.second->writeDropSummaries(true);
+        system_names.push_back(monitor.first);
+    }
+    const Attributes attributes = {{"monitoring", "disabled"},
+                                   {"systems", a_util::strings::join(system_names, ", ")}};
+    if (_json_mode) {
+        writeNotes(action, attributes);
+    }
+    else {
+        for (const auto& attribute: attributes) {
+            writeNote(action, attribute);
+        }
+    }
+    return true;
 }
-bool FepControl::unloadParticipant(TokenIterator first, TokenIterator)
+
+void FepControl::writeLogRecords(const std::string& action, const std::vector<LogRecord>& records)
 {
-    const std::string action = *(first++);
-    return doParticipantStateChange(
-        first,
-        [](fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine>& part) { part->unload(); },
-        action,
-        "unload",
-        "unloaded");
+    if (_json_mode) {
+        auto& writer = beginEnvelope(beginMessage(), action);
+        writer.beginArray(records.size());
+        for (const auto& record: records) {
+            writeLogRecord(writer, record);
+        }
+        writer.endArray();
+        writer.endObject();
+        writeMessage(writer);
+    }
+    else if (records.empty()) {
+        writeOutput("no log messages\n");
+    }
+    else {
+        // all records are written at once
+        std::string output;
+        for (const auto& record: records) {
+            appendOutput(output, "    LOG [");
+            appendOutput(output, getString(record._severity));
+            appendOutput(output, "] [");
+            appendOutput(output, record._time.count());
+            appendOutput(output, " ms] ");
+            appendOutput(output, record._logger_name);
+            appendOutput(output, "@");
+            appendOutput(output, record._participant_name);
+            appendOutput(output, " :");
+            appendOutput(output, record._message);
+            appendOutput(output, "\n");
+        }
+        writeOutput(output);
+    }
 }
 
-bool FepControl::initializeParticipant(TokenIterator first, TokenIterator)
+bool FepControl::showLogs(TokenIterator first, TokenIterator last)
 {
     const std::string action = *(first++);
-    return doParticipantStateChange(
-        first,
-        [](fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine>& part) {
-            part->initialize();
+    const std::string system_name = *first;
+
+    auto monitor = _monitors.find(system_name);
+    if (monitor == _monitors.end()) {
+        const std::string error = "System '" + system_name + "' is not monitored";
+        writeError(action, error, CmdStatus::generic_error);
+        return false;
+    }
+
+    LogQuery query;
+    const auto since = getOption(first, last, "--since");
+    const auto severity = getOption(first, last, "--severity");
+    const auto participant = getOption(first, last, "--participant");
+    const auto limit = getOption(first, last, "--limit");
+    std::int64_t since_ms = 0;
+    fep3::LoggerSeverity min_severity = fep3::LoggerSeverity::off;
+    if (since && !parseNumber(*since, since_ms)) {
+        writeError(action, "Invalid time '" + *since + "' for --since", CmdStatus::input_error);
+        return false;
+    }
+    if (severity && !getSeverityFromString(*severity, min_severity)) {
+        const std::string error = "Invalid severity '" + *severity +
+                                  "' for --severity, use fatal, error, warning, info or debug";
+        writeError(action, error, CmdStatus::input_error);
+        return false;
+    }
+    if (limit && !parseNumber(*limit, query._limit)) {
+        writeError(action, "Invalid count '" + *limit + "' for --limit", CmdStatus::input_error);
+        return false;
+    }
+    if (since) {
+        query._since = std::chrono::milliseconds(since_ms);
+    }
+    if (severity) {
+        query._severity = min_severity;
+    }
+    query._participant_name = participant;
+
+    writeLogRecords(action, monitor->second->getLogBuffer().query(query));
+    return true;
+}
+
+bool FepControl::getLogBufferStatistics(TokenIterator first, TokenIterator)
+{
+    const std::string action = *(first++);
+    const std::string system_name = *first;
+
+    auto monitor = _monitors.find(system_name);
+    if (monitor == _monitors.end()) {
+        const std::string error = "System '" + system_name + "' is not monitored";
+        writeError(action, error, CmdStatus::generic_error);
+        return false;
+    }
+
+    const auto statistics = monitor->second->getLogBuffer().getStatistics();
+    const Attributes attributes = {
+        {"capacity", std::to_string(statistics._capacity)},
+        {"memory_bytes", std::to_string(statistics._memory_size)},
+        {"records_written", std::to_string(statistics._written)},
+        {"records_stored", std::to_string(statistics._stored)},
+        {"records_overwritten", std::to_string(statistics._overwritten)},
+        {"records_truncated", std::to_string(statistics._truncated)}};
+    if (_json_mode) {
+        writeNotes(action, attributes);
+    }
+    else {
+        for (const auto& attribute: attributes) {
+            writeNote(action, attribute);
+        }
+    }
+    return true;
+}
+
+bool FepControl::getLogLatency(TokenIterator first, TokenIterator last)
+{
+    const std::string action = *(first++);
+    const std::string system_name = *first;
+
+    auto monitor = _monitors.find(system_name);
+    if (monitor == _monitors.end()) {
+        const std::string error = "System '" + system_name + "' is not monitored";
+        writeError(action, error, CmdStatus::generic_error);
+        return false;
+    }
+
+    auto& latency = monitor->second->getLogLatency();
+    const auto snapshot = latency.getSnapshot();
+    if (getOption(first, last, "--reset")) {
+        latency.reset();
+    }
+    const std::int64_t mean =
+        snapshot._count == 0u ? 0 : snapshot._sum / static_cast<std::int64_t>(snapshot._count);
+    std::size_t used_buckets = 0u;
+    for (const auto count: snapshot._buckets) {
+        used_buckets += count == 0u ? 0u : 1u;
+    }
+
+    if (_json_mode) {
+        auto& writer = beginEnvelope(beginMessage(), action);
+        writer.beginObject(8u);
+        writer.key("count");
+        writer.value(static_cast<std::int64_t>(snapshot._count));
+        writer.key("min_ms");
+        writer.value(snapshot._min);
+        writer.key("mean_ms");
+        writer.value(mean);
+        writer.key("p50_ms");
+        writer.value(snapshot.getPercentile(50.0));
+        writer.key("p90_ms");
+        writer.value(snapshot.getPercentile(90.0));
+        writer.key("p99_ms");
+        writer.value(snapshot.getPercentile(99.0));
+        writer.key("max_ms");
+        writer.value(snapshot._max);
+        writer.key("buckets");
+        writer.beginArray(used_buckets);
+        for (std::size_t bucket = 0u; bucket < LatencyHistogram::bucket_count; ++bucket) {
+            if (snapshot._buckets[bucket] == 0u) {
+                continue;
+            }
+            // the last bucket has no upper bound
+            const std::int64_t upper_bound = LatencyHistogram::getUpperBound(bucket);
+            writer.beginObject(2u);
+            writer.key("count");
+            writer.value(static_cast<std::int64_t>(snapshot._buckets[bucket]));
+            writer.key("upper_bound_ms");
+            if (upper_bound < 0) {
+                writer.nullValue();
+            }
+            else {
+                writer.value(upper_bound);
+            }
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.endObject();
+        writer.endObject();
+        writeMessage(writer);
+    }
+    else {
+        std::string output;
+        formatOutput(output, "count: ", snapshot._count, ", min: ", snapshot._min,
+                     " ms, mean: ", mean, " ms, p50: ", snapshot.getPercentile(50.0),
+                     " ms, p90: ", snapshot.getPercentile(90.0),
+                     " ms, p99: ", snapshot.getPercentile(99.0), " ms, max: ", snapshot._max,
+                     " ms\n");
+        for (std::size_t bucket = 0u; bucket < LatencyHistogram::bucket_count; ++bucket) {
+            if (snapshot._buckets[bucket] == 0u) {
+                continue;
+            }
+            const std::int64_t upper_bound = LatencyHistogram::getUpperBound(bucket);
+            if (upper_bound < 0) {
+                appendOutput(output, "    >= ");
+                appendOutput(output, LatencyHistogram::getUpperBound(bucket - 1u));
+            }
+            else {
+                appendOutput(output, "    < ");
+                appendOutput(output, upper_bound);
+            }
+            appendOutput(output, " ms: ");
+            appendOutput(output, snapshot._buckets[bucket]);
+            appendOutput(output, "\n");
+        }
+        writeOutput(output);
+    }
+    return true;
+}
+
+bool FepControl::logStats(TokenIterator first, TokenIterator last)
+{
+    const std::string action = *(first++);
+    const std::string system_name = *first;
+
+    auto monitor = _monitors.find(system_name);
+    if (monitor == _monitors.end()) {
+        const std::string error = "System '" + system_name + "' is not monitored";
+        writeError(action, error, CmdStatus::generic_error);
+        return false;
+    }
+
+    auto& statistics = monitor->second->getLogStatistics();
+    const auto snapshot = statistics.getSnapshot();
+    if (getOption(first, last, "--reset")) {
+        statistics.reset();
+    }
+
+    if (_json_mode) {
+        auto& writer = beginEnvelope(beginMessage(), action);
+        writer.beginObject(2u);
+        writer.key("counters");
+        writer.beginArray(snapshot._counters.size());
+        for (const auto& counters: snapshot._counters) {
+            writer.beginObject(6u);
+            writer.key("participant_name");
+            writer.value(counters._participant_name);
+            writer.key("logger_name");
+            writer.value(counters._logger_name);
+            writer.key("severity_level");
+            writer.value(getString(counters._severity));
+            writer.key("count");
+            writer.value(static_cast<std::int64_t>(counters._count));
+            writer.key("bytes");
+            writer.value(static_cast<std::int64_t>(counters._bytes));
+            writer.key("last_seen_ms");
+            writer.value(static_cast<std::int64_t>(counters._last_seen.count()));
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.key("overflow");
+        writer.value(static_cast<std::int64_t>(snapshot._overflow));
+        writer.endObject();
+        writer.endObject();
+        writeMessage(writer);
+    }
+    else if (snapshot._counters.empty() && snapshot._overflow == 0u) {
+        writeOutput("no log messages\n");
+    }
+    else {
+        const std::array<std::string, 6u> header = {
+            "participant", "logger", "severity", "count", "bytes", "last seen ms"};
+        std::vector<std::array<std::string, 6u>> rows = {header};
+        for (const auto& counters: snapshot._counters) {
+            rows.push_back({counters._participant_name,
+                            counters._logger_name,
+                            getString(counters._severity),
+                            std::to_string(counters._count),
+                            std::to_string(counters._bytes),
+                            std::to_string(counters._last_seen.count())});
+        }
+        std::string output;
+        appendTable(output, rows, 3u);
+        if (snapshot._overflow != 0u) {
+            appendOutput(output, "messages of further loggers, not counted separately: ");
+            appendOutput(output, snapshot._overflow);
+            appendOutput(output, "\n");
+        }
+        writeOutput(output);
+    }
+    return true;
+}
+
+bool FepControl::setLogRateLimit(TokenIterator first, TokenIterator last)
+{
+    const std::string action = *(first++);
+    const std::string system_name = *first;
+    const std::string rate = *std::next(first);
+
+    auto monitor = _monitors.find(system_name);
+    if (monitor == _monitors.end()) {
+        const std::string error = "System '" + system_name + "' is not monitored";
+        writeError(action, error, CmdStatus::generic_error);
+        return false;
+    }
+
+    LogRateLimit limit;
+    std::size_t messages_per_second = 0u;
+    std::int64_t summary_interval = limit._summary_interval.count();
+    const auto burst = getOption(first, last, "--burst");
+    const auto sample = getOption(first, last, "--sample");
+    const auto interval = getOption(first, last, "--summary-interval");
+    if (!parseNumber(rate, messages_per_second)) {
+        writeError(action, "Invalid rate '" + rate + "'", CmdStatus::input_error);
+        return false;
+    }
+    if (burst && !parseNumber(*burst, limit._burst)) {
+        writeError(action, "Invalid count '" + *burst + "' for --burst", CmdStatus::input_error);
+        return false;
+    }
+    if (sample && (!parseNumber(*sample, limit._sample_every) || limit._sample_every == 0u)) {
+        writeError(action, "Invalid count '" + *sample + "' for --sample", CmdStatus::input_error);
+        return false;
+    }
+    if (interval && (!parseNumber(*interval, summary_interval) || summary_interval <= 0)) {
+        const std::string error = "Invalid time '" + *interval + "' for --summary-interval";
+        writeError(action, error, CmdStatus::input_error);
+        return false;
+    }
+    limit._rate = static_cast<double>(messages_per_second);
+    limit._summary_interval = std::chrono::milliseconds(summary_interval);
+
+    // the drops of the previous limit are reported before
+    monitor->second->writeDropSummaries(true);
+    monitor->second->getRateLimiter().setLimit(limit);
+    if (monitor->second->getRateLimiter().isLimited()) {
+        writeNote(action, "log_rate_limit: enabled");
+    }
+    else {
+        writeNote(action, "log_rate_limit: disabled");
+    }
+    return true;
+}
+
+bool FepControl::getLogDropStatistics(TokenIterator first, TokenIterator last)
+{
+    const std::string action = *(first++);
+    const std::string system_name = *first;
+
+    auto monitor = _monitors.find(system_name);
+    if (monitor == _monitors.end()) {
+        const std::string error = "System '" + system_name + "' is not monitored";
+        writeError(action, error, CmdStatus::generic_error);
+        return false;
+    }
+
+    auto& rate_limiter = monitor->second->getRateLimiter();
+    const auto counters = rate_limiter.getCounters();
+    if (getOption(first, last, "--reset")) {
+        rate_limiter.resetCounters();
+    }
+    AttributesVec attributes_vec;
+    for (const auto& participant: counters) {
+        attributes_vec.push_back(
+            {{"participant_name", participant._participant_name},
+             {"passed", std::to_string(participant._passed)},
+             {"rate_limited", std::to_string(participant._rate_limited)},
+             {"sampled_out", std::to_string(participant._sampled_out)}});
+    }
+    if (_json_mode) {
+        writeNotes(action, attributes_vec);
+    }
+    else if (attributes_vec.empty()) {
+        writeNote(action, "no messages counted, no rate limit set");
+    }
+    else {
+        for (const auto& attributes: attributes_vec) {
+            for (const auto& attribute: attributes) {
+                writeNote(action, attribute);
+            }
+        }
+    }
+    return true;
+}
+
+bool FepControl::startLogArchive(TokenIterator first, TokenIterator last)
+{
+    const std::string action = *(first++);
+    const std::string system_name = *first;
+    const std::string directory = *std::next(first);
+
+    auto monitor = _monitors.find(system_name);
+    if (monitor == _monitors.end()) {
+        const std::string error = "System '" + system_name + "' is not monitored";
+        writeError(action, error, CmdStatus::generic_error);
+        return false;
+    }
+
+    std::size_t segment_size = LogArchiveWriter::default_segment_size / (1024u * 1024u);
+    const auto size = getOption(first, last, "--segment-size");
+    if (size && (!parseNumber(*size, segment_size) || segment_size == 0u || segment_size > 1024u)) {
+        const std::string error = "Invalid size '" + *size + "' for --segment-size, use 1 to 1024";
+        writeError(action, error, CmdStatus::input_error);
+        return false;
+    }
+
+    // the previous archive of the system is replaced only if the new one could be started
+    auto previous_archive = monitor->second->getArchive();
+    std::shared_ptr<LogArchiveWriter> archive;
+    try {
+        if (previous_archive && previous_archive->getDirectory() == directory) {
+            // two writers of one directory would number their segments alike, so the previous
+            // one writes its index before the new one starts
+            monitor->second->setArchive(nullptr);
+            previous_archive.reset();
+        }
+        archive = std::make_shared<LogArchiveWriter>(directory, segment_size * 1024u * 1024u);
+    }
+    catch (const std::runtime_error& e) {
+        writeException(action, "Cannot start the log archive", CmdStatus::generic_error, e);
+        return false;
+    }
+    monitor->second->setArchive(std::move(archive));
+    writeNote(action, "log_archive: enabled");
+    return true;
+}
+
+bool FepControl::stopLogArchive(TokenIterator first, TokenIterator)
+{
+    const std::string action = *(first++);
+    const std::string system_name = *first;
+
+    auto monitor = _monitors.find(system_name);
+    if (monitor == _monitors.end()) {
+        const std::string error = "System '" + system_name + "' is not monitored";
+        writeError(action, error, CmdStatus::generic_error);
+        return false;
+    }
+
+    auto archive = monitor->second->getArchive();
+    if (!archive) {
+        const std::string error = "The log messages of system '" + system_name +
+                                  "' are not archived";
+        writeError(action, error, CmdStatus::generic_error);
+        return false;
+    }
+    monitor->second->setArchive(nullptr);
+    // the statistics are complete after the remaining records are written
+    archive->flush();
+    const std::string directory = archive->getDirectory();
+    const auto statistics = archive->getStatistics();
+    const Attributes attributes = {{"log_archive", "disabled"},
+                                   {"directory", directory},
+                                   {"records_written", std::to_string(statistics._written)},
+                                   {"records_dropped", std::to_string(statistics._dropped)},
+                                   {"segments", std::to_string(statistics._segments)},
+                                   {"bytes", std::to_string(statistics._bytes)}};
+    if (_json_mode) {
+        writeNotes(action, attributes);
+    }
+    else {
+        for (const auto& attribute: attributes) {
+            writeNote(action, attribute);
+        }
+    }
+    return true;
+}
+
+bool FepControl::queryLogArchive(TokenIterator first, TokenIterator last)
+{
+    const std::string action = *(first++);
+    const std::string directory = *first;
+
+    LogArchiveQuery query;
+    const auto since = getOption(first, last, "--since");
+    const auto until = getOption(first, last, "--until");
+    const auto participant = getOption(first, last, "--participant");
+    const auto limit = getOption(first, last, "--limit");
+    std::int64_t since_ms = 0, until_ms = 0;
+    if (since && !parseNumber(*since, since_ms)) {
+        writeError(action, "Invalid time '" + *since + "' for --since", CmdStatus::input_error);
+        return false;
+    }
+    if (until && !parseNumber(*until, until_ms)) {
+        writeError(action, "Invalid time '" + *until + "' for --until", CmdStatus::input_error);
+        return false;
+    }
+    if (limit && !parseNumber(*limit, query._limit)) {
+        writeError(action, "Invalid count '" + *limit + "' for --limit", CmdStatus::input_error);
+        return false;
+    }
+    if (since) {
+        query._since = std::chrono::milliseconds(since_ms);
+    }
+    if (until) {
+        query._until = std::chrono::milliseconds(until_ms);
+    }
+    query._participant_name = participant;
+
+    std::vector<LogRecord> records;
+    try {
+        records = ::queryLogArchive(directory, query);
+    }
+    catch (const std::runtime_error& e) {
+        writeException(action, "Cannot read the log archive", CmdStatus::generic_error, e);
+        return false;
+    }
+    writeLogRecords(action, records);
+    return true;
+}
+
+bool FepControl::doParticipantStateChange(
+    TokenIterator& first,
+    std::function<void(fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine>&)> change_state,
+    const std::string& action,
+    const std::string& message_1,
+    const std::string& message_2)
+{
+    // replay mode serves the state machine calls without any system
+    const bool replaying = _rpc_recorder.isReplaying();
+    auto it = _connected_or_discovered_systems.end();
+    if (!replaying) {
+        it = getConnectedOrDiscoveredSystem(*first, _auto_discovery_of_systems, action);
+        if (it == _connected_or_discovered_systems.end()) {
+            return false;
+        }
+    }
+    std::string partname = "";
+    try {
+        partname = *std::next(first);
+        fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine> state_machine;
+        if (!replaying) {
+            auto part = it->second.getParticipant(partname);
+            if (!part) {
+                const std::string error =
+                    "participant '" + partname + "' is not in system '" + *first + "'";
+                writeError(action, error, CmdStatus::statechange_error);
+                return false;
+            }
+            state_machine = part.getRPCComponentProxy<fep3::rpc::IRPCParticipantStateMachine>();
+            if (!state_machine) {
+                const std::string error =
+                    "participant '" + partname + "@" + *first + "' has no state machine";
+                writeError(action, error, CmdStatus::statechange_error);
+                return false;
+            }
+        }
+        _rpc_recorder.exchange(*first, partname, "participant_statemachine", message_1, "", [&]() {
+            change_state(state_machine);
+        });
+
+        if (!replaying) {
+            // this updates for completion
+            std::lock_guard<std::mutex> lck(_systems_mutex);
+            _last_system_name_used = it->first;
+        }
+    }
+    catch (const std::exception& e) {
+        const std::string exception =
+            "cannot " + message_1 + " participant '" + partname + "@" + *first + "'";
+        writeException(action, exception, CmdStatus::statechange_error, e);
+        return false;
+    }
+    const std::string note = partname + "@" + *first + " " + message_2;
+    writeNote(action, note);
+    return true;
+}
+
+bool FepControl::loadParticipant(TokenIterator first, TokenIterator)
+{
+    const std::string action = *(first++);
+    return doParticipantStateChange(
+        first,
+        [](fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine>& part) { part->load(); },
+        action,
+        "load",
+        "loaded");
+}
+bool FepControl::unloadParticipant(TokenIterator first, TokenIterator)
+{
+    const std::string action = *(first++);
+    return doParticipantStateChange(
+        first,
+        [](fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine>& part) { part->unload(); },
+        action,
+        "unload",
+        "unloaded");
+}
+
+bool FepControl::initializeParticipant(TokenIterator first, TokenIterator)
+{
+    const std::string action = *(first++);
+    return doParticipantStateChange(
+        first,
+        [](fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine>& part) {
+            part->initialize();
         },
         action,
         "initialize",
@@ -811,9 +1868,12 @@ bool FepControl::getParticipants(TokenIterator first, TokenIterator)
 bool FepControl::quit(TokenIterator first, TokenIterator)
 {
     const std::string action = *(first);
+    stopLogOutput();
+    saveCompletions();
     writeNote(action, "bye bye");
     // we clear that here before any static variable is closed
     _connected_or_discovered_systems.clear();
+    flushOutput();
     exit(0);
 }
 
@@ -921,32 +1981,90 @@ bool FepControl::disableAutoDiscovery(TokenIterator first, TokenIterator)
 bool FepControl::enableJsonMode(TokenIterator first, TokenIterator)
 {
     _json_mode = true;
-    monitor.setJsonMode(true);
+    setMonitorsJsonMode(true);
     writeNote(*first, "json_mode: enabled");
     return true;
 }
 
 bool FepControl::disableJsonMode(TokenIterator first, TokenIterator)
 {
+    // batches are json messages only
+    stopLogBatching();
     _json_mode = false;
-    monitor.setJsonMode(false);
+    _binary_format = BinaryFormat::none;
+    setMonitorsJsonMode(false);
     writeNote(*first, "json_mode: disabled");
     return true;
 }
 
+bool FepControl::enableBinaryMode(TokenIterator first, TokenIterator)
+{
+    const std::string action = *(first++);
+    BinaryFormat binary_format;
+    if (!parseBinaryFormat(*first, binary_format)) {
+        const std::string error =
+            "Invalid binary format '" + *first + "', use 'msgpack' or 'cbor'";
+        writeError(action, error, CmdStatus::input_error);
+        return false;
+    }
+
+    // the binary messages have the same structure as the json ones
+    _json_mode = true;
+    _binary_format = binary_format;
+    setMonitorsJsonMode(true);
+    writeNote(action, std::string("binary_mode: ") + getString(binary_format));
+    return true;
+}
+
+bool FepControl::disableBinaryMode(TokenIterator first, TokenIterator)
+{
+    _binary_format = BinaryFormat::none;
+    writeNote(*first, "binary_mode: disabled");
+    return true;
+}
+
+bool FepControl::enableLogBatching(TokenIterator first, TokenIterator)
+{
+    const std::string action = *(first++);
+    std::size_t max_records = 0u;
+    std::int64_t max_latency = 0;
+    if (!parseNumber(*first, max_records) || max_records == 0u) {
+        writeError(action, "Invalid count of messages '" + *first + "'", CmdStatus::input_error);
+        return false;
+    }
+    ++first;
+    if (!parseNumber(*first, max_latency) || max_latency <= 0) {
+        writeError(action, "Invalid latency '" + *first + "'", CmdStatus::input_error);
+        return false;
+    }
+
+    _log_batcher.start(max_records, std::chrono::milliseconds(max_latency));
+    writeNote(action, "log_batching: enabled");
+    return true;
+}
+
+bool FepControl::disableLogBatching(TokenIterator first, TokenIterator)
+{
+    stopLogBatching();
+    writeNote(*first, "log_batching: disabled");
+    return true;
+}
+
 bool FepControl::getParticipantState(TokenIterator first, TokenIterator)
 {
     const std::string action = *(first++);
     const std::string system_name = *(first);
     const std::string participant_name = *std::next(first);
-    auto part = getParticipant(action, system_name, participant_name);
+    auto part = getParticipant(action, system_name, participant_name, true);
 
-    if (part) {
+    if (part || _rpc_recorder.isReplaying()) {
         try {
-            auto state_machine =
-                part->getRPCComponentProxy<fep3::rpc::IRPCParticipantStateMachine>();
-            if (state_machine) {
-                auto value = state_machine->getState();
+            fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine> state_machine;
+            if (getRPCComponent(part, state_machine)) {
+                auto value = _rpc_recorder.exchange(
+                    system_name, participant_name, "participant_statemachine", "getState", "", [&]() {
+                        return state_machine->getState();
+                    });
                 const Attributes attributes{
                     std::make_pair("stateID", std::to_string(value)),
                     std::make_pair("stateName", resolveSystemState(value)),
@@ -1017,8 +2135,71 @@ bool FepControl::setParticipantState(TokenIterator first, TokenIterator last)
     }
 }
 
+// configuration of a participant, every call passes the RPC recorder of the session
+class RecordedConfiguration {
+public:
+    RecordedConfiguration(RPCRecorder& recorder,
+                          const std::string& system_name,
+                          const std::string& participant_name,
+                          fep3::RPCComponent<fep3::rpc::IRPCConfiguration> conf)
+        : _recorder(recorder),
+          _system_name(system_name),
+          _participant_name(participant_name),
+          _conf(std::move(conf))
+    {
+    }
+
+    std::vector<std::string> getPropertyNames(const std::string& node)
+    {
+        return call("getPropertyNames", node, [&]() {
+            return _conf->getProperties(node)->getPropertyNames();
+        });
+    }
+
+    std::string getProperty(const std::string& node, const std::string& name)
+    {
+        return call("getProperty", node + "/" + name, [&]() {
+            return _conf->getProperties(node)->getProperty(name);
+        });
+    }
+
+    std::string getPropertyType(const std::string& node, const std::string& name)
+    {
+        return call("getPropertyType", node + "/" + name, [&]() {
+            return _conf->getProperties(node)->getPropertyType(name);
+        });
+    }
+
+    // returns false if the node does not exist
+    bool setProperty(const std::string& node, const std::string& name, const std::string& value)
+    {
+        return call("setProperty", node + "/" + name + "=" + value, [&]() {
+            auto prop = _conf->getProperties(node);
+            if (!prop) {
+                return false;
+            }
+            prop->setProperty(name, value, prop->getPropertyType(name));
+            return true;
+        });
+    }
+
+private:
+    template <typename Call>
+    auto call(const std::string& method, const std::string& request, Call&& live_call)
+        -> decltype(live_call())
+    {
+        return _recorder.exchange(
+            _system_name, _participant_name, "configuration", method, request, live_call);
+    }
+
+    RPCRecorder& _recorder;
+    const std::string _system_name;
+    const std::string _participant_name;
+    fep3::RPCComponent<fep3::rpc::IRPCConfiguration> _conf;
+};
+
 template <typename T>
-void traverseProperties(fep3::RPCComponent<fep3::rpc::IRPCConfiguration> conf,
+void traverseProperties(RecordedConfiguration& conf,
                         const std::string& node,
                         const std::string& prop_name,
                         std::function<T*(const std::string& name,
@@ -1031,9 +2212,8 @@ void traverseProperties(fep3::RPCComponent<fep3::rpc::IRPCConfiguration> conf,
 {
     T* result_user_object = user_object;
     if (depth != 0 || (!node.empty() && !prop_name.empty())) {
-        auto prop = conf->getProperties(node);
-        auto value = prop->getProperty(prop_name);
-        auto type = prop->getPropertyType(prop_name);
+        auto value = conf.getProperty(node, prop_name);
+        auto type = conf.getPropertyType(node, prop_name);
         result_user_object = callback(prop_name, value, type, depth, result_user_object);
     }
 
@@ -1042,15 +2222,14 @@ void traverseProperties(fep3::RPCComponent<fep3::rpc::IRPCConfiguration> conf,
         next_node = next_node.append("/");
     }
 
-    auto props = conf->getProperties(next_node.append(prop_name));
-    auto sub_props = props->getPropertyNames();
+    auto sub_props = conf.getPropertyNames(next_node.append(prop_name));
     for (auto sub_prop: sub_props) {
         traverseProperties<T>(conf, next_node, sub_prop, callback, result_user_object, depth + 1);
     }
 }
 
 Json::Value formatPropertyJson(const std::string& action,
-                               fep3::RPCComponent<fep3::rpc::IRPCConfiguration> conf,
+                               RecordedConfiguration& conf,
                                const std::string& node,
                                const std::string& prop_name,
                                int indent = 0)
@@ -1090,7 +2269,7 @@ Json::Value formatPropertyJson(const std::string& action,
     }
 }
 
-std::string formatProperty(fep3::RPCComponent<fep3::rpc::IRPCConfiguration> conf,
+std::string formatProperty(RecordedConfiguration& conf,
                            const std::string& node,
                            const std::string& prop_name,
                            int indent = 0)
@@ -1128,12 +2307,13 @@ bool FepControl::getParticipantPropertyNames(TokenIterator first, TokenIterator)
     const std::string system_name = *first;
     const std::string participant_name = *std::next(first);
 
-    auto part = getParticipant(action, system_name, participant_name);
+    auto part = getParticipant(action, system_name, participant_name, true);
 
-    if (part) {
+    if (part || _rpc_recorder.isReplaying()) {
         try {
-            auto conf = part->getRPCComponentProxy<fep3::rpc::IRPCConfiguration>();
-            if (conf) {
+            fep3::RPCComponent<fep3::rpc::IRPCConfiguration> rpc_conf;
+            if (getRPCComponent(part, rpc_conf)) {
+                RecordedConfiguration conf(_rpc_recorder, system_name, participant_name, rpc_conf);
                 if (_json_mode) {
                     Json::Value root;
                     root["action"] = action;
@@ -1160,7 +2340,7 @@ bool FepControl::getParticipantPropertyNames(TokenIterator first, TokenIterator)
 
                     root["value"]["participant"] = participant_name;
                     root["value"]["participant_properties"] = properties["sub_properties"];
-                    writeOutput(_builder.convertJson(root), "\n");
+                    writeJsonValue(root);
                 }
                 else {
                     std::stringstream ss;
@@ -1200,12 +2380,13 @@ bool FepControl::getParticipantProperties(TokenIterator first, TokenIterator)
     const std::string system_name = *first;
     const std::string participant_name = *std::next(first);
 
-    auto part = getParticipant(action, system_name, participant_name);
+    auto part = getParticipant(action, system_name, participant_name, true);
 
-    if (part) {
+    if (part || _rpc_recorder.isReplaying()) {
         try {
-            auto conf = part->getRPCComponentProxy<fep3::rpc::IRPCConfiguration>();
-            if (conf) {
+            fep3::RPCComponent<fep3::rpc::IRPCConfiguration> rpc_conf;
+            if (getRPCComponent(part, rpc_conf)) {
+                RecordedConfiguration conf(_rpc_recorder, system_name, participant_name, rpc_conf);
                 if (_json_mode) {
                     Json::Value participant_properties = formatPropertyJson(action, conf, "", "");
 
@@ -1216,7 +2397,7 @@ bool FepControl::getParticipantProperties(TokenIterator first, TokenIterator)
                     output["value"]["participant"] = participant_name;
                     output["value"]["participant_properties"] = participant_properties;
 
-                    writeOutput(_builder.convertJson(output), "\n");
+                    writeJsonValue(output);
                 }
                 else {
                     writeOutput(participant_name, " : ", "\n", formatProperty(conf, "", ""), "\n");
@@ -1249,12 +2430,13 @@ bool FepControl::getParticipantProperty(TokenIterator first, TokenIterator last)
     const std::string participant_name = *(++first);
     const std::string property_path = *(++first);
 
-    auto part = getParticipant(action, system_name, participant_name);
+    auto part = getParticipant(action, system_name, participant_name, true);
 
-    if (part) {
+    if (part || _rpc_recorder.isReplaying()) {
         try {
-            auto conf = part->getRPCComponentProxy<fep3::rpc::IRPCConfiguration>();
-            if (conf) {
+            fep3::RPCComponent<fep3::rpc::IRPCConfiguration> rpc_conf;
+            if (getRPCComponent(part, rpc_conf)) {
+                RecordedConfiguration conf(_rpc_recorder, system_name, participant_name, rpc_conf);
                 auto split_path = getNodeAndLeafNamefromProperty(property_path);
                 auto node = split_path.first;
                 auto leaf_name = split_path.second;
@@ -1276,17 +2458,15 @@ bool FepControl::getParticipantProperty(TokenIterator first, TokenIterator last)
                         CmdStatus::no_error);
                     output["value"]["participant"] = participant_name;
                     output["value"]["participant_property"] = participant_property;
-                    writeOutput(_builder.convertJson(output), "\n");
+                    writeJsonValue(output);
                 }
                 else {
                     writeOutput(formatProperty(conf, node, leaf_name), "\n");
                 }
 
-                // append to used props, if not used already
-                if (std::find(_used_properties.begin(), _used_properties.end(), participant_name) !=
-                    _used_properties.end()) {
-                    _used_properties.push_back(property_path);
-                }
+                // offered by the completion from now on
+                std::lock_guard<std::mutex> lck(_systems_mutex);
+                _used_properties.add(property_path);
             }
             else {
                 const std::string error = "participant '" + participant_name + "@" + system_name +
@@ -1317,24 +2497,22 @@ bool FepControl::setParticipantProperty(TokenIterator first, TokenIterator last)
     const std::string property_path = *(++first);
     std::string property_value = *(++first);
 
-    auto part = getParticipant(action, system_name, participant_name);
+    auto part = getParticipant(action, system_name, participant_name, true);
 
-    if (part) {
+    if (part || _rpc_recorder.isReplaying()) {
         try {
-            auto conf = part->getRPCComponentProxy<fep3::rpc::IRPCConfiguration>();
-            if (conf) {
+            fep3::RPCComponent<fep3::rpc::IRPCConfiguration> rpc_conf;
+            if (getRPCComponent(part, rpc_conf)) {
+                RecordedConfiguration conf(_rpc_recorder, system_name, participant_name, rpc_conf);
                 auto split_path = getNodeAndLeafNamefromProperty(property_path);
                 auto node = split_path.first;
                 auto leaf_name = split_path.second;
 
-                auto prop = conf->getProperties(node);
-                if (prop) {
-                    prop->setProperty(leaf_name, property_value, prop->getPropertyType(leaf_name));
-                    // append to used props, if not used already
-                    if (std::find(_used_properties.begin(),
-                                  _used_properties.end(),
-                                  participant_name) != _used_properties.end()) {
-                        _used_properties.push_back(property_path);
+                if (conf.setProperty(node, leaf_name, property_value)) {
+                    // offered by the completion from now on
+                    {
+                        std::lock_guard<std::mutex> lck(_systems_mutex);
+                        _used_properties.add(property_path);
                     }
                     writeNote(action, "property set");
                 }
@@ -1509,128 +2687,585 @@ bool FepControl::callRPC(TokenIterator first, TokenIterator last)
         function_arguments = *(++first);
     }
 
-    auto part = getParticipant(action, system_name, participant_name);
-
-    if (part) 
-    {
+    auto part = getParticipant(action, system_name, participant_name, true);
+
+    if (part || _rpc_recorder.isReplaying()) 
+    {
+        try {
+            // build request
+            std::string request;
+            buildRPCRequest(function_name, function_arguments, request);
+
+            // call rpc request 
+            fep3::rpc::RPCClient<fep3::rpc::experimental::IRPCPassthrough> rpc_passthrough;
+            if (!_rpc_recorder.isReplaying()) {
+                part->getRPCComponentProxy(
+                    service_name,
+                    fep3::rpc::getRPCIID<fep3::rpc::experimental::IRPCPassthrough>(),
+                    rpc_passthrough);
+            }
+
+            const std::string response = _rpc_recorder.exchange(
+                system_name, participant_name, service_name, "call", request, [&]() {
+                    std::string passthrough_response;
+                    if (!rpc_passthrough->call(request, passthrough_response)) {
+                        throw std::runtime_error("RPC call failed");
+                    }
+                    return passthrough_response;
+                });
+
+            Json::Value json_response;
+            parseJsonString(response, json_response);
+
+            Json::Value output;
+            output["action"] = action;
+            output["status"] = static_cast<typename std::underlying_type<CmdStatus>::type>(
+                CmdStatus::no_error);
+            output["value"] = json_response;
+            addRequestId(output);
+            if (_binary_format != BinaryFormat::none) {
+                writeJsonValue(output);
+            }
+            else {
+                writeOutput(output, "\n");
+            }
+        }
+        catch (const std::exception& e) {
+            const std::string exception_msg = "participant '" + participant_name + "@" + 
+                                              system_name + "' with RPC service '" + 
+                                              service_name + "' failed to execute function'" + 
+                                              function_name + "'";
+            writeException(action, exception_msg, CmdStatus::rpcobject_error, e);
+            return false;
+        }
+
+        return true;
+    }
+    else {
+        return false;
+    } 
+}
+
+void FepControl::buildRPCRequest(const std::string& request_name, 
+                                 const std::string& request_arguments, 
+                                 std::string& result)
+{
+    Json::Value request_parameters;
+    auto protocal = new jsonrpc::RpcProtocolClient();
+    parseJsonString(request_arguments, request_parameters);
+    protocal->BuildRequest(request_name, request_parameters, result, false);
+}
+
+void FepControl::parseJsonString(const std::string& json_string, Json::Value& result)
+{
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+    std::string parse_errors;
+
+    if (!json_string.empty() && 
+        !reader->parse(json_string.c_str(), 
+                       json_string.c_str() + json_string.size(), 
+                       &result, 
+                       &parse_errors))
+
+    {
+        throw std::runtime_error("JSON parameters can not be parsed: " + parse_errors);
+    }
+}
+
+boost::optional<fep3::ParticipantProxy> FepControl::getParticipant(const std::string& action, 
+                                                                   const std::string& system_name, 
+                                                                   const std::string& participant_name,
+                                                                   const bool replayable) 
+{
+    boost::optional<fep3::ParticipantProxy> participant;
+    if (replayable && _rpc_recorder.isReplaying()) {
+        return participant; // replayed commands do not contact the participant
+    }
+
+    auto it = getConnectedOrDiscoveredSystem(system_name, _auto_discovery_of_systems, action);
+    if (it == _connected_or_discovered_systems.end()) {
+        return participant; // not found, return empty value
+    }
+
+    try
+    {
+        // getParticipant always throw exception when not found
+        participant = it->second.getParticipant(participant_name);
+    }
+    catch (const std::exception& e) {
+        const std::string exception_msg = 
+            "participant '" + participant_name + 
+            "' is not in system '" + system_name + "'. " + 
+            "Is it in another system? Try to run 'discoverSystem " + 
+            system_name + "' or 'discoverAllSystems'.";
+
+        writeException(action, exception_msg, CmdStatus::generic_error, e);
+    }
+
+    return participant;
+}
+
+template <typename T>
+bool FepControl::getRPCComponent(const boost::optional<fep3::ParticipantProxy>& participant,
+                                 fep3::RPCComponent<T>& component)
+{
+    if (_rpc_recorder.isReplaying()) {
+        // the recorded responses are served without a proxy
+        return true;
+    }
+    component = participant->getRPCComponentProxy<T>();
+    return static_cast<bool>(component);
+}
+
+bool FepControl::startRPCRecording(TokenIterator first, TokenIterator)
+{
+    const std::string action = *(first++);
+    const std::string file_name = *first;
+    if (!_rpc_recorder.startRecording(file_name)) {
+        const std::string error = "cannot record RPC calls to '" + file_name + "'";
+        writeError(action, error, CmdStatus::filesystem_error);
+        return false;
+    }
+    writeNote(action, "rpc_recording: enabled");
+    return true;
+}
+
+bool FepControl::stopRPCRecording(TokenIterator first, TokenIterator)
+{
+    const auto statistics = _rpc_recorder.stopRecording();
+    const Attributes attributes{
+        std::make_pair("recorded_calls", std::to_string(statistics._exchanges)),
+        std::make_pair("call_duration_us", std::to_string(statistics._duration.count())),
+    };
+    writeNotes(*first, attributes);
+    return true;
+}
+
+bool FepControl::startRPCReplay(TokenIterator first, TokenIterator)
+{
+    const std::string action = *(first++);
+    const std::string file_name = *first;
+    try {
+        const auto exchanges = _rpc_recorder.startReplay(file_name);
+        writeNote(action, Attribute("replayed_calls", std::to_string(exchanges)));
+    }
+    catch (const std::exception& e) {
+        const std::string exception = "cannot replay RPC calls from '" + file_name + "'";
+        writeException(action, exception, CmdStatus::filesystem_error, e);
+        return false;
+    }
+    return true;
+}
+
+bool FepControl::stopRPCReplay(TokenIterator first, TokenIterator)
+{
+    _rpc_recorder.stopReplay();
+    writeNote(*first, "rpc_replay: disabled");
+    return true;
+}
+
+// the target is given by the positional arguments, the options are skipped
+// commands which cannot run concurrently with others are barriers
+CommandTarget FepControl::getCommandTarget(const std::vector<std::string>& tokens)
+{
+    const auto found_command = findCommand(tokens.front());
+    if (found_command == getControlCommands().end() ||
+        parallel_commands.count(found_command->_name) == 0u) {
+        return CommandTarget{true, "", ""};
+    }
+    const ControlCommand& command = *found_command;
+    std::vector<std::string> arguments;
+    for (std::size_t index = 1u; index < tokens.size(); ++index) {
+        if (!command._options.empty() && tokens[index].compare(0u, 2u, "--") == 0) {
+            const auto option = std::find_if(
+                command._options.begin(),
+                command._options.end(),
+                [&](const OptionHandler& option) { return option._name == tokens[index]; });
+            if (option != command._options.end() && !option->_flag) {
+                // the value of the option
+                ++index;
+            }
+            continue;
+        }
+        arguments.push_back(tokens[index]);
+    }
+
+    CommandTarget target;
+    if (arguments.empty() || command._arguments.empty() ||
+        (command._arguments[0]._completion != &FepControl::connectedSystemsCompletion &&
+         command._arguments[0]._completion != &FepControl::monitoredSystemsCompletion)) {
+        return target;
+    }
+    target._system_name = arguments[0];
+    if (arguments.size() > 1u && command._arguments.size() > 1u &&
+        command._arguments[1]._completion == &FepControl::connectedParticipantsCompletion) {
+        target._participant_name = arguments[1];
+    }
+    return target;
+}
+
+bool FepControl::source(TokenIterator first, TokenIterator last)
+{
+    const std::string action = *(first++);
+    const std::string file_name = *first;
+
+    std::size_t thread_count = WorkerPool::default_thread_count;
+    const auto threads = getOption(first, last, "--threads");
+    if (threads && (!parseNumber(*threads, thread_count) || thread_count == 0u ||
+                    thread_count > 64u)) {
+        const std::string error = "Invalid count '" + *threads + "' for --threads, use 1 to 64";
+        writeError(action, error, CmdStatus::input_error);
+        return false;
+    }
+    const bool stop_on_error = static_cast<bool>(getOption(first, last, "--stop-on-error"));
+    const bool auto_parallel = static_cast<bool>(getOption(first, last, "--auto-parallel"));
+
+    std::ifstream file(file_name);
+    if (!file) {
+        const std::string error = "Cannot open script '" + file_name + "'";
+        writeError(action, error, CmdStatus::filesystem_error);
+        return false;
+    }
+    std::vector<ScriptStep> steps;
+    std::string error;
+    if (!parseCommandScript(file, steps, error)) {
+        writeError(action, "Invalid script '" + file_name + "', " + error, CmdStatus::input_error);
+        return false;
+    }
+    // the whole script is checked before any command runs
+    for (const auto& step: steps) {
+        for (const auto& command: step._commands) {
+            const std::string location = "line " + std::to_string(command._line_number) + ": ";
+            const std::string& name = command._tokens.front();
+            if (findCommand(name) == getControlCommands().end()) {
+                error = location + "invalid command '" + name + "'";
+            }
+            else if (name == action) {
+                error = location + "scripts cannot run other scripts";
+            }
+            else if (step._kind == ScriptStep::Kind::parallel &&
+                     parallel_commands.count(name) == 0u) {
+                error = location + "'" + name + "' cannot run in a parallel block";
+            }
+            else if (findCommand(name)->_action == &FepControl::quit) {
+                error = location + "scripts cannot quit the session";
+            }
+            else if (findCommand(name)->_action == &FepControl::job) {
+                // the script has the session for itself, so its jobs would wait for it
+                error = location + "scripts cannot run jobs";
+            }
+            if (!error.empty()) {
+                writeError(
+                    action, "Invalid script '" + file_name + "', " + error, CmdStatus::input_error);
+                return false;
+            }
+        }
+    }
+
+    std::atomic<std::size_t> command_count{0u};
+    std::atomic<std::size_t> failed_count{0u};
+    const auto runCommand = [this, &command_count, &failed_count](const ScriptCommand& command) {
+        int result = 0;
         try {
-            // build request
-            std::string request, response;
-            buildRPCRequest(function_name, function_arguments, request);
-
-            // call rpc request 
-            fep3::rpc::RPCClient<fep3::rpc::experimental::IRPCPassthrough> rpc_passthrough;
-            part->getRPCComponentProxy(service_name, 
-                                       fep3::rpc::getRPCIID<fep3::rpc::experimental::IRPCPassthrough>(), 
-                                       rpc_passthrough);
-
-            if (rpc_passthrough->call(request, response))
-            {
-                Json::Value json_response;
-                parseJsonString(response, json_response);
-
-                Json::Value output;
-                output["action"] = action;
-                output["status"] = static_cast<typename std::underlying_type<CmdStatus>::type>(
-                    CmdStatus::no_error);
-                output["value"] = json_response;
-                writeOutput(output, "\n");
+            result = processCommandline(command._tokens);
+        }
+        catch (const std::exception& e) {
+            writeError(command._tokens.front(), e.what(), CmdStatus::generic_error, "");
+            result = 1;
+        }
+        ++command_count;
+        if (result != 0) {
+            ++failed_count;
+        }
+    };
+    // the commands run by the workers write like source itself: with the id of its request, and
+    // their output goes where the output of source goes, e.g. into the one answer frame of a
+    // chained command line
+    const Json::Value* const source_request_id = request_id;
+    auto* const source_capture = captured_output;
+    const auto runOnWorker = [&runCommand, source_request_id](const ScriptCommand& command,
+                                                              std::vector<std::string>& outputs) {
+        request_id = source_request_id;
+        captured_output = &outputs;
+        runCommand(command);
+        captured_output = nullptr;
+        request_id = nullptr;
+    };
+    // called with the output mutex locked
+    const auto forwardOutput = [this, source_capture](std::vector<std::string>& outputs) {
+        for (auto& output: outputs) {
+            if (source_capture != nullptr) {
+                source_capture->push_back(std::move(output));
             }
-            else
-            {
-                throw std::runtime_error("RPC call failed");
+            else {
+                writeOutputToSink(output);
             }
         }
-        catch (const std::exception& e) {
-            const std::string exception_msg = "participant '" + participant_name + "@" + 
-                                              system_name + "' with RPC service '" + 
-                                              service_name + "' failed to execute function'" + 
-                                              function_name + "'";
-            writeException(action, exception_msg, CmdStatus::rpcobject_error, e);
-            return false;
+        std::vector<std::string>().swap(outputs);
+    };
+    std::mutex output_mutex;
+    if (auto_parallel) {
+        // a node per command and per 'wait', the blocks only group commands
+        std::vector<const ScriptCommand*> commands;
+        ScriptGraph graph;
+        for (const auto& step: steps) {
+            if (step._kind == ScriptStep::Kind::wait) {
+                commands.push_back(nullptr);
+                graph.add(CommandTarget{true, "", ""});
+                continue;
+            }
+            for (const auto& command: step._commands) {
+                commands.push_back(&command);
+                graph.add(getCommandTarget(command._tokens));
+            }
         }
 
-        return true;
+        // the output of each command is kept until the commands before it are done
+        std::vector<std::vector<std::string>> outputs(commands.size());
+        std::vector<bool> done(commands.size(), false);
+        std::size_t next_output = 0u;
+        WorkerPool workers(thread_count);
+        graph.run(workers, [&](std::size_t index) {
+            if (commands[index] != nullptr && !(stop_on_error && failed_count > 0u)) {
+                runOnWorker(*commands[index], outputs[index]);
+            }
+            std::lock_guard<std::mutex> lck(output_mutex);
+            done[index] = true;
+            for (; next_output < done.size() && done[next_output]; ++next_output) {
+                forwardOutput(outputs[next_output]);
+            }
+        });
     }
     else {
-        return false;
-    } 
+        WorkerPool workers(thread_count);
+        for (const auto& step: steps) {
+            if (step._kind != ScriptStep::Kind::parallel) {
+                workers.wait();
+            }
+            if (stop_on_error && failed_count > 0u) {
+                break;
+            }
+            if (step._kind == ScriptStep::Kind::command) {
+                runCommand(step._commands.front());
+            }
+            else if (step._kind == ScriptStep::Kind::parallel) {
+                // the output of each parallel command is written once the command is done
+                for (const auto& command: step._commands) {
+                    workers.submit([&runOnWorker, &forwardOutput, &output_mutex, &command]() {
+                        std::vector<std::string> outputs;
+                        runOnWorker(command, outputs);
+                        std::lock_guard<std::mutex> lck(output_mutex);
+                        forwardOutput(outputs);
+                    });
+                }
+            }
+        }
+        workers.wait();
+    }
+
+    const Attributes attributes = {{"commands", std::to_string(command_count)},
+                                   {"failed", std::to_string(failed_count)}};
+    if (_json_mode) {
+        writeNotes(action, attributes);
+    }
+    else {
+        for (const auto& attribute: attributes) {
+            writeNote(action, attribute);
+        }
+    }
+    return failed_count == 0u;
 }
 
-void FepControl::buildRPCRequest(const std::string& request_name, 
-                                 const std::string& request_arguments, 
-                                 std::string& result)
+JobQueue& FepControl::getJobQueue()
 {
-    Json::Value request_parameters;
-    auto protocal = new jsonrpc::RpcProtocolClient();
-    parseJsonString(request_arguments, request_parameters);
-    protocal->BuildRequest(request_name, request_parameters, result, false);
+    std::lock_guard<std::mutex> lck(_jobs_mutex);
+    if (!_jobs) {
+        _jobs = std::make_unique<JobQueue>([this](const JobInfo& job) { writeJobEvent(job); });
+    }
+    return *_jobs;
 }
 
-void FepControl::parseJsonString(const std::string& json_string, Json::Value& result)
+void FepControl::writeJob(const std::string& action, const JobInfo& job)
 {
-    Json::CharReaderBuilder builder;
-    std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
-    std::string parse_errors;
+    if (_json_mode) {
+        auto& writer = beginEnvelope(beginMessage(), action);
+        writeJobValue(writer, job);
+        writer.endObject();
+        writeMessage(writer);
+        return;
+    }
+    if (hasEnded(job) && job._state != JobInfo::State::cancelled) {
+        writeOutput("job ", job._id, " ", getJobStateName(job._state), ", result ", job._result,
+                    " after ", job._duration.count(), " us: ", job._command_line, "\n");
+    }
+    else {
+        writeOutput(
+            "job ", job._id, " ", getJobStateName(job._state), ": ", job._command_line, "\n");
+    }
+}
 
-    if (!json_string.empty() && 
-        !reader->parse(json_string.c_str(), 
-                       json_string.c_str() + json_string.size(), 
-                       &result, 
-                       &parse_errors))
+// the events carry the id of the request which started the job
+void FepControl::writeJobEvent(const JobInfo& job)
+{
+    std::lock_guard<std::mutex> lck(_jobs_mutex);
+    const auto id = _job_request_ids.find(job._id);
+    request_id = id != _job_request_ids.end() ? &id->second : nullptr;
+    writeJob("jobEvent", job);
+    request_id = nullptr;
+    if (hasEnded(job) && id != _job_request_ids.end()) {
+        _job_request_ids.erase(id);
+    }
+}
 
-    {
-        throw std::runtime_error("JSON parameters can not be parsed: " + parse_errors);
+bool FepControl::startJob(const std::string& action, const std::vector<std::string>& command_line)
+{
+    const auto command = findCommand(command_line.front());
+    if (command == getControlCommands().end()) {
+        writeError(action,
+                   "Invalid command '" + command_line.front() + "', use 'help' for valid commands",
+                   CmdStatus::input_error);
+        return false;
+    }
+    if (command->_action == &FepControl::job || command->_action == &FepControl::jobs ||
+        command->_action == &FepControl::quit) {
+        writeError(action, "'" + command->_name + "' cannot run as job", CmdStatus::input_error);
+        return false;
     }
+    std::string text;
+    for (const auto& token: command_line) {
+        text += text.empty() ? token : " " + token;
+    }
+    const Json::Value id = request_id != nullptr ? *request_id : Json::Value();
+
+    JobQueue& job_queue = getJobQueue();
+    // the events of the job wait until it is answered
+    std::lock_guard<std::mutex> lck(_jobs_mutex);
+    const std::uint64_t job_id =
+        job_queue.run(getCommandTarget(command_line), text, [this, command_line, id]() {
+            request_id = id.isNull() ? nullptr : &id;
+            const int result = runSessionCommand(command_line);
+            request_id = nullptr;
+            return result;
+        });
+    if (!id.isNull()) {
+        _job_request_ids[job_id] = id;
+    }
+    const auto job = job_queue.getJob(job_id);
+    writeJob(action, job ? *job : JobInfo{job_id, text});
+    return true;
 }
 
-boost::optional<fep3::ParticipantProxy> FepControl::getParticipant(const std::string& action, 
-                                                                   const std::string& system_name, 
-                                                                   const std::string& participant_name) 
+bool FepControl::job(TokenIterator first, TokenIterator last)
 {
-    boost::optional<fep3::ParticipantProxy> participant;
-    auto it = getConnectedOrDiscoveredSystem(system_name, _auto_discovery_of_systems, action);
-    if (it == _connected_or_discovered_systems.end()) {
-        return participant; // not found, return empty value
+    const std::string action = *(first++);
+    const std::string job_action = *(first++);
+    if (job_action == "run") {
+        return startJob(action, std::vector<std::string>(first, last));
+    }
+    std::uint64_t id = 0u;
+    if (job_action != "status" && job_action != "wait" && job_action != "cancel") {
+        writeError(action,
+                   "Invalid job action '" + job_action + "', use run, status, wait or cancel",
+                   CmdStatus::input_error);
+        return false;
+    }
+    if (std::next(first) != last || !parseNumber(*first, id)) {
+        writeError(action, "Invalid job id '" + *first + "'", CmdStatus::input_error);
+        return false;
     }
 
-    try
-    {
-        // getParticipant always throw exception when not found
-        participant = it->second.getParticipant(participant_name);
+    JobQueue& job_queue = getJobQueue();
+    boost::optional<JobInfo> job;
+    if (job_action == "status") {
+        job = job_queue.getJob(id);
     }
-    catch (const std::exception& e) {
-        const std::string exception_msg = 
-            "participant '" + participant_name + 
-            "' is not in system '" + system_name + "'. " + 
-            "Is it in another system? Try to run 'discoverSystem " + 
-            system_name + "' or 'discoverAllSystems'.";
+    else if (job_action == "wait") {
+        job = job_queue.wait(id);
+    }
+    else {
+        job = job_queue.cancel(id);
+        if (job && job->_state != JobInfo::State::cancelled) {
+            writeError(action,
+                       "Job " + *first + " is " + getJobStateName(job->_state) +
+                           ", only queued jobs can be cancelled",
+                       CmdStatus::input_error);
+            return false;
+        }
+    }
+    if (!job) {
+        writeError(action, "Unknown job " + *first, CmdStatus::input_error);
+        return false;
+    }
+    writeJob(action, *job);
+    // 'job wait <id> && ...' continues only if the job succeeded
+    return job_action != "wait" || job->_state == JobInfo::State::done;
+}
 
-        writeException(action, exception_msg, CmdStatus::generic_error, e);
+bool FepControl::jobs(TokenIterator first, TokenIterator)
+{
+    const std::string action = *first;
+    const auto job_list = getJobQueue().getJobs();
+    if (_json_mode) {
+        auto& writer = beginEnvelope(beginMessage(), action);
+        writer.beginArray(job_list.size());
+        for (const auto& job: job_list) {
+            writeJobValue(writer, job);
+        }
+        writer.endArray();
+        writer.endObject();
+        writeMessage(writer);
+        return true;
     }
+    std::vector<std::array<std::string, 5u>> rows = {
+        {"command", "state", "job", "result", "duration us"}};
+    for (const auto& job: job_list) {
+        rows.push_back({job._command_line,
+                        getJobStateName(job._state),
+                        std::to_string(job._id),
+                        std::to_string(job._result),
+                        std::to_string(job._duration.count())});
+    }
+    std::string output;
+    appendTable(output, rows, 2u);
+    writeOutput(output);
+    return true;
+}
 
-    return participant;
+std::vector<std::string> FepControl::jobActionCompletion(const std::string& word_prefix)
+{
+    std::vector<std::string> completions;
+    for (const char* job_action: {"run", "status", "wait", "cancel"}) {
+        if (std::string(job_action).compare(0u, word_prefix.size(), word_prefix) == 0) {
+            completions.push_back(job_action);
+        }
+    }
+    return completions;
 }
 
 std::vector<ControlCommand>::const_iterator FepControl::findCommand(
     const std::string& command_candidate)
 {
-    return std::find_if(
-        getControlCommands().begin(),
-        getControlCommands().end(),
-        [&command_candidate](const ControlCommand& cmd) { return cmd._name == command_candidate; });
+    const std::size_t position =
+        indexControlCommands(getControlCommands()).find(command_candidate);
+    if (position == CommandIndex::npos) {
+        return getControlCommands().end();
+    }
+    return getControlCommands().begin() + position;
 }
 
 std::vector<std::string> FepControl::commandNameCompletion(const std::string& word_prefix)
 {
-    std::vector<std::string> completions;
-    for (const auto& cmd: getControlCommands()) {
-        const std::string& cmd_name = cmd._name;
-        if (cmd_name.compare(0u, word_prefix.size(), word_prefix) == 0) {
-            completions.push_back(cmd_name);
+    // the commands do not change, so their names are sorted once
+    static const std::vector<std::string> command_names = [this]() {
+        std::vector<std::string> names;
+        for (const auto& cmd: getControlCommands()) {
+            names.push_back(cmd._name);
         }
-    }
-    return completions;
+        std::sort(names.begin(), names.end());
+        return names;
+    }();
+    return completePrefix(command_names, word_prefix);
 }
 
 bool FepControl::help(TokenIterator first, TokenIterator last)
@@ -1659,6 +3294,16 @@ bool FepControl::help(TokenIterator first, TokenIterator last)
         for (const auto& argument: it->_arguments) {
             output << " <" << argument._description << '>';
         }
+        if (it->_variadic) {
+            output << " ...";
+        }
+        for (const auto& option: it->_options) {
+            output << " [" << option._name;
+            if (!option._flag) {
+                output << " <" << option._description << '>';
+            }
+            output << ']';
+        }
         output << " : " << it->_description << "\n";
     }
 
@@ -1677,10 +3322,18 @@ int FepControl::processCommandline(const std::vector<std::string>& command_line)
         writeError("processCommandline", error, CmdStatus::input_error);
         return -2;
     }
-    if (command_line.size() > (*it)._arguments.size() + 1u ||
-        command_line.size() < (*it)._arguments.size() + 1u - (*it)._last_optional_parameters) {
+    std::size_t argument_count = command_line.size() - 1u;
+    std::vector<std::string> arranged_command_line;
+    if (!(*it)._options.empty() &&
+        !arrangeOptions(*it, command_line, arranged_command_line, argument_count)) {
+        return -3;
+    }
+    const auto& tokens = (*it)._options.empty() ? command_line : arranged_command_line;
+
+    if ((argument_count > (*it)._arguments.size() && !(*it)._variadic) ||
+        argument_count < (*it)._arguments.size() - (*it)._last_optional_parameters) {
         std::string error = "Invalid number of arguments for '" + command_line[0] + "' (" +
-                            std::to_string(command_line.size() - 1u) + " instead of ";
+                            std::to_string(argument_count) + " instead of ";
         if ((*it)._last_optional_parameters == 0u) {
             error += std::to_string((*it)._arguments.size());
         }
@@ -1693,9 +3346,367 @@ int FepControl::processCommandline(const std::vector<std::string>& command_line)
         return -3;
     }
 
-    auto func = std::bind((*it)._action, this, command_line.begin(), command_line.end());
+    auto func = std::bind((*it)._action, this, tokens.begin(), tokens.end());
+
+    bool result = false;
+    {
+        // the commands of parallel script blocks or jobs on one system run one after another
+        std::unique_lock<std::mutex> system_lock;
+        if (argument_count > 0u &&
+            (*it)._arguments[0]._completion == &FepControl::connectedSystemsCompletion) {
+            system_lock = std::unique_lock<std::mutex>(getSystemMutex(tokens[1]));
+        }
+        result = func();
+    }
+    refreshCompletionCache((*it)._name, argument_count > 0u ? tokens[1] : std::string());
+    return result ? 0 : 1;
+}
+
+int FepControl::processLine(std::string_view line, bool batch_response)
+{
+    std::vector<ChainedCommand> commands;
+    bool command_array = false;
+    if (!parseCommands(line, commands, command_array)) {
+        return -2;
+    }
+    return runCommands(commands, batch_response && (command_array || commands.size() > 1u));
+}
+
+void FepControl::processLinePipelined(std::string_view line, CommandScheduler& scheduler)
+{
+    auto commands = std::make_shared<std::vector<ChainedCommand>>();
+    bool command_array = false;
+    std::vector<std::string> error_output;
+    auto* const former_capture = captured_output;
+    captured_output = &error_output;
+    const bool parsed = parseCommands(line, *commands, command_array);
+    captured_output = former_capture;
+    CommandTarget target{true, "", ""};
+    if (!parsed) {
+        // the error follows the answers to the lines before
+        scheduler.submit(target, [this, error_output = std::move(error_output)]() {
+            for (const auto& output: error_output) {
+                sinkOutput(output);
+            }
+        });
+        return;
+    }
+    // only a single json command with an id may overtake the commands before it
+    if (!command_array && commands->size() == 1u && !commands->front()._id.isNull()) {
+        target = getCommandTarget(commands->front()._tokens);
+    }
+    const bool batch_response = command_array || commands->size() > 1u;
+    scheduler.submit(target, [this, commands, batch_response]() {
+        runCommands(*commands, batch_response);
+    });
+}
+
+bool FepControl::parseCommands(std::string_view line,
+                               std::vector<ChainedCommand>& commands,
+                               bool& command_array)
+{
+    // the tokenizer keeps its storage from line to line
+    thread_local LineTokenizer tokenizer;
+    std::string error;
+    const auto first = line.find_first_not_of(" \t\r\n");
+    const char first_character = first != std::string_view::npos ? line[first] : '\0';
+    command_array = first_character == '[';
+    // json commands are not tokenized, their arguments are taken as they are
+    const bool parsed = command_array || first_character == '{'
+                            ? parseJsonCommands(line, commands, error)
+                            : parseCommandChain(line, tokenizer, commands, error);
+    if (!parsed) {
+        request_id = !commands.empty() && !commands.back()._id.isNull() ? &commands.back()._id
+                                                                         : nullptr;
+        writeError("processCommandline", "Invalid command line, " + error, CmdStatus::input_error);
+        request_id = nullptr;
+    }
+    return parsed;
+}
+
+int FepControl::runCommands(const std::vector<ChainedCommand>& commands, bool batch_response)
+{
+    // the answers of several commands are sent as one array, in the order of the commands
+    std::vector<std::string> outputs;
+    auto* const former_capture = captured_output;
+    if (batch_response) {
+        captured_output = &outputs;
+    }
+    int result = 0;
+    for (const auto& command: commands) {
+        if (command._after_success && result != 0) {
+            continue;
+        }
+        request_id = command._id.isNull() ? nullptr : &command._id;
+        if (command._async) {
+            // runs the command as job, the answer is the state of the job
+            std::vector<std::string> job_command_line = {"job", "run"};
+            job_command_line.insert(
+                job_command_line.end(), command._tokens.begin(), command._tokens.end());
+            result = runSessionCommand(job_command_line);
+        }
+        else {
+            result = runSessionCommand(command._tokens);
+        }
+        request_id = nullptr;
+    }
+    if (!batch_response) {
+        return result;
+    }
+    captured_output = former_capture;
+    if (!_json_mode) {
+        std::string output;
+        for (const auto& text: outputs) {
+            output += text;
+        }
+        sinkOutput(output);
+        return result;
+    }
+    auto& writer = beginMessage();
+    writer.beginArray(outputs.size());
+    for (const auto& message: outputs) {
+        writer.rawMessage(message);
+    }
+    writer.endArray();
+    writeMessage(writer);
+    return result;
+}
+
+int FepControl::runSessionCommand(const std::vector<std::string>& command_line)
+{
+    // the commands which may run concurrently share the session with the running jobs, all
+    // others have it for themselves; the job commands only start or query jobs
+    const auto command = findCommand(command_line.front());
+    const bool known_command = command != getControlCommands().end();
+    const bool job_command = known_command && (command->_action == &FepControl::job ||
+                                               command->_action == &FepControl::jobs);
+    std::shared_lock<std::shared_mutex> shared_lock(_session_mutex, std::defer_lock);
+    std::unique_lock<std::shared_mutex> exclusive_lock(_session_mutex, std::defer_lock);
+    if (known_command && parallel_commands.count(command->_name) != 0u) {
+        shared_lock.lock();
+    }
+    else if (known_command && !job_command) {
+        exclusive_lock.lock();
+    }
+    try {
+        return processCommandline(command_line);
+    }
+    catch (const std::exception& e) {
+        writeError(command_line.front(), e.what(), CmdStatus::generic_error, "");
+        return 1;
+    }
+}
+
+int FepControl::processBatch(std::istream& input, bool stop_on_error)
+{
+    struct CommandTiming {
+        std::size_t _count = 0u;
+        std::size_t _failed = 0u;
+        std::chrono::microseconds _total{0};
+        std::chrono::microseconds _max{0};
+    };
+    std::map<std::string, CommandTiming> timings;
+    std::size_t command_count = 0u;
+    std::size_t failed_count = 0u;
+    const auto batch_start = std::chrono::steady_clock::now();
+
+    std::string line;
+    LineTokenizer tokenizer;
+    std::vector<std::string> tokens;
+    while (std::getline(input, line)) {
+        tokenizer.tokenize(line, tokens);
+        if (tokens.empty()) {
+            continue;
+        }
+        // quit would exit at once, it ends the batch instead so the summary and exit code remain
+        const auto command = findCommand(tokens.front());
+        if (command != getControlCommands().end() && command->_action == &FepControl::quit) {
+            break;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        const int result = runSessionCommand(tokens);
+        const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        auto& timing = timings[tokens.front()];
+        ++timing._count;
+        timing._total += duration;
+        timing._max = std::max(timing._max, duration);
+        ++command_count;
+        if (result != 0) {
+            ++timing._failed;
+            ++failed_count;
+            if (stop_on_error) {
+                break;
+            }
+        }
+    }
+    const auto batch_duration = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - batch_start);
+
+    // the slowest commands first
+    std::vector<std::pair<std::string, CommandTiming>> sorted_timings(timings.begin(),
+                                                                      timings.end());
+    std::stable_sort(sorted_timings.begin(),
+                     sorted_timings.end(),
+                     [](const auto& left, const auto& right) {
+                         return left.second._total > right.second._total;
+                     });
+    const std::string action = "batch";
+    if (_json_mode) {
+        auto& writer = beginEnvelope(beginMessage(), action);
+        writer.beginObject(4u);
+        writer.key("commands");
+        writer.value(static_cast<std::int64_t>(command_count));
+        writer.key("failed");
+        writer.value(static_cast<std::int64_t>(failed_count));
+        writer.key("duration_us");
+        writer.value(static_cast<std::int64_t>(batch_duration.count()));
+        writer.key("timings");
+        writer.beginArray(sorted_timings.size());
+        for (const auto& timing: sorted_timings) {
+            writer.beginObject(5u);
+            writer.key("command");
+            writer.value(timing.first);
+            writer.key("count");
+            writer.value(static_cast<std::int64_t>(timing.second._count));
+            writer.key("failed");
+            writer.value(static_cast<std::int64_t>(timing.second._failed));
+            writer.key("total_us");
+            writer.value(static_cast<std::int64_t>(timing.second._total.count()));
+            writer.key("max_us");
+            writer.value(static_cast<std::int64_t>(timing.second._max.count()));
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.endObject();
+        writer.endObject();
+        writeMessage(writer);
+    }
+    else {
+        std::vector<std::array<std::string, 5u>> rows = {
+            {"command", "count", "failed", "total us", "max us"}};
+        for (const auto& timing: sorted_timings) {
+            rows.push_back({timing.first,
+                            std::to_string(timing.second._count),
+                            std::to_string(timing.second._failed),
+                            std::to_string(timing.second._total.count()),
+                            std::to_string(timing.second._max.count())});
+        }
+        std::string output;
+        appendOutput(output, "batch: ");
+        appendOutput(output, command_count);
+        appendOutput(output, " commands, ");
+        appendOutput(output, failed_count);
+        appendOutput(output, " failed, ");
+        appendOutput(output, batch_duration.count());
+        appendOutput(output, " us\n");
+        appendTable(output, rows, 1u);
+        writeOutput(output);
+    }
+    stopJobs();
+    stopLogOutput();
+    flushOutput();
+    return failed_count == 0u ? 0 : 1;
+}
+
+// the participants change by discovery and state changes, the completion cache fetches them
+// again in the background
+void FepControl::refreshCompletionCache(const std::string& command_name,
+                                        const std::string& system_name)
+{
+    static const std::set<std::string> changing_commands = {"discoverSystem",
+                                                            "loadSystem",
+                                                            "unloadSystem",
+                                                            "initializeSystem",
+                                                            "deinitializeSystem",
+                                                            "startSystem",
+                                                            "stopSystem",
+                                                            "pauseSystem",
+                                                            "shutdownSystem",
+                                                            "setSystemState",
+                                                            "loadParticipant",
+                                                            "unloadParticipant",
+                                                            "initializeParticipant",
+                                                            "deinitializeParticipant",
+                                                            "startParticipant",
+                                                            "stopParticipant",
+                                                            "pauseParticipant",
+                                                            "shutdownParticipant",
+                                                            "setParticipantState"};
+    if (!_completion_cache.isEnabled()) {
+        return;
+    }
+    std::vector<std::string> system_names;
+    if (command_name == "discoverAllSystems" || command_name == "startMonitoringAll") {
+        std::lock_guard<std::mutex> lck(_systems_mutex);
+        for (const auto& system: _connected_or_discovered_systems) {
+            system_names.push_back(system.first);
+        }
+    }
+    else if (changing_commands.count(command_name) != 0u) {
+        system_names.push_back(system_name);
+    }
+    for (const auto& name: system_names) {
+        // the cache copies the system, so it waits for the commands using the system meanwhile
+        std::lock_guard<std::mutex> system_lock(getSystemMutex(name));
+        std::lock_guard<std::mutex> lck(_systems_mutex);
+        const auto system = _connected_or_discovered_systems.find(name);
+        if (system == _connected_or_discovered_systems.end()) {
+            // e.g. shut down
+            _completion_cache.remove(name);
+        }
+        else {
+            _completion_cache.refresh(system->first, system->second);
+        }
+    }
+}
 
-    return func() ? 0 : 1;
+// moves the options behind the positional arguments as pairs of name and value
+bool FepControl::arrangeOptions(const ControlCommand& command,
+                                const std::vector<std::string>& command_line,
+                                std::vector<std::string>& arranged_command_line,
+                                std::size_t& argument_count)
+{
+    std::vector<std::string> options;
+    arranged_command_line.clear();
+    for (auto token = command_line.begin(); token != command_line.end(); ++token) {
+        if (token == command_line.begin() || token->compare(0u, 2u, "--") != 0) {
+            arranged_command_line.push_back(*token);
+            continue;
+        }
+        const auto separator = token->find('=');
+        const std::string name = token->substr(0u, separator);
+        const auto option = std::find_if(
+            command._options.begin(), command._options.end(), [&name](const OptionHandler& option) {
+                return option._name == name;
+            });
+        if (option == command._options.end()) {
+            const std::string error = "Invalid option '" + name + "' for '" + command._name +
+                                      "', use 'help " + command._name + "' for more information";
+            writeError("processCommandline", error, CmdStatus::input_error);
+            return false;
+        }
+        options.push_back(name);
+        if (option->_flag) {
+            options.push_back("true");
+        }
+        else if (separator != std::string::npos) {
+            options.push_back(token->substr(separator + 1u));
+        }
+        else if (std::next(token) != command_line.end()) {
+            options.push_back(*(++token));
+        }
+        else {
+            const std::string error =
+                "Missing value of option '" + name + "' for '" + command._name + "'";
+            writeError("processCommandline", error, CmdStatus::input_error);
+            return false;
+        }
+    }
+    argument_count = arranged_command_line.size() - 1u;
+    arranged_command_line.insert(arranged_command_line.end(), options.begin(), options.end());
+    return true;
 }
 
 std::vector<std::string> FepControl::possibleSystemsStateCompletion(const std::string& word_prefix)
@@ -1742,6 +3753,32 @@ const std::vector<ControlCommand>& FepControl::getControlCommands() const noexce
                        &FepControl::help,
                        {{"command name", &FepControl::commandNameCompletion}},
                        1u},
+        ControlCommand{"source",
+                       "runs the commands of a script file, the commands of 'parallel { }' blocks"
+                       " run concurrently until a 'wait'",
+                       &FepControl::source,
+                       {{"script file", &FepControl::localFilesCompletion}},
+                       0u,
+                       false,
+                       {{"--threads", "count of threads running parallel commands"},
+                        {"--stop-on-error", "", true},
+                        {"--auto-parallel", "", true}}},
+        ControlCommand{"job",
+                       "runs a command in the background ('run <command> ...'), or writes the"
+                       " state of a job ('status <job>'), waits for it ('wait <job>') or"
+                       " cancels it if it did not start ('cancel <job>')",
+                       &FepControl::job,
+                       {{"run, status, wait or cancel", &FepControl::jobActionCompletion},
+                        {"command or job", &FepControl::noCompletion}},
+                       0u,
+                       false,
+                       {},
+                       true},
+        ControlCommand{"jobs",
+                       "lists the jobs of the session",
+                       &FepControl::jobs,
+                       {},
+                       0u},
         ControlCommand{"loadSystem",
                        "loads the given system",
                        &FepControl::loadSystem,
@@ -1812,7 +3849,104 @@ const std::vector<ControlCommand>& FepControl::getControlCommands() const noexce
                        "monitor logging messages of the given system",
                        &FepControl::startMonitoringSystem,
                        {{"system name", &FepControl::connectedSystemsCompletion}},
+                       0u,
+                       false,
+                       {{"--min-severity", "lowest severity"},
+                        {"--participant", "participant name pattern with * and ?"},
+                        {"--logger", "logger name pattern with * and ?"},
+                        {"--regex", "regular expression searched in the message"}}},
+        ControlCommand{"startMonitoringAll",
+                       "discovers all systems and monitors the logging messages of the ones"
+                       " matching the pattern (all by default) as one stream",
+                       &FepControl::startMonitoringAll,
+                       {{"system name pattern", &FepControl::connectedSystemsCompletion}},
+                       1u,
+                       false,
+                       {{"--min-severity", "lowest severity"},
+                        {"--participant", "participant name pattern with * and ?"},
+                        {"--logger", "logger name pattern with * and ?"},
+                        {"--regex", "regular expression searched in the message"}}},
+        ControlCommand{"stopMonitoringAll",
+                       "stop monitoring the logging messages of the systems matching the pattern"
+                       " (all by default)",
+                       &FepControl::stopMonitoringAll,
+                       {{"system name pattern", &FepControl::monitoredSystemsCompletion}},
+                       1u},
+        ControlCommand{"showLogs",
+                       "shows the buffered log messages of the given monitored system",
+                       &FepControl::showLogs,
+                       {{"system name", &FepControl::monitoredSystemsCompletion}},
+                       0u,
+                       false,
+                       {{"--since", "time in ms"},
+                        {"--severity", "lowest severity"},
+                        {"--participant", "participant name"},
+                        {"--limit", "max count of messages"}}},
+        ControlCommand{"getLogBufferStatistics",
+                       "shows memory use and overwritten messages of the log buffer"
+                       " of the given monitored system",
+                       &FepControl::getLogBufferStatistics,
+                       {{"system name", &FepControl::monitoredSystemsCompletion}},
+                       0u},
+        ControlCommand{"getLogLatency",
+                       "shows a histogram of the delivery latency of the log messages"
+                       " of the given monitored system",
+                       &FepControl::getLogLatency,
+                       {{"system name", &FepControl::monitoredSystemsCompletion}},
+                       0u,
+                       false,
+                       {{"--reset", "", true}}},
+        ControlCommand{"logStats",
+                       "shows the count, size and last time of the log messages per participant,"
+                       " logger and severity of the given monitored system",
+                       &FepControl::logStats,
+                       {{"system name", &FepControl::monitoredSystemsCompletion}},
+                       0u,
+                       false,
+                       {{"--reset", "", true}}},
+        ControlCommand{"setLogRateLimit",
+                       "limits the log messages written per participant of the given monitored"
+                       " system, a rate of 0 removes the limit",
+                       &FepControl::setLogRateLimit,
+                       {{"system name", &FepControl::monitoredSystemsCompletion},
+                        {"max messages per second", &FepControl::noCompletion}},
+                       0u,
+                       false,
+                       {{"--burst", "max messages at once"},
+                        {"--sample", "write every n-th message only"},
+                        {"--summary-interval", "time in ms between drop summaries"}}},
+        ControlCommand{"getLogDropStatistics",
+                       "shows the log messages passed and dropped by the rate limit"
+                       " of the given monitored system",
+                       &FepControl::getLogDropStatistics,
+                       {{"system name", &FepControl::monitoredSystemsCompletion}},
+                       0u,
+                       false,
+                       {{"--reset", "", true}}},
+        ControlCommand{"startLogArchive",
+                       "writes the log messages of the given monitored system to segment files"
+                       " in the given directory",
+                       &FepControl::startLogArchive,
+                       {{"system name", &FepControl::monitoredSystemsCompletion},
+                        {"directory", &FepControl::localFilesCompletion}},
+                       0u,
+                       false,
+                       {{"--segment-size", "max size of a segment file in MiB"}}},
+        ControlCommand{"stopLogArchive",
+                       "stops archiving the log messages of the given monitored system",
+                       &FepControl::stopLogArchive,
+                       {{"system name", &FepControl::monitoredSystemsCompletion}},
                        0u},
+        ControlCommand{"queryLogArchive",
+                       "shows the archived log messages of the given directory",
+                       &FepControl::queryLogArchive,
+                       {{"directory", &FepControl::localFilesCompletion}},
+                       0u,
+                       false,
+                       {{"--since", "time in ms"},
+                        {"--until", "time in ms"},
+                        {"--participant", "participant name"},
+                        {"--limit", "max count of messages"}}},
         ControlCommand{"stopMonitoringSystem",
                        "stop monitoring logging messages of the given system",
                        &FepControl::stopMonitoringSystem,
@@ -1954,6 +4088,27 @@ const std::vector<ControlCommand>& FepControl::getControlCommands() const noexce
                         {"function name", &FepControl::noCompletion},
                         {"arguments", &FepControl::noCompletion}},
                         1u},
+        ControlCommand{"startRPCRecording",
+                       "records all RPC calls to participants with their timing to the given file",
+                       &FepControl::startRPCRecording,
+                       {{"file name", &FepControl::localFilesCompletion}},
+                       0u},
+        ControlCommand{"stopRPCRecording",
+                       "stops recording RPC calls",
+                       &FepControl::stopRPCRecording,
+                       {},
+                       0u},
+        ControlCommand{"startRPCReplay",
+                       "answers participant state, property and callRPC commands from a recording"
+                       " instead of the participants",
+                       &FepControl::startRPCReplay,
+                       {{"file name", &FepControl::localFilesCompletion}},
+                       0u},
+        ControlCommand{"stopRPCReplay",
+                       "stops answering commands from a RPC recording",
+                       &FepControl::stopRPCReplay,
+                       {},
+                       0u},
         ControlCommand{"configureTiming3SystemTime",
                        "configures the given system for timing"
                        " System Time (Sync only to the master)",
@@ -2001,6 +4156,32 @@ const std::vector<ControlCommand>& FepControl::getControlCommands() const noexce
                        &FepControl::disableJsonMode,
                        {},
                        0u,
+                       true},
+        ControlCommand{"enableBinary",
+                       "enable json mode with messages encoded in msgpack or cbor (hidden function)",
+                       &FepControl::enableBinaryMode,
+                       {{"format (msgpack or cbor)", &FepControl::binaryFormatCompletion}},
+                       0u,
+                       true},
+        ControlCommand{"disableBinary",
+                       "disable the binary encoding of json messages (hidden function)",
+                       &FepControl::disableBinaryMode,
+                       {},
+                       0u,
+                       true},
+        ControlCommand{"enableLogBatching",
+                       "write log messages in json mode as batches of at most the given count,"
+                       " each message is delayed at most the given latency (hidden function)",
+                       &FepControl::enableLogBatching,
+                       {{"max count of messages", &FepControl::noCompletion},
+                        {"max latency in ms", &FepControl::noCompletion}},
+                       0u,
+                       true},
+        ControlCommand{"disableLogBatching",
+                       "write each log message on its own (hidden function)",
+                       &FepControl::disableLogBatching,
+                       {},
+                       0u,
                        true}};
     return commands;
 }
@@ -20,12 +20,24 @@ You may add additional accurate notices of copyright ownership.
 
 #ifndef FEP_CONTROL_H
 #define FEP_CONTROL_H
+#include "command_script.h"
+#include "completion_cache.h"
+#include "completion_index.h"
+#include "job_queue.h"
+#include "log_batcher.h"
+#include "message_writer.h"
 #include "monitor.h"
+#include "output_buffer.h"
+#include "rpc_recorder.h"
 
+#include <atomic>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <sstream>
+#include <string_view>
 #include <vector>
 #include <boost/optional.hpp>
 
@@ -45,12 +57,23 @@ struct ArgumentHandler {
     ArgumentCompletionFunction _completion;
 };
 
+// an option is given as '--name value' or '--name=value' anywhere after the command
+struct OptionHandler {
+    std::string _name;
+    std::string _description;
+    // a flag has no value
+    bool _flag = false;
+};
+
 struct ControlCommand {
     std::string _name, _description;
     ActionFunction _action;
     std::vector<ArgumentHandler> _arguments;
     size_t _last_optional_parameters;
     bool _hidden = false;
+    std::vector<OptionHandler> _options = {};
+    // further arguments are passed on to the action, e.g. the command of a job
+    bool _variadic = false;
 };
 
 enum class CmdStatus : std::uint8_t {
@@ -72,7 +95,7 @@ enum class PriorityType : std::uint8_t {
 
 class FepControl {
 public:
-    explicit FepControl(bool json_mode);
+    explicit FepControl(bool json_mode, BinaryFormat binary_format = BinaryFormat::none);
 
     FepControl(const FepControl&) = default;
     FepControl& operator=(const FepControl&) = default;
@@ -80,33 +103,73 @@ public:
     FepControl& operator=(FepControl&&) = default;
 
     int processCommandline(const std::vector<std::string>& command_line);
+    // runs the commands of a line chained by ';' or '&&', or given as json command or array of
+    // them, returns the result of the last command run; with batch_response the answers of
+    // several commands are written as one message, a json array of the messages in json and
+    // binary mode
+    int processLine(std::string_view line, bool batch_response);
+    // runs the commands of the input line by line without prompt and writes a summary with the
+    // duration of each command, returns 0 if all commands succeeded
+    int processBatch(std::istream& input, bool stop_on_error);
     virtual void readInputFromSource() = 0;
     virtual void writeShutdownMessage() = 0;
+    // blocks until all output written so far reached the user
+    virtual void flushOutput()
+    {
+    }
     const std::vector<ControlCommand>& getControlCommands() const noexcept;
 
     template <typename... Args>
-    std::string writeOutput(Args&&... args)
+    void writeOutput(const Args&... args)
     {
         // concatenate the args to string, then send it to the user
-        std::ostringstream stream;
-        using List = int[];
-        (void)List{0, (void(stream << std::forward<Args>(args)), 0)...};
+        // the buffer is reused for every output written by the same thread
+        thread_local std::string output;
+        formatOutput(output, args...);
 
-        const std::string output = stream.str();
-
-        writeOutputToSink(output);
-
-        return output;
+        sinkOutput(output);
     }
+    // the returned writer is reused for every message written by the same thread
+    MessageWriter& beginMessage();
+    void writeMessage(MessageWriter& writer);
+    // collects the log messages of all monitors if enabled by 'enableLogBatching'
+    LogBatcher& getLogBatcher();
+    // writes the log messages of all monitors of the session as one stream
+    LogDelivery& getLogDelivery();
+    BinaryFormat getBinaryFormat() const;
 
 protected:
     ~FepControl() = default;
     std::vector<ControlCommand>::const_iterator findCommand(const std::string& command_candidate);
+    bool arrangeOptions(const ControlCommand& command,
+                        const std::vector<std::string>& command_line,
+                        std::vector<std::string>& arranged_command_line,
+                        std::size_t& argument_count);
     void writeError(const std::string& action,
                     const std::string& error,
                     const CmdStatus status,
                     const std::string& reason);
-    bool _json_mode = false;
+    void writeBinaryShutdownMessage();
+    // runs the line like processLine with batch_response on the workers of the scheduler: a json
+    // command with an id runs concurrently with the commands before it on other targets, all
+    // other lines wait for the commands before them
+    void processLinePipelined(std::string_view line, CommandScheduler& scheduler);
+    // writes the pending log messages, call this before the sink becomes unavailable
+    void stopLogBatching();
+    // stops all monitors and the batching, the log messages received before are written
+    void stopLogOutput();
+    // cancels the queued jobs and waits for the running ones
+    void stopJobs();
+    // the participants are completed from a cache refreshed in the background, the property
+    // paths used in former sessions are loaded
+    void enableCompletionCache();
+    // keeps the property paths used for the next session
+    void saveCompletions();
+    std::vector<std::string> commandNameCompletion(const std::string& word_prefix);
+    // read by the jobs writing their events while a command switches the mode
+    std::atomic<bool> _json_mode{false};
+    // if set, the json messages are encoded in this format instead
+    std::atomic<BinaryFormat> _binary_format{BinaryFormat::none};
     std::mutex _mutex_write_output;
     CompactJsonStream _builder;
 
@@ -114,19 +177,41 @@ private:
     // pure virtual methods. Must be specified in derived classes
     virtual void writeOutputToSink(const std::string& output) = 0;
     // helper and ordinary methods
-    void discoverSystemByName(const std::string& name);
+    // writes the output to the sink, unless the thread captures the output of a script command
+    void sinkOutput(const std::string& output);
+    CommandTarget getCommandTarget(const std::vector<std::string>& tokens);
+    // writes the error if the line is invalid
+    bool parseCommands(std::string_view line,
+                       std::vector<ChainedCommand>& commands,
+                       bool& command_array);
+    int runCommands(const std::vector<ChainedCommand>& commands, bool batch_response);
+    // runs the command with the session locked as the command needs it, also while jobs run
+    int runSessionCommand(const std::vector<std::string>& command_line);
+    JobQueue& getJobQueue();
+    void writeJob(const std::string& action, const JobInfo& job);
+    void writeJobEvent(const JobInfo& job);
+    bool startJob(const std::string& action, const std::vector<std::string>& command_line);
     std::map<std::string, fep3::System>::iterator getConnectedOrDiscoveredSystem(
         const std::string& name, const bool auto_discovery, const std::string& action);
+    std::mutex& getSystemMutex(const std::string& system_name);
     std::vector<std::string> usedPropertiesCompletion(const std::string& word_prefix);
     std::vector<std::string> noCompletion(const std::string&);
     std::vector<std::string> localFilesCompletion(const std::string& word_prefix);
     std::vector<std::string> connectedSystemsCompletion(const std::string& word_prefix);
     std::vector<std::string> connectedParticipantsCompletion(const std::string& word_prefix);
+    std::vector<std::string> binaryFormatCompletion(const std::string& word_prefix);
+    std::vector<std::string> jobActionCompletion(const std::string& word_prefix);
+    std::vector<std::string> monitoredSystemsCompletion(const std::string& word_prefix);
+    Monitor& getMonitor(const std::string& system_name);
+    void setMonitorsJsonMode(const bool json_mode);
+    void writeLogBatch(const std::vector<LogRecord>& records);
+    void writeLogRecords(const std::string& action, const std::vector<LogRecord>& records);
 
     void writeNote(const std::string& action, const std::string& note);
     void writeNote(const std::string& action, const Attribute& attribute);
     void writeNotes(const std::string& action, const Attributes& attributes);
     void writeNotes(const std::string& action, const AttributesVec& attributes_vec);
+    void writeJsonValue(const Json::Value& value);
 
     void writeException(const std::string& action,
                         const std::string& exception,
@@ -138,7 +223,11 @@ private:
 
     boost::optional<fep3::ParticipantProxy> getParticipant(const std::string& action, 
                                                            const std::string& system_name, 
-                                                           const std::string& participant_name);
+                                                           const std::string& participant_name,
+                                                           const bool replayable = false);
+    template <typename T>
+    bool getRPCComponent(const boost::optional<fep3::ParticipantProxy>& participant,
+                         fep3::RPCComponent<T>& component);
     void buildRPCRequest(const std::string& request_name, 
                          const std::string& request_arguments,
                          std::string& result);
@@ -173,8 +262,23 @@ private:
     bool deinitializeSystem(TokenIterator first, TokenIterator);
     bool pauseSystem(TokenIterator first, TokenIterator);
     bool shutdownSystem(TokenIterator first, TokenIterator);
-    bool startMonitoringSystem(TokenIterator first, TokenIterator);
+    bool startMonitoringSystem(TokenIterator first, TokenIterator last);
     bool stopMonitoringSystem(TokenIterator first, TokenIterator);
+    bool startMonitoringAll(TokenIterator first, TokenIterator last);
+    bool stopMonitoringAll(TokenIterator first, TokenIterator last);
+    bool getLogFilter(const std::string& action,
+                      TokenIterator first,
+                      TokenIterator last,
+                      std::shared_ptr<const LogFilter>& filter);
+    bool showLogs(TokenIterator first, TokenIterator last);
+    bool getLogBufferStatistics(TokenIterator first, TokenIterator);
+    bool getLogLatency(TokenIterator first, TokenIterator last);
+    bool logStats(TokenIterator first, TokenIterator last);
+    bool setLogRateLimit(TokenIterator first, TokenIterator last);
+    bool getLogDropStatistics(TokenIterator first, TokenIterator last);
+    bool startLogArchive(TokenIterator first, TokenIterator last);
+    bool stopLogArchive(TokenIterator first, TokenIterator);
+    bool queryLogArchive(TokenIterator first, TokenIterator last);
     bool doParticipantStateChange(
         TokenIterator& first,
         std::function<void(fep3::RPCComponent<fep3::rpc::IRPCParticipantStateMachine>&)>
@@ -203,6 +307,10 @@ private:
     bool disableAutoDiscovery(TokenIterator first, TokenIterator);
     bool enableJsonMode(TokenIterator first, TokenIterator);
     bool disableJsonMode(TokenIterator first, TokenIterator);
+    bool enableBinaryMode(TokenIterator first, TokenIterator);
+    bool disableBinaryMode(TokenIterator first, TokenIterator);
+    bool enableLogBatching(TokenIterator first, TokenIterator);
+    bool disableLogBatching(TokenIterator first, TokenIterator);
     bool getParticipantState(TokenIterator first, TokenIterator);
     bool setParticipantState(TokenIterator first, TokenIterator);
     bool getParticipantPropertyNames(TokenIterator first, TokenIterator);
@@ -213,18 +321,45 @@ private:
     bool getRPCObjectIIDSParticipant(TokenIterator first, TokenIterator);
     bool getRPCObjectDefinitionParticipant(TokenIterator first, TokenIterator);
     bool callRPC(TokenIterator first, TokenIterator last);
+    bool startRPCRecording(TokenIterator first, TokenIterator);
+    bool stopRPCRecording(TokenIterator first, TokenIterator);
+    bool startRPCReplay(TokenIterator first, TokenIterator);
+    bool stopRPCReplay(TokenIterator first, TokenIterator);
     bool help(TokenIterator first, TokenIterator last);
-    std::vector<std::string> commandNameCompletion(const std::string& word_prefix);
+    bool source(TokenIterator first, TokenIterator last);
+    bool job(TokenIterator first, TokenIterator last);
+    bool jobs(TokenIterator first, TokenIterator);
     std::vector<std::string> possibleSystemsStateCompletion(const std::string& word_prefix);
+    // refreshes the participants of the system the command changed
+    void refreshCompletionCache(const std::string& command_name, const std::string& system_name);
 
     // private member
+    LogBatcher _log_batcher;
+    // declared before the monitors, which use it until they are destroyed
+    LogDelivery _log_delivery;
+    // one monitor per system, kept after stopping the monitoring to query its log buffer
+    std::map<std::string, std::unique_ptr<Monitor>> _monitors;
     std::map<std::string, fep3::System> _connected_or_discovered_systems;
+    // guards the systems, the last used system name and the used property paths while the
+    // commands of a script run in parallel
+    std::mutex _systems_mutex;
+    // held while a command uses a system, fep3 does not state that a system may be used by
+    // several threads at once; guarded by the systems mutex, kept while another thread may
+    // wait for it
+    std::map<std::string, std::mutex> _system_mutexes;
     bool _auto_discovery_of_systems = false;
     std::string _last_system_name_used = "";
     const std::string _empty_system_name = "-";
-    std::vector<std::string> _used_properties = {
-        "clock/main_clock", "clock/step_size", "clock/time_factor"};
-    Monitor monitor;
+    // the property paths read or written, the least recently used are evicted
+    CompletionIndex _used_properties;
+    CompletionCache _completion_cache;
+    RPCRecorder _rpc_recorder;
+    // shared by the commands which may run concurrently with jobs, see runSessionCommand
+    std::shared_mutex _session_mutex;
+    // guards the job queue, created with the first job, and the ids of the requests of the jobs
+    std::mutex _jobs_mutex;
+    std::unique_ptr<JobQueue> _jobs;
+    std::map<std::uint64_t, Json::Value> _job_request_ids;
 };
 
 #endif // FEP_CONTROL_H
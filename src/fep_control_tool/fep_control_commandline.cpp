@@ -22,32 +22,21 @@ You may add additional accurate notices of copyright ownership.
 #include "control_tool_common_helper.h"
 
 #include "helper.h"
+#include "line_tokenizer.h"
 #include "linenoise_wrapper.h"
 
 #include <a_util/filesystem.h>
 #include <a_util/strings.h>
 #include <algorithm>
 #include <cctype>
-#include <iostream>
-#include <mutex>
 
-FepControlCommandLine::FepControlCommandLine(bool json_mode) : FepControl(json_mode)
+FepControlCommandLine::FepControlCommandLine(bool json_mode,
+                                             BinaryFormat binary_format,
+                                             FlushPolicy flush_policy)
+    : FepControl(json_mode, binary_format), _output_writer(flush_policy)
 {
 }
 
-std::vector<std::string> FepControlCommandLine::commandNameCompletion(
-    const std::string& word_prefix)
-{
-    std::vector<std::string> completions;
-    for (const auto& cmd: getControlCommands()) {
-        const std::string& cmd_name = cmd._name;
-        if (cmd_name.compare(0u, word_prefix.size(), word_prefix) == 0) {
-            completions.push_back(cmd_name);
-        }
-    }
-    return completions;
-}
-
 std::vector<std::string> FepControlCommandLine::commandCompletion(const std::string& input)
 {
     std::vector<std::string> input_tokens = parseLine(input, true);
@@ -59,24 +48,50 @@ std::vector<std::string> FepControlCommandLine::commandCompletion(const std::str
     else {
         auto it = findCommand(input_tokens[0]);
         if (it != getControlCommands().end()) {
-            size_t index_in_args = input_tokens.size() - 2u;
-            if (index_in_args < (*it)._arguments.size()) {
-                auto completion_list = std::bind(
-                    (*it)._arguments[index_in_args]._completion, this, input_tokens.back());
-                auto exec = completion_list();
-                if (!exec.empty()) {
-                    input_tokens.pop_back();
-                    for (auto token_it = input_tokens.begin(); token_it != input_tokens.end(); ++token_it)
-                    {
-                        *token_it = quoteNameIfNecessary(*token_it);
+            // options and their values do not count as arguments
+            size_t index_in_args = 0u;
+            for (size_t index = 1u; index + 1u < input_tokens.size(); ++index) {
+                if (!(*it)._options.empty() && input_tokens[index].compare(0u, 2u, "--") == 0) {
+                    const auto flag = std::find_if(
+                        (*it)._options.begin(),
+                        (*it)._options.end(),
+                        [&](const OptionHandler& option) {
+                            return option._flag && option._name == input_tokens[index];
+                        });
+                    if (flag == (*it)._options.end() &&
+                        input_tokens[index].find('=') == std::string::npos) {
+                        ++index;
                     }
-                    std::string command_prefix = a_util::strings::join(input_tokens, " ") + " ";
-                    for (const std::string& word_completion: exec) {
-                        completions.push_back(command_prefix + quoteNameIfNecessary(word_completion));
+                    continue;
+                }
+                ++index_in_args;
+            }
+            std::vector<std::string> exec;
+            if (!(*it)._options.empty() && input_tokens.back().compare(0u, 2u, "--") == 0) {
+                for (const auto& option: (*it)._options) {
+                    if (option._name.compare(0u, input_tokens.back().size(), input_tokens.back()) ==
+                        0) {
+                        exec.push_back(option._name);
                     }
-                    return completions;
                 }
             }
+            else if (index_in_args < (*it)._arguments.size()) {
+                auto completion_list = std::bind(
+                    (*it)._arguments[index_in_args]._completion, this, input_tokens.back());
+                exec = completion_list();
+            }
+            if (!exec.empty()) {
+                input_tokens.pop_back();
+                for (auto token_it = input_tokens.begin(); token_it != input_tokens.end(); ++token_it)
+                {
+                    *token_it = quoteNameIfNecessary(*token_it);
+                }
+                std::string command_prefix = a_util::strings::join(input_tokens, " ") + " ";
+                for (const std::string& word_completion: exec) {
+                    completions.push_back(command_prefix + quoteNameIfNecessary(word_completion));
+                }
+                return completions;
+            }
         }
     }
 
@@ -85,43 +100,59 @@ std::vector<std::string> FepControlCommandLine::commandCompletion(const std::str
 
 void FepControlCommandLine::printWelcomeMessage()
 {
-    std::lock_guard<std::mutex> lck(_mutex_write_output);
-    std::cout << ("******************************************************************\n");
-    std::cout << ("* Welcome to FEP Control(c) 2021 VW Group                        *\n");
-    std::cout << ("*  use help to print help                                        *\n");
-    std::cout << ("******************************************************************\n");
+    writeOutputToSink("******************************************************************\n"
+                      "* Welcome to FEP Control(c) 2021 VW Group                        *\n"
+                      "*  use help to print help                                        *\n"
+                      "******************************************************************\n");
 }
 
 void FepControlCommandLine::readInputFromSource()
 {
     printWelcomeMessage();
 
+    enableCompletionCache();
     line_noise::setCallback(
         std::bind(&FepControlCommandLine::commandCompletion, this, std::placeholders::_1));
 
     std::string line;
+    // only used to skip empty lines, keeps its storage from line to line
+    LineTokenizer tokenizer;
+    // the prompt is written by linenoise directly, so all output must be written before it
+    flushOutput();
     while (line_noise::readLine(line)) {
-        auto lineTokens = parseLine(line);
-        if (lineTokens.empty()) {
+        if (tokenizer.tokenize(line).empty()) {
             continue;
         }
         line_noise::addToHistory(line);
-        processCommandline(lineTokens);
+        processLine(line, false);
+        flushOutput();
     }
+    stopJobs();
+    stopLogOutput();
+    saveCompletions();
 }
 
 void FepControlCommandLine::writeOutputToSink(const std::string& output)
 {
-    std::lock_guard<std::mutex> lck(_mutex_write_output);
-    std::cout << output << std::flush;
+    _output_writer.push(output);
+}
+
+void FepControlCommandLine::flushOutput()
+{
+    _output_writer.flush();
 }
 
 void FepControlCommandLine::writeShutdownMessage()
 {
-    if (_json_mode) {
+    stopLogOutput();
+    if (_binary_format != BinaryFormat::none) {
+        writeBinaryShutdownMessage();
+    }
+    else if (_json_mode) {
         writeOutputToSink("{\"action\" : \"applicationShutdown\"}");
     }
     else {
         writeOutputToSink("bye\n");
     }
+    flushOutput();
 }
\ No newline at end of file
@@ -22,19 +22,24 @@ You may add additional accurate notices of copyright ownership.
 #define FEP_CONTROL_COMMANDLINE_H
 
 #include "fep_control.h"
+#include "output_writer.h"
 
 class FepControlCommandLine final : public FepControl {
 public:
-    explicit FepControlCommandLine(bool json_mode);
+    explicit FepControlCommandLine(bool json_mode,
+                                   BinaryFormat binary_format = BinaryFormat::none,
+                                   FlushPolicy flush_policy = FlushPolicy());
 
     void readInputFromSource();
     void writeOutputToSink(const std::string& output);
     void writeShutdownMessage();
+    void flushOutput();
 
 private:
-    std::vector<std::string> commandNameCompletion(const std::string& word_prefix);
     std::vector<std::string> commandCompletion(const std::string& input);
     void printWelcomeMessage();
+
+    AsyncOutputWriter _output_writer;
 };
 
 #endif // FEP_CONTROL_COMMANDLINE_H
\ No newline at end of file
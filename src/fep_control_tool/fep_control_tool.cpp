@@ -30,7 +30,7 @@ You may add additional accurate notices of copyright ownership.
 
 namespace {
 std::atomic<bool> shutdown_requested{false};
-enum mode { COMMANDLINE, WEBSOCKET };
+enum mode { COMMANDLINE, WEBSOCKET, BATCH };
 mode operation_mode = COMMANDLINE;
 } // namespace
 
@@ -115,12 +115,12 @@ private:
     std::vector<std::shared_ptr<FepControl>> active_connections;
     mutable std::mutex _mutex_vector;
 };
-void interactiveLoopWebsocket(bool json_mode)
+void interactiveLoopWebsocket(bool json_mode, BinaryFormat binary_format)
 {
     std::shared_ptr<ActiveWebsocketConnections> active_websocket_connections =
         std::make_shared<ActiveWebsocketConnections>();
 
-    std::thread t([json_mode, active_websocket_connections]() {
+    std::thread t([json_mode, binary_format, active_websocket_connections]() {
         try {
             const std::string address_string = "0.0.0.0";
 
@@ -140,8 +140,8 @@ void interactiveLoopWebsocket(bool json_mode)
                 // Block until we get a connection
                 acceptor.accept(socket);
 
-                std::shared_ptr<FepControl> instance =
-                    std::make_shared<FepControlWebsocket>(std::move(socket), json_mode);
+                std::shared_ptr<FepControl> instance = std::make_shared<FepControlWebsocket>(
+                    std::move(socket), json_mode, binary_format);
 
                 active_websocket_connections->addConnection(instance);
 
@@ -178,13 +178,14 @@ void interactiveLoopWebsocket(bool json_mode)
     std::cout << "Terminating application." << std::endl;
 }
 
-void interactiveLoopCLI(bool json_mode)
+void interactiveLoopCLI(bool json_mode, BinaryFormat binary_format, FlushPolicy flush_policy)
 {
     std::vector<std::shared_ptr<FepControl>> instances;
 
     // listen for user input in command line mode
     // Create CLI object
-    std::shared_ptr<FepControl> instance = std::make_shared<FepControlCommandLine>(json_mode);
+    std::shared_ptr<FepControl> instance =
+        std::make_shared<FepControlCommandLine>(json_mode, binary_format, flush_policy);
     instances.push_back(instance);
 
     // blocking function call
@@ -206,12 +207,19 @@ int parseAndExecuteCommandline(int argc,
                                char* argv[],
                                bool& found_execute_command,
                                bool& json_mode,
-                               bool& auto_discovery_of_systems)
+                               BinaryFormat& binary_format,
+                               FlushPolicy& flush_policy,
+                               bool& auto_discovery_of_systems,
+                               bool& stop_on_error)
 {
     static const std::vector<std::string> executeOption = {"-e", "--execute"};
     static const std::vector<std::string> autoDiscoveryOption = {"-ad", "--auto_discovery"};
     static const std::vector<std::string> jsonOption = {"--json"};
     static const std::vector<std::string> websocketModeOption = {"--websocket"};
+    static const std::vector<std::string> batchModeOption = {"--batch"};
+    static const std::vector<std::string> stopOnErrorOption = {"--stop-on-error"};
+    static const std::string binaryFormatOption = "--binary-format=";
+    static const std::string flushPolicyOption = "--flush-policy=";
 
     operation_mode = COMMANDLINE;
     for (int i = 0; i < argc; i++) {
@@ -223,9 +231,26 @@ int parseAndExecuteCommandline(int argc,
         else if (std::find(jsonOption.begin(), jsonOption.end(), arg) != jsonOption.end()) {
             json_mode = true;
         }
+        else if (arg.compare(0u, binaryFormatOption.size(), binaryFormatOption) == 0) {
+            if (!parseBinaryFormat(arg.substr(binaryFormatOption.size()), binary_format)) {
+                std::cerr << "invalid binary format '" << arg.substr(binaryFormatOption.size())
+                          << "', use: --binary-format=msgpack or --binary-format=cbor\n";
+                return -1;
+            }
+            // binary messages have the same structure as the json ones
+            json_mode = true;
+        }
+        else if (arg.compare(0u, flushPolicyOption.size(), flushPolicyOption) == 0) {
+            if (!parseFlushPolicy(arg.substr(flushPolicyOption.size()), flush_policy)) {
+                std::cerr << "invalid flush policy '" << arg.substr(flushPolicyOption.size())
+                          << "', use: --flush-policy=line, --flush-policy=prompt"
+                             " or --flush-policy=<interval>ms\n";
+                return -1;
+            }
+        }
         else if (std::find(executeOption.begin(), executeOption.end(), arg) !=
                  executeOption.end()) {
-            FepControlCommandLine new_session(json_mode);
+            FepControlCommandLine new_session(json_mode, binary_format, flush_policy);
             return new_session.processCommandline(
                 std::vector<std::string>(argv + i + 1, argv + argc));
         }
@@ -233,9 +258,17 @@ int parseAndExecuteCommandline(int argc,
                  websocketModeOption.end()) {
             operation_mode = WEBSOCKET;
         }
+        else if (std::find(batchModeOption.begin(), batchModeOption.end(), arg) !=
+                 batchModeOption.end()) {
+            operation_mode = BATCH;
+        }
+        else if (std::find(stopOnErrorOption.begin(), stopOnErrorOption.end(), arg) !=
+                 stopOnErrorOption.end()) {
+            stop_on_error = true;
+        }
     }
     // Suppress help if we are in json mode
-    if (json_mode || operation_mode == WEBSOCKET) {
+    if (json_mode || operation_mode != COMMANDLINE) {
         return -1;
     }
     else {
@@ -246,6 +279,8 @@ int parseAndExecuteCommandline(int argc,
                   << "\n";
         std::cerr << "                     or:  fep_control -ad -e <execute_command>"
                   << "\n";
+        std::cerr << "                     or:  fep_control --batch [--stop-on-error] < <file>"
+                  << "\n";
     }
     return -1;
 }
@@ -254,7 +289,10 @@ int main(int argc, char* argv[])
 {
     // application settings
     bool json_mode = false;
+    BinaryFormat binary_format = BinaryFormat::none;
+    FlushPolicy flush_policy;
     bool auto_discovery_of_systems = false;
+    bool stop_on_error = false;
 
 #ifdef __linux__
     std::signal(SIGINT, signal_handler);
@@ -275,7 +313,10 @@ int main(int argc, char* argv[])
                                                 argv + 1,
                                                 found_execute_command,
                                                 json_mode,
-                                                auto_discovery_of_systems); // shift by one
+                                                binary_format,
+                                                flush_policy,
+                                                auto_discovery_of_systems,
+                                                stop_on_error); // shift by one
 
         // If we are in json mode and no execute command was found we will fallback to interactive
         // mode otherwise exit
@@ -284,11 +325,17 @@ int main(int argc, char* argv[])
         }
     }
 
+    if (operation_mode == BATCH) {
+        // the commands are read in blocks instead of line by line from the terminal
+        std::ios::sync_with_stdio(false);
+        FepControlCommandLine session(json_mode, binary_format, flush_policy);
+        return session.processBatch(std::cin, stop_on_error);
+    }
     if (operation_mode == WEBSOCKET) {
-        interactiveLoopWebsocket(json_mode);
+        interactiveLoopWebsocket(json_mode, binary_format);
     }
     else {
-        interactiveLoopCLI(json_mode);
+        interactiveLoopCLI(json_mode, binary_format, flush_policy);
     }
 
     return 0;
@@ -20,48 +20,43 @@ You may add additional accurate notices of copyright ownership.
 
 #include "fep_control_websocket.h"
 
-#include "helper.h"
+#include "worker_pool.h"
 
 #include <boost/beast/core.hpp>
 #include <iostream>
 #include <mutex>
 #include <thread>
 
-FepControlWebsocket::FepControlWebsocket(boost::asio::ip::tcp::socket socket, bool json_mode)
-    : FepControl(json_mode), _socket(std::move(socket))
+FepControlWebsocket::FepControlWebsocket(boost::asio::ip::tcp::socket socket,
+                                         bool json_mode,
+                                         BinaryFormat binary_format)
+    : FepControl(json_mode, binary_format), _socket(std::move(socket))
 {
 }
 
 void FepControlWebsocket::readInputFromSource()
 {
+    // the next frame is read while the commands of the frames before still run
+    WorkerPool workers;
+    CommandScheduler scheduler(workers);
     try {
         // Accept the websocket handshake
         _socket.accept();
 
+        // the buffer keeps its storage from message to message
+        boost::beast::flat_buffer buffer;
         for (;;) {
-            // This buffer will hold the incoming message
-            boost::beast::multi_buffer buffer;
-
             // Read a message
+            buffer.consume(buffer.size());
             _socket.read(buffer);
 
-            std::string input = boost::beast::buffers_to_string(buffer.data());
+            const std::string_view input(static_cast<const char*>(buffer.data().data()),
+                                         buffer.size());
             // Log incoming message
             std::cout << "<-- " << input << std::endl;
 
-            auto lineTokens = parseLine(input);
-            if (lineTokens.empty()) {
-                continue;
-            }
-
-            try
-            {
-                processCommandline(lineTokens);
-            }
-            catch (std::exception const& e)
-            {
-                writeError(lineTokens.front(), e.what(), CmdStatus::generic_error, "");
-            }
+            // several commands of a frame are answered with one frame
+            processLinePipelined(input, scheduler);
         }
     }
     catch (boost::system::system_error const& se) {
@@ -84,13 +79,25 @@ void FepControlWebsocket::readInputFromSource()
             std::cout << "General Boost error reading from client: " << se.what() << std::endl;
         }
     }
+    scheduler.wait();
+    stopJobs();
+    // no log messages are written to a closed connection
+    stopLogOutput();
 }
 
 void FepControlWebsocket::writeOutputToSink(const std::string& output)
 {
-    std::cout << "--> " << output << std::endl;
+    // binary messages are sent as binary frames, everything else as text frames
+    const bool binary = _binary_format != BinaryFormat::none;
+    if (binary) {
+        std::cout << "--> binary message (" << output.size() << " bytes)" << std::endl;
+    }
+    else {
+        std::cout << "--> " << output << std::endl;
+    }
     try {
         std::lock_guard<std::mutex> lck(_mutex_write_output);
+        _socket.binary(binary);
         _socket.write(boost::asio::buffer(output));
     }
     catch (const std::exception& ex)
@@ -102,7 +109,11 @@ void FepControlWebsocket::writeOutputToSink(const std::string& output)
 }
 void FepControlWebsocket::writeShutdownMessage()
 {
-    if (_json_mode) {
+    stopLogOutput();
+    if (_binary_format != BinaryFormat::none) {
+        writeBinaryShutdownMessage();
+    }
+    else if (_json_mode) {
         writeOutputToSink("{\"action\" : \"applicationShutdown\"}");
     }
     else {
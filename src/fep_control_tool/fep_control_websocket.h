@@ -28,7 +28,9 @@ You may add additional accurate notices of copyright ownership.
 
 class FepControlWebsocket final : public FepControl {
 public:
-    FepControlWebsocket(boost::asio::ip::tcp::socket socket, bool json_mode);
+    FepControlWebsocket(boost::asio::ip::tcp::socket socket,
+                        bool json_mode,
+                        BinaryFormat binary_format = BinaryFormat::none);
 
     void readInputFromSource();
     void writeOutputToSink(const std::string& output);
@@ -18,100 +18,10 @@ You may add additional accurate notices of copyright ownership.
  */
 
 #include "helper.h"
-#include "control_tool_common_helper.h"
+#include "line_tokenizer.h"
 
 #include <algorithm>
 #include <cctype>
-#include <cstring>
-
-namespace {
-
-void skipWhitespaces(const char*& p, const char* additional_whitechars = nullptr)
-{
-    if (nullptr == p) {
-        return;
-    }
-    if (additional_whitechars != nullptr) {
-        while (std::isspace(*p) || (*p != '\0' && strchr(additional_whitechars, *p) != nullptr)) {
-            p++;
-        }
-    }
-    else {
-        while (std::isspace(*p)) {
-            p++;
-        }
-    }
-}
-
-bool getNextWord(const char*& src,
-                 std::string& dest,
-                 const char* additional_separator = nullptr,
-                 const bool use_escape = true)
-{
-    if (nullptr == src) {
-        return false;
-    }
-    dest.clear();
-
-    skipWhitespaces(src);
-
-    if (*src == '\0') {
-        return false;
-    }
-
-    bool escape_active = false;
-    char last_char = '\0';
-    char quote = '\0';
-
-    if (*src == '\"' || *src == '\'') {
-        quote = *(src++);
-        const char* src_start = src;
-
-        while (*src != '\0' && (escape_active || *src != quote)) {
-            escape_active = use_escape && (*src == '\\' && last_char != '\\'); // escape next char?
-            last_char = *src;
-            src++;
-        }
-
-        dest = std::string(src_start, src);
-
-        if (*src == quote) {
-            src++;
-        }
-    }
-    else {
-        const char* src_start = src;
-
-        if (additional_separator == nullptr) {
-            while (*src != '\0' && !std::isspace(*src)) {
-                src++;
-                if (*src == '\"' || *src == '\'') {
-                    quote = *(src);
-
-                    do {
-                        escape_active = use_escape && (*src == '\\' && last_char != '\\');
-                        last_char = *src;
-                        src++;
-                    } while (*src != '\0' && (escape_active || *src != quote));
-                }
-            }
-
-            dest = std::string(src_start, src);
-        }
-        else {
-            while (*src != '\0' &&
-                   (!std::isspace(*src) && strchr(additional_separator, *src) == nullptr)) {
-                src++;
-            }
-
-            dest = std::string(src_start, src);
-        }
-    }
-
-    return true;
-}
-
-} // namespace
 
 std::string resolveSystemState(const fep3::System::AggregatedState st)
 {
@@ -138,20 +48,9 @@ std::string resolveSystemState(const fep3::System::AggregatedState st)
 
 std::vector<std::string> parseLine(const std::string& line, bool add_empty)
 {
-    const char* p = line.c_str();
-    std::vector<std::string> words;
-    std::string word;
-    const char* last_p = p;
-    while (getNextWord(p, word))
-    {
-        words.push_back(unEscape(word));
-        last_p = p;
-    }
-    if (add_empty && last_p != p)
-    {
-        words.emplace_back();
-    }
-    return words;
+    LineTokenizer tokenizer;
+    const auto& words = tokenizer.tokenize(line, add_empty);
+    return std::vector<std::string>(words.begin(), words.end());
 }
 
 fep3::SystemAggregatedState getStateFromString(const std::string& state_string)
@@ -176,3 +75,30 @@ fep3::SystemAggregatedState getStateFromString(const std::string& state_string)
     }
     return fep3::SystemAggregatedState::undefined;
 }
+
+bool getSeverityFromString(const std::string& severity_string, fep3::LoggerSeverity& severity)
+{
+    std::string name = severity_string;
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    if (name == "fatal" || name == "1") {
+        severity = fep3::LoggerSeverity::fatal;
+    }
+    else if (name == "error" || name == "2") {
+        severity = fep3::LoggerSeverity::error;
+    }
+    else if (name == "warning" || name == "3") {
+        severity = fep3::LoggerSeverity::warning;
+    }
+    else if (name == "info" || name == "4") {
+        severity = fep3::LoggerSeverity::info;
+    }
+    else if (name == "debug" || name == "5") {
+        severity = fep3::LoggerSeverity::debug;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
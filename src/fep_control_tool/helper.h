@@ -45,4 +45,7 @@ std::string resolveSystemState(const fep3::System::AggregatedState st);
 
 fep3::SystemAggregatedState getStateFromString(const std::string& state_string);
 
+// accepts the names (case insensitive) and the numbers of the severities fatal to debug
+bool getSeverityFromString(const std::string& severity_string, fep3::LoggerSeverity& severity);
+
 #endif // HELPER_H
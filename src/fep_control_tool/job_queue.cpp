@@ -0,0 +1,193 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "job_queue.h"
+
+const char* getJobStateName(JobInfo::State state)
+{
+    switch (state) {
+    case JobInfo::State::queued:
+        return "queued";
+    case JobInfo::State::running:
+        return "running";
+    case JobInfo::State::done:
+        return "done";
+    case JobInfo::State::failed:
+        return "failed";
+    case JobInfo::State::cancelled:
+        return "cancelled";
+    }
+    return "unknown";
+}
+
+JobQueue::JobQueue(Observer observer, std::size_t thread_count)
+    : _observer(std::move(observer)), _workers(thread_count), _scheduler(_workers)
+{
+}
+
+JobQueue::~JobQueue()
+{
+    stop();
+}
+
+std::uint64_t JobQueue::run(const CommandTarget& target,
+                            const std::string& command_line,
+                            std::function<int()> command)
+{
+    std::uint64_t id = 0u;
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        id = _next_id++;
+        JobInfo& job = _jobs[id];
+        job._id = id;
+        job._command_line = command_line;
+    }
+    _scheduler.submit(target, [this, id, command = std::move(command)]() { runJob(id, command); });
+    return id;
+}
+
+void JobQueue::runJob(std::uint64_t id, const std::function<int()>& command)
+{
+    JobInfo started;
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        const auto job = _jobs.find(id);
+        if (job == _jobs.end() || job->second._state != JobInfo::State::queued) {
+            // cancelled meanwhile, and possibly forgotten already
+            return;
+        }
+        job->second._state = JobInfo::State::running;
+        started = job->second;
+    }
+    _observer(started);
+
+    const auto start = std::chrono::steady_clock::now();
+    const int result = command();
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    JobInfo ended;
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        const auto job = _jobs.find(id);
+        if (job == _jobs.end()) {
+            // running jobs are not forgotten, the workers must not throw anyway
+            return;
+        }
+        job->second._state = result == 0 ? JobInfo::State::done : JobInfo::State::failed;
+        job->second._result = result;
+        job->second._duration = duration;
+        ended = job->second;
+        forgetEndedJobs();
+    }
+    // the event is written before the answer of a waiting command
+    _observer(ended);
+    _job_ended.notify_all();
+}
+
+// called with the mutex locked for each job which ended, the oldest ones are forgotten first
+void JobQueue::forgetEndedJobs()
+{
+    if (++_ended_count <= max_ended_jobs) {
+        return;
+    }
+    for (auto it = _jobs.begin(); it != _jobs.end(); ++it) {
+        if (it->second._state != JobInfo::State::queued &&
+            it->second._state != JobInfo::State::running) {
+            _jobs.erase(it);
+            --_ended_count;
+            return;
+        }
+    }
+}
+
+boost::optional<JobInfo> JobQueue::getJob(std::uint64_t id) const
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    const auto job = _jobs.find(id);
+    if (job == _jobs.end()) {
+        return boost::none;
+    }
+    return job->second;
+}
+
+std::vector<JobInfo> JobQueue::getJobs() const
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    std::vector<JobInfo> jobs;
+    jobs.reserve(_jobs.size());
+    for (const auto& job: _jobs) {
+        jobs.push_back(job.second);
+    }
+    return jobs;
+}
+
+boost::optional<JobInfo> JobQueue::wait(std::uint64_t id)
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    boost::optional<JobInfo> job;
+    _job_ended.wait(lck, [this, id, &job]() {
+        const auto it = _jobs.find(id);
+        if (it == _jobs.end()) {
+            job = boost::none;
+            return true;
+        }
+        job = it->second;
+        return job->_state != JobInfo::State::queued && job->_state != JobInfo::State::running;
+    });
+    return job;
+}
+
+boost::optional<JobInfo> JobQueue::cancel(std::uint64_t id)
+{
+    JobInfo cancelled;
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        const auto job = _jobs.find(id);
+        if (job == _jobs.end()) {
+            return boost::none;
+        }
+        if (job->second._state != JobInfo::State::queued) {
+            return job->second;
+        }
+        job->second._state = JobInfo::State::cancelled;
+        cancelled = job->second;
+        forgetEndedJobs();
+    }
+    _observer(cancelled);
+    _job_ended.notify_all();
+    return cancelled;
+}
+
+void JobQueue::stop()
+{
+    std::vector<std::uint64_t> queued_jobs;
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        for (const auto& job: _jobs) {
+            if (job.second._state == JobInfo::State::queued) {
+                queued_jobs.push_back(job.first);
+            }
+        }
+    }
+    for (const std::uint64_t id: queued_jobs) {
+        cancel(id);
+    }
+    _scheduler.wait();
+}
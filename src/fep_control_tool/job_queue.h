@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef JOB_QUEUE_H
+#define JOB_QUEUE_H
+
+#include "command_script.h"
+#include "worker_pool.h"
+
+#include <boost/optional.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct JobInfo {
+    enum class State { queued, running, done, failed, cancelled };
+
+    std::uint64_t _id = 0u;
+    std::string _command_line;
+    State _state = State::queued;
+    // the result of the command, 0 if it succeeded
+    int _result = 0;
+    std::chrono::microseconds _duration{0};
+};
+
+const char* getJobStateName(JobInfo::State state);
+
+// Runs commands as jobs in the background, ordered by their target like the commands of a
+// CommandScheduler. Jobs which did not start yet can be cancelled. The most recent jobs which
+// ended are kept for their status.
+class JobQueue {
+public:
+    static constexpr std::size_t max_ended_jobs = 256u;
+    // called when a job starts and when it ends, on its worker thread, or when it is cancelled
+    using Observer = std::function<void(const JobInfo&)>;
+
+    explicit JobQueue(Observer observer,
+                      std::size_t thread_count = WorkerPool::default_thread_count);
+    // cancels the queued jobs and waits for the running ones
+    ~JobQueue();
+
+    JobQueue(const JobQueue&) = delete;
+    JobQueue& operator=(const JobQueue&) = delete;
+
+    // returns the id of the job, the command must not throw and returns 0 if it succeeded
+    std::uint64_t run(const CommandTarget& target,
+                      const std::string& command_line,
+                      std::function<int()> command);
+    boost::optional<JobInfo> getJob(std::uint64_t id) const;
+    // all jobs kept, oldest first
+    std::vector<JobInfo> getJobs() const;
+    // blocks until the job ended, none if the job is unknown
+    boost::optional<JobInfo> wait(std::uint64_t id);
+    // cancels the job if it is queued, returns its state afterwards, none if the job is unknown
+    boost::optional<JobInfo> cancel(std::uint64_t id);
+    // cancels the queued jobs and waits for the running ones
+    void stop();
+
+private:
+    void runJob(std::uint64_t id, const std::function<int()>& command);
+    void forgetEndedJobs();
+
+    const Observer _observer;
+    mutable std::mutex _mutex;
+    std::condition_variable _job_ended;
+    std::map<std::uint64_t, JobInfo> _jobs;
+    std::uint64_t _next_id = 1u;
+    std::size_t _ended_count = 0u;
+    WorkerPool _workers;
+    // destroyed first, it waits for the jobs
+    CommandScheduler _scheduler;
+};
+
+#endif // JOB_QUEUE_H
@@ -0,0 +1,280 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+#pragma once
+#include <array>
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Streaming writer for compact json. Writes directly into a buffer which keeps its capacity
+// between documents, so writing the small answer envelopes does not allocate.
+// The output is byte identical to Json::writeString with an empty indentation, given that object
+// members are written in ascending key order (as Json::Value stores them).
+class JsonWriter {
+public:
+    static constexpr std::size_t max_depth = 32u;
+
+    void clear()
+    {
+        _buffer.clear();
+        _depth = 0u;
+        _element_count[0] = 0u;
+        _after_key = false;
+    }
+
+    // the size is a hint for formats which need the element count upfront, json ignores it
+    void beginObject(std::size_t /*size*/ = 0u)
+    {
+        open('{');
+    }
+
+    void endObject()
+    {
+        close('}');
+    }
+
+    void beginArray(std::size_t /*size*/ = 0u)
+    {
+        open('[');
+    }
+
+    void endArray()
+    {
+        close(']');
+    }
+
+    void key(std::string_view name)
+    {
+        separate();
+        writeQuoted(name);
+        _buffer += ':';
+        _after_key = true;
+    }
+
+    void value(std::string_view text)
+    {
+        separate();
+        writeQuoted(text);
+    }
+
+    void value(const char* text)
+    {
+        value(std::string_view(text));
+    }
+
+    void value(const std::string& text)
+    {
+        value(std::string_view(text));
+    }
+
+    void value(std::int64_t number)
+    {
+        separate();
+        char digits[24];
+        auto result = std::to_chars(std::begin(digits), std::end(digits), number);
+        _buffer.append(digits, result.ptr);
+    }
+
+    void value(bool flag)
+    {
+        separate();
+        _buffer += flag ? "true" : "false";
+    }
+
+    void nullValue()
+    {
+        separate();
+        _buffer += "null";
+    }
+
+    // appends preformatted json, e.g. a serialized Json::Value
+    void rawValue(std::string_view json)
+    {
+        separate();
+        _buffer.append(json.data(), json.size());
+    }
+
+    void newLine()
+    {
+        _buffer += '\n';
+    }
+
+    const std::string& str() const
+    {
+        return _buffer;
+    }
+
+private:
+    void separate()
+    {
+        if (_after_key) {
+            _after_key = false;
+            return;
+        }
+        if (_element_count[_depth]++ > 0u) {
+            _buffer += ',';
+        }
+    }
+
+    void open(char bracket)
+    {
+        separate();
+        _buffer += bracket;
+        assert(_depth + 1u < max_depth);
+        _element_count[++_depth] = 0u;
+    }
+
+    void close(char bracket)
+    {
+        assert(_depth > 0u);
+        --_depth;
+        _buffer += bracket;
+    }
+
+    void writeQuoted(std::string_view text)
+    {
+        _buffer += '"';
+        const char* current = text.data();
+        const char* const end = current + text.size();
+        while (current != end) {
+            // copy the longest run which needs no escaping at once
+            const char* run_end = current;
+            while (run_end != end && !needsEscape(*run_end)) {
+                ++run_end;
+            }
+            _buffer.append(current, run_end);
+            if (run_end == end) {
+                break;
+            }
+            current = run_end;
+            writeEscaped(current, end);
+            ++current;
+        }
+        _buffer += '"';
+    }
+
+    static bool needsEscape(char c)
+    {
+        const auto byte = static_cast<unsigned char>(c);
+        return byte < 0x20u || byte >= 0x80u || c == '"' || c == '\\';
+    }
+
+    // escapes the character at current, advances current to the last byte of a utf-8 sequence
+    void writeEscaped(const char*& current, const char* end)
+    {
+        switch (*current) {
+        case '"':
+            _buffer += "\\\"";
+            return;
+        case '\\':
+            _buffer += "\\\\";
+            return;
+        case '\b':
+            _buffer += "\\b";
+            return;
+        case '\f':
+            _buffer += "\\f";
+            return;
+        case '\n':
+            _buffer += "\\n";
+            return;
+        case '\r':
+            _buffer += "\\r";
+            return;
+        case '\t':
+            _buffer += "\\t";
+            return;
+        default:
+            break;
+        }
+        const std::uint32_t codepoint = decodeUtf8(current, end);
+        if (codepoint < 0x10000u) {
+            writeUnicodeEscape(codepoint);
+        }
+        else {
+            const std::uint32_t surrogate_base = codepoint - 0x10000u;
+            writeUnicodeEscape(0xD800u + ((surrogate_base >> 10u) & 0x3FFu));
+            writeUnicodeEscape(0xDC00u + (surrogate_base & 0x3FFu));
+        }
+    }
+
+    void writeUnicodeEscape(std::uint32_t code_unit)
+    {
+        static constexpr char hex_digits[] = "0123456789abcdef";
+        const char escape[] = {'\\',
+                               'u',
+                               hex_digits[(code_unit >> 12u) & 0xFu],
+                               hex_digits[(code_unit >> 8u) & 0xFu],
+                               hex_digits[(code_unit >> 4u) & 0xFu],
+                               hex_digits[code_unit & 0xFu]};
+        _buffer.append(escape, sizeof(escape));
+    }
+
+    // decodes like jsoncpp does, invalid sequences become the replacement character
+    static std::uint32_t decodeUtf8(const char*& current, const char* end)
+    {
+        constexpr std::uint32_t replacement_character = 0xFFFDu;
+        auto byte = [&current](std::ptrdiff_t index) {
+            return static_cast<std::uint32_t>(static_cast<unsigned char>(current[index]));
+        };
+        const std::uint32_t first_byte = byte(0);
+        if (first_byte < 0x80u) {
+            return first_byte;
+        }
+        if (first_byte < 0xE0u) {
+            if (end - current < 2) {
+                return replacement_character;
+            }
+            const std::uint32_t codepoint = ((first_byte & 0x1Fu) << 6u) | (byte(1) & 0x3Fu);
+            current += 1;
+            return codepoint < 0x80u ? replacement_character : codepoint;
+        }
+        if (first_byte < 0xF0u) {
+            if (end - current < 3) {
+                return replacement_character;
+            }
+            const std::uint32_t codepoint =
+                ((first_byte & 0x0Fu) << 12u) | ((byte(1) & 0x3Fu) << 6u) | (byte(2) & 0x3Fu);
+            current += 2;
+            if (codepoint >= 0xD800u && codepoint <= 0xDFFFu) {
+                return replacement_character;
+            }
+            return codepoint < 0x800u ? replacement_character : codepoint;
+        }
+        if (first_byte < 0xF8u) {
+            if (end - current < 4) {
+                return replacement_character;
+            }
+            const std::uint32_t codepoint = ((first_byte & 0x07u) << 18u) |
+                                            ((byte(1) & 0x3Fu) << 12u) |
+                                            ((byte(2) & 0x3Fu) << 6u) | (byte(3) & 0x3Fu);
+            current += 3;
+            return codepoint < 0x10000u ? replacement_character : codepoint;
+        }
+        return replacement_character;
+    }
+
+    std::string _buffer;
+    std::array<std::size_t, max_depth> _element_count{};
+    std::size_t _depth = 0u;
+    bool _after_key = false;
+};
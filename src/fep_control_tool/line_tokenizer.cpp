@@ -0,0 +1,138 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "line_tokenizer.h"
+
+#include <cctype>
+
+namespace {
+bool isSpace(char character)
+{
+    return std::isspace(static_cast<unsigned char>(character)) != 0;
+}
+} // namespace
+
+const std::vector<std::string_view>& LineTokenizer::tokenize(std::string_view line, bool add_empty)
+{
+    // the line is read like a c string, it ends at the first null character
+    line = line.substr(0u, line.find('\0'));
+    _words.clear();
+    _quoted.clear();
+    _unescaped_count = 0u;
+
+    std::size_t position = 0u;
+    std::size_t last_position = 0u;
+    for (;;) {
+        while (position < line.size() && isSpace(line[position])) {
+            ++position;
+        }
+        if (position == line.size()) {
+            break;
+        }
+
+        // an escaped quote does not end a quoted part of the word
+        bool escape_active = false;
+        char last_char = '\0';
+        std::size_t word_begin = position;
+        std::size_t word_end = position;
+        const bool quoted = line[position] == '"' || line[position] == '\'';
+        if (quoted) {
+            const char quote = line[position++];
+            word_begin = position;
+            while (position < line.size() && (escape_active || line[position] != quote)) {
+                escape_active = line[position] == '\\' && last_char != '\\';
+                last_char = line[position];
+                ++position;
+            }
+            word_end = position;
+            if (position < line.size()) {
+                // the closing quote
+                ++position;
+            }
+        }
+        else {
+            // quoted parts within the word may contain whitespace, their quotes are kept
+            while (position < line.size() && !isSpace(line[position])) {
+                ++position;
+                if (position < line.size() && (line[position] == '"' || line[position] == '\'')) {
+                    const char quote = line[position];
+                    do {
+                        escape_active = line[position] == '\\' && last_char != '\\';
+                        last_char = line[position];
+                        ++position;
+                    } while (position < line.size() &&
+                             (escape_active || line[position] != quote));
+                }
+            }
+            word_end = position;
+        }
+        const std::string_view word = line.substr(word_begin, word_end - word_begin);
+        addWord(word, quoted || word.find_first_of("\"'\\") != std::string_view::npos);
+        last_position = position;
+    }
+    if (add_empty && last_position != position) {
+        _words.emplace_back();
+        _quoted.push_back(false);
+    }
+    return _words;
+}
+
+void LineTokenizer::tokenize(std::string_view line,
+                             std::vector<std::string>& words,
+                             bool add_empty)
+{
+    const auto& views = tokenize(line, add_empty);
+    words.resize(views.size());
+    for (std::size_t index = 0u; index < views.size(); ++index) {
+        words[index].assign(views[index].data(), views[index].size());
+    }
+}
+
+bool LineTokenizer::isQuoted(std::size_t index) const
+{
+    return _quoted[index];
+}
+
+void LineTokenizer::addWord(std::string_view word, bool quoted)
+{
+    _quoted.push_back(quoted);
+    if (word.find('\\') == std::string_view::npos) {
+        _words.push_back(word);
+        return;
+    }
+    if (_unescaped_count == _unescaped_words.size()) {
+        _unescaped_words.emplace_back();
+    }
+    std::string& unescaped = _unescaped_words[_unescaped_count++];
+    unescaped.clear();
+    bool escape_active = false;
+    for (const char character: word) {
+        if (escape_active || character != '\\') {
+            unescaped += character;
+            escape_active = false;
+        }
+        else {
+            escape_active = true;
+        }
+    }
+    if (escape_active) {
+        unescaped += '\\';
+    }
+    _words.push_back(unescaped);
+}
@@ -0,0 +1,52 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef LINE_TOKENIZER_H
+#define LINE_TOKENIZER_H
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Splits a command line into words separated by whitespace. A word may be quoted by '"' or '\''
+// and a backslash escapes the next character. The words are slices of the line, only the words
+// containing a backslash are copied to remove the escapes. The storage of the words is reused
+// for every line of a session.
+class LineTokenizer {
+public:
+    // the words are valid until the next call and as long as the line is unchanged, an empty
+    // word is added if add_empty is set and the line ends with whitespace
+    const std::vector<std::string_view>& tokenize(std::string_view line, bool add_empty = false);
+    // assigns the words to the strings, which keep their capacity from line to line
+    void tokenize(std::string_view line, std::vector<std::string>& words, bool add_empty = false);
+    // the word of the last line was quoted or escaped, at least partly
+    bool isQuoted(std::size_t index) const;
+
+private:
+    void addWord(std::string_view word, bool quoted);
+
+    std::vector<std::string_view> _words;
+    std::vector<bool> _quoted;
+    // a deque keeps the addresses of the strings when it grows
+    std::deque<std::string> _unescaped_words;
+    std::size_t _unescaped_count = 0u;
+};
+
+#endif // LINE_TOKENIZER_H
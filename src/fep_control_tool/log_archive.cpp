@@ -0,0 +1,507 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "log_archive.h"
+
+#include <a_util/filesystem.h>
+#include <algorithm>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+const std::string segment_magic = "FEPLOGS1";
+const std::string index_magic = "FEPLOGI1";
+const std::string segment_prefix = "fep_log_";
+const std::string segment_extension = ".seg";
+const std::string index_extension = ".idx";
+// size, time, severity and the sizes of participant name, logger name and message
+constexpr std::size_t record_header_size = 4u + 8u + 1u + 2u + 2u + 4u;
+constexpr std::size_t max_segment_size = 1024u * 1024u * 1024u;
+
+// all numbers are stored little endian
+template <typename T>
+void appendNumber(std::string& output, T number)
+{
+    const auto value = static_cast<std::uint64_t>(number);
+    for (std::size_t byte = 0u; byte < sizeof(T); ++byte) {
+        output.push_back(static_cast<char>((value >> (8u * byte)) & 0xFFu));
+    }
+}
+
+template <typename T>
+T readNumber(const unsigned char* data)
+{
+    std::uint64_t value = 0u;
+    for (std::size_t byte = 0u; byte < sizeof(T); ++byte) {
+        value |= static_cast<std::uint64_t>(data[byte]) << (8u * byte);
+    }
+    return static_cast<T>(value);
+}
+
+// bounds checked reading of the index file
+class Reader {
+public:
+    Reader(const unsigned char* data, std::size_t size) : _data(data), _size(size)
+    {
+    }
+
+    template <typename T>
+    bool read(T& number)
+    {
+        if (_size - _position < sizeof(T)) {
+            return false;
+        }
+        number = readNumber<T>(_data + _position);
+        _position += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string& text, std::size_t size)
+    {
+        if (_size - _position < size) {
+            return false;
+        }
+        text.assign(reinterpret_cast<const char*>(_data + _position), size);
+        _position += size;
+        return true;
+    }
+
+private:
+    const unsigned char* _data;
+    std::size_t _size;
+    std::size_t _position = 0u;
+};
+
+std::string getSegmentName(std::uint64_t number)
+{
+    std::string digits = std::to_string(number);
+    if (digits.size() < 6u) {
+        digits.insert(0u, 6u - digits.size(), '0');
+    }
+    return segment_prefix + digits + segment_extension;
+}
+
+std::string getIndexPath(const std::string& segment_path)
+{
+    return segment_path.substr(0u, segment_path.size() - segment_extension.size()) +
+           index_extension;
+}
+
+// the segments of the directory ordered by their number
+std::vector<std::pair<std::uint64_t, std::string>> getSegments(const std::string& directory)
+{
+    std::vector<a_util::filesystem::Path> files;
+    if (a_util::filesystem::enumDirectory(directory, files, a_util::filesystem::ED_FILES) !=
+        a_util::filesystem::OK) {
+        throw std::runtime_error("cannot read the directory '" + directory + "'");
+    }
+    std::vector<std::pair<std::uint64_t, std::string>> segments;
+    for (const auto& file: files) {
+        const std::string name = file.getLastElement().toString();
+        if (name.size() <= segment_prefix.size() + segment_extension.size() ||
+            name.compare(0u, segment_prefix.size(), segment_prefix) != 0 ||
+            name.compare(name.size() - segment_extension.size(),
+                         segment_extension.size(),
+                         segment_extension) != 0) {
+            continue;
+        }
+        const std::string digits = name.substr(
+            segment_prefix.size(), name.size() - segment_prefix.size() - segment_extension.size());
+        if (digits.find_first_not_of("0123456789") != std::string::npos || digits.size() > 18u) {
+            continue;
+        }
+        segments.emplace_back(
+            std::stoull(digits),
+            a_util::filesystem::Path(directory).append(name).toString());
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+void encodeRecord(std::string& output, const LogRecord& record)
+{
+    const auto participant_size =
+        static_cast<std::uint16_t>(std::min<std::size_t>(record._participant_name.size(), 0xFFFFu));
+    const auto logger_size =
+        static_cast<std::uint16_t>(std::min<std::size_t>(record._logger_name.size(), 0xFFFFu));
+    const auto message_size =
+        static_cast<std::uint32_t>(std::min<std::size_t>(record._message.size(), max_segment_size));
+    output.clear();
+    appendNumber(output,
+                 static_cast<std::uint32_t>(record_header_size - 4u + participant_size +
+                                            logger_size + message_size));
+    appendNumber(output, static_cast<std::int64_t>(record._time.count()));
+    appendNumber(output, static_cast<std::uint8_t>(record._severity));
+    appendNumber(output, participant_size);
+    appendNumber(output, logger_size);
+    appendNumber(output, message_size);
+    output.append(record._participant_name, 0u, participant_size);
+    output.append(record._logger_name, 0u, logger_size);
+    output.append(record._message, 0u, message_size);
+}
+
+// returns the size of the record at the offset, 0 if there is no complete record
+std::size_t decodeRecord(const unsigned char* data,
+                         std::size_t size,
+                         std::size_t offset,
+                         LogRecord& record)
+{
+    if (offset > size || size - offset < record_header_size) {
+        return 0u;
+    }
+    const unsigned char* header = data + offset;
+    const std::size_t record_size = 4u + readNumber<std::uint32_t>(header);
+    const auto participant_size = readNumber<std::uint16_t>(header + 13u);
+    const auto logger_size = readNumber<std::uint16_t>(header + 15u);
+    const auto message_size = readNumber<std::uint32_t>(header + 17u);
+    if (record_size != record_header_size + participant_size + logger_size + message_size ||
+        size - offset < record_size) {
+        return 0u;
+    }
+    const char* text = reinterpret_cast<const char*>(header + record_header_size);
+    record._time = std::chrono::milliseconds(readNumber<std::int64_t>(header + 4u));
+    record._severity = static_cast<fep3::LoggerSeverity>(header[12]);
+    record._participant_name.assign(text, participant_size);
+    record._logger_name.assign(text + participant_size, logger_size);
+    record._message.assign(text + participant_size + logger_size, message_size);
+    record._truncated = false;
+    return record_size;
+}
+
+void buildIndex(const unsigned char* data, std::size_t size, LogSegmentIndex& index)
+{
+    index = LogSegmentIndex();
+    LogRecord record;
+    std::size_t offset = segment_magic.size();
+    while (const std::size_t record_size = decodeRecord(data, size, offset, record)) {
+        index.add(record, static_cast<std::uint32_t>(offset));
+        offset += record_size;
+    }
+}
+
+void writeIndex(const std::string& path, const LogSegmentIndex& index)
+{
+    std::string output = index_magic;
+    appendNumber(output, index._record_count);
+    appendNumber(output, static_cast<std::int64_t>(index._min_time.count()));
+    appendNumber(output, static_cast<std::int64_t>(index._max_time.count()));
+    appendNumber(output, static_cast<std::uint32_t>(index._participants.size()));
+    for (const auto& participant: index._participants) {
+        appendNumber(output, static_cast<std::uint16_t>(participant.first.size()));
+        output += participant.first;
+        appendNumber(output, static_cast<std::int64_t>(participant.second._min_time.count()));
+        appendNumber(output, static_cast<std::int64_t>(participant.second._max_time.count()));
+        appendNumber(output, static_cast<std::uint32_t>(participant.second._offsets.size()));
+        for (const auto offset: participant.second._offsets) {
+            appendNumber(output, offset);
+        }
+    }
+
+    // readers never see a partially written index
+    const std::string temporary_path = path + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        file.write(output.data(), static_cast<std::streamsize>(output.size()));
+        if (!file) {
+            return;
+        }
+    }
+    std::rename(temporary_path.c_str(), path.c_str());
+}
+
+bool readIndex(const std::string& path, LogSegmentIndex& index)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    const std::string input{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    Reader reader(reinterpret_cast<const unsigned char*>(input.data()), input.size());
+
+    std::string magic;
+    std::int64_t min_time = 0, max_time = 0;
+    std::uint32_t participant_count = 0u;
+    index = LogSegmentIndex();
+    if (!reader.read(magic, index_magic.size()) || magic != index_magic ||
+        !reader.read(index._record_count) || !reader.read(min_time) || !reader.read(max_time) ||
+        !reader.read(participant_count)) {
+        return false;
+    }
+    index._min_time = std::chrono::milliseconds(min_time);
+    index._max_time = std::chrono::milliseconds(max_time);
+    for (std::uint32_t participant = 0u; participant < participant_count; ++participant) {
+        std::uint16_t name_size = 0u;
+        std::string name;
+        std::uint32_t offset_count = 0u;
+        if (!reader.read(name_size) || !reader.read(name, name_size) ||
+            !reader.read(min_time) || !reader.read(max_time) || !reader.read(offset_count) ||
+            offset_count > input.size() / sizeof(std::uint32_t)) {
+            return false;
+        }
+        auto& entry = index._participants[name];
+        entry._min_time = std::chrono::milliseconds(min_time);
+        entry._max_time = std::chrono::milliseconds(max_time);
+        entry._offsets.resize(offset_count);
+        for (auto& offset: entry._offsets) {
+            if (!reader.read(offset)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool matchesTime(const LogArchiveQuery& query, std::chrono::milliseconds time)
+{
+    return (!query._since || time >= *query._since) && (!query._until || time <= *query._until);
+}
+} // namespace
+
+void LogSegmentIndex::add(const LogRecord& record, std::uint32_t offset)
+{
+    ++_record_count;
+    _min_time = std::min(_min_time, record._time);
+    _max_time = std::max(_max_time, record._time);
+    auto& participant = _participants[record._participant_name];
+    participant._min_time = std::min(participant._min_time, record._time);
+    participant._max_time = std::max(participant._max_time, record._time);
+    participant._offsets.push_back(offset);
+}
+
+bool LogSegmentIndex::mayMatch(const LogArchiveQuery& query) const
+{
+    auto min_time = _min_time;
+    auto max_time = _max_time;
+    if (query._participant_name) {
+        const auto participant = _participants.find(*query._participant_name);
+        if (participant == _participants.end()) {
+            return false;
+        }
+        min_time = participant->second._min_time;
+        max_time = participant->second._max_time;
+    }
+    return _record_count != 0u && (!query._since || max_time >= *query._since) &&
+           (!query._until || min_time <= *query._until);
+}
+
+LogArchiveWriter::LogArchiveWriter(std::string directory, std::size_t segment_size)
+    : _directory(std::move(directory)),
+      _segment_size(std::min(std::max<std::size_t>(segment_size, 4096u), max_segment_size))
+{
+    if (!a_util::filesystem::exists(_directory) &&
+        !a_util::filesystem::createDirectory(_directory)) {
+        throw std::runtime_error("cannot create the directory '" + _directory + "'");
+    }
+    // the archive is append-only, the new segments follow the existing ones
+    const auto segments = getSegments(_directory);
+    _next_segment_number = segments.empty() ? 0u : segments.back().first + 1u;
+    openSegment();
+    if (_segment_file == nullptr) {
+        throw std::runtime_error("cannot create the segment '" + _segment_path + "'");
+    }
+    _writer_thread = std::thread([this]() { run(); });
+}
+
+LogArchiveWriter::~LogArchiveWriter()
+{
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        _stop = true;
+    }
+    _records_added.notify_one();
+    _writer_thread.join();
+    closeSegment();
+}
+
+void LogArchiveWriter::add(const LogRecord& record)
+{
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        if (_queue.size() >= max_queue_size) {
+            ++_statistics._dropped;
+            return;
+        }
+        _queue.push_back(record);
+    }
+    _records_added.notify_one();
+}
+
+void LogArchiveWriter::flush()
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    _records_written.wait(lck, [this]() { return _queue.empty() && !_writing; });
+}
+
+LogArchiveWriter::Statistics LogArchiveWriter::getStatistics() const
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    return _statistics;
+}
+
+const std::string& LogArchiveWriter::getDirectory() const
+{
+    return _directory;
+}
+
+void LogArchiveWriter::run()
+{
+    std::vector<LogRecord> records;
+    std::unique_lock<std::mutex> lck(_mutex);
+    for (;;) {
+        _records_added.wait(lck, [this]() { return _stop || !_queue.empty(); });
+        if (_queue.empty()) {
+            return;
+        }
+        records.swap(_queue);
+        _writing = true;
+        lck.unlock();
+
+        for (const auto& record: records) {
+            write(record);
+        }
+        if (_segment_file != nullptr) {
+            // readers of the archive see complete batches
+            std::fflush(_segment_file);
+        }
+        records.clear();
+        lck.lock();
+        _writing = false;
+        _records_written.notify_all();
+    }
+}
+
+// called by the writer thread or before it is started
+void LogArchiveWriter::openSegment()
+{
+    const std::string segment_name = getSegmentName(_next_segment_number++);
+    _segment_path = a_util::filesystem::Path(_directory).append(segment_name).toString();
+    _segment_file = std::fopen(_segment_path.c_str(), "wb");
+    _segment_index = LogSegmentIndex();
+    _segment_bytes = static_cast<std::uint32_t>(segment_magic.size());
+    if (_segment_file == nullptr ||
+        std::fwrite(segment_magic.data(), 1u, segment_magic.size(), _segment_file) !=
+            segment_magic.size()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lck(_mutex);
+    ++_statistics._segments;
+    _statistics._bytes += segment_magic.size();
+}
+
+// called by the writer thread or after it is stopped
+void LogArchiveWriter::closeSegment()
+{
+    if (_segment_file == nullptr) {
+        return;
+    }
+    std::fclose(_segment_file);
+    _segment_file = nullptr;
+    writeIndex(getIndexPath(_segment_path), _segment_index);
+}
+
+void LogArchiveWriter::write(const LogRecord& record)
+{
+    encodeRecord(_encoded, record);
+    if (_segment_file != nullptr && _segment_index._record_count != 0u &&
+        _segment_bytes + _encoded.size() > _segment_size) {
+        closeSegment();
+        openSegment();
+    }
+    if (_segment_file == nullptr ||
+        std::fwrite(_encoded.data(), 1u, _encoded.size(), _segment_file) != _encoded.size()) {
+        std::lock_guard<std::mutex> lck(_mutex);
+        ++_statistics._dropped;
+        return;
+    }
+    _segment_index.add(record, _segment_bytes);
+    _segment_bytes += static_cast<std::uint32_t>(_encoded.size());
+    std::lock_guard<std::mutex> lck(_mutex);
+    ++_statistics._written;
+    _statistics._bytes += _encoded.size();
+}
+
+std::vector<LogRecord> queryLogArchive(const std::string& directory,
+                                       const LogArchiveQuery& query)
+{
+    const auto segments = getSegments(directory);
+
+    // walk from the newest segment backwards, so the limit keeps the most recent records
+    std::vector<LogRecord> records;
+    LogRecord record;
+    for (auto segment = segments.rbegin(); segment != segments.rend(); ++segment) {
+        if (query._limit != 0u && records.size() >= query._limit) {
+            break;
+        }
+        boost::interprocess::file_mapping mapping;
+        boost::interprocess::mapped_region region;
+        try {
+            boost::interprocess::file_mapping(segment->second.c_str(),
+                                              boost::interprocess::read_only)
+                .swap(mapping);
+            boost::interprocess::mapped_region(mapping, boost::interprocess::read_only)
+                .swap(region);
+        }
+        catch (const boost::interprocess::interprocess_exception&) {
+            // an empty or unreadable segment
+            continue;
+        }
+        const auto* data = static_cast<const unsigned char*>(region.get_address());
+        const std::size_t size = region.get_size();
+        if (size < segment_magic.size() ||
+            std::memcmp(data, segment_magic.data(), segment_magic.size()) != 0) {
+            continue;
+        }
+
+        LogSegmentIndex index;
+        if (!readIndex(getIndexPath(segment->second), index)) {
+            buildIndex(data, size, index);
+        }
+        if (!index.mayMatch(query)) {
+            continue;
+        }
+        std::vector<std::uint32_t> offsets;
+        if (query._participant_name) {
+            offsets = index._participants.at(*query._participant_name)._offsets;
+        }
+        else {
+            for (const auto& participant: index._participants) {
+                offsets.insert(offsets.end(),
+                               participant.second._offsets.begin(),
+                               participant.second._offsets.end());
+            }
+            std::sort(offsets.begin(), offsets.end());
+        }
+
+        for (auto offset = offsets.rbegin(); offset != offsets.rend(); ++offset) {
+            if (query._limit != 0u && records.size() >= query._limit) {
+                break;
+            }
+            if (decodeRecord(data, size, *offset, record) != 0u &&
+                matchesTime(query, record._time)) {
+                records.push_back(record);
+            }
+        }
+    }
+    std::reverse(records.begin(), records.end());
+    return records;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef LOG_ARCHIVE_H
+#define LOG_ARCHIVE_H
+
+#include "log_buffer.h"
+
+#include <boost/optional.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct LogArchiveQuery {
+    boost::optional<std::chrono::milliseconds> _since;
+    boost::optional<std::chrono::milliseconds> _until;
+    boost::optional<std::string> _participant_name;
+    // the most recent records are returned if the limit is exceeded, 0 means no limit
+    std::size_t _limit = 0u;
+};
+
+// Index of one segment of the archive: the time range of all records and, per participant, the
+// time range and the offsets of its records
+struct LogSegmentIndex {
+    struct Participant {
+        std::chrono::milliseconds _min_time = std::chrono::milliseconds::max();
+        std::chrono::milliseconds _max_time = std::chrono::milliseconds::min();
+        std::vector<std::uint32_t> _offsets;
+    };
+
+    void add(const LogRecord& record, std::uint32_t offset);
+    // false if no record of the segment can match the query
+    bool mayMatch(const LogArchiveQuery& query) const;
+
+    std::uint64_t _record_count = 0u;
+    std::chrono::milliseconds _min_time = std::chrono::milliseconds::max();
+    std::chrono::milliseconds _max_time = std::chrono::milliseconds::min();
+    std::map<std::string, Participant> _participants;
+};
+
+// Appends log records to a directory of segment files. Each record is written length-prefixed,
+// the index of a segment is written next to it when the segment is full or the writer is
+// destroyed. The records are written by a background thread, so adding never waits for the
+// disk.
+class LogArchiveWriter {
+public:
+    static constexpr std::size_t default_segment_size = 16u * 1024u * 1024u;
+    // records exceeding this are dropped until the writer catches up
+    static constexpr std::size_t max_queue_size = 256u * 1024u;
+
+    struct Statistics {
+        std::uint64_t _written = 0u;
+        std::uint64_t _dropped = 0u;
+        std::uint64_t _segments = 0u;
+        std::uint64_t _bytes = 0u;
+    };
+
+    // throws std::runtime_error if the directory or the first segment cannot be created
+    explicit LogArchiveWriter(std::string directory,
+                              std::size_t segment_size = default_segment_size);
+    // writes all added records and the index of the last segment
+    ~LogArchiveWriter();
+
+    LogArchiveWriter(const LogArchiveWriter&) = delete;
+    LogArchiveWriter& operator=(const LogArchiveWriter&) = delete;
+
+    void add(const LogRecord& record);
+    // waits until the records added before are written
+    void flush();
+    Statistics getStatistics() const;
+    const std::string& getDirectory() const;
+
+private:
+    void run();
+    void openSegment();
+    void closeSegment();
+    void write(const LogRecord& record);
+
+    const std::string _directory;
+    const std::size_t _segment_size;
+
+    // only used by the writer thread after construction
+    std::FILE* _segment_file = nullptr;
+    std::string _segment_path;
+    std::uint64_t _next_segment_number = 0u;
+    std::uint32_t _segment_bytes = 0u;
+    LogSegmentIndex _segment_index;
+    std::string _encoded;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _records_added;
+    std::condition_variable _records_written;
+    std::vector<LogRecord> _queue;
+    Statistics _statistics;
+    bool _writing = false;
+    bool _stop = false;
+    std::thread _writer_thread;
+};
+
+// Returns the matching records of the archive in the directory, oldest first. Segments whose
+// index does not match are skipped, the others are read memory-mapped. The index of a segment
+// still written (or not closed) is built by reading the segment.
+// throws std::runtime_error if the directory cannot be read
+std::vector<LogRecord> queryLogArchive(const std::string& directory,
+                                       const LogArchiveQuery& query);
+
+#endif // LOG_ARCHIVE_H
@@ -0,0 +1,127 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "log_batcher.h"
+
+#include <algorithm>
+
+LogBatcher::LogBatcher(Flush flush) : _flush(std::move(flush))
+{
+}
+
+LogBatcher::~LogBatcher()
+{
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        _records.clear();
+    }
+    stop();
+}
+
+void LogBatcher::start(std::size_t max_records, std::chrono::milliseconds max_latency)
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    _max_records = std::max<std::size_t>(max_records, 1u);
+    _max_latency = std::max(max_latency, std::chrono::milliseconds(1));
+    if (_records.size() >= _max_records) {
+        flush();
+    }
+    else if (!_records.empty()) {
+        _deadline = std::min(_deadline, std::chrono::steady_clock::now() + _max_latency);
+        _wake.notify_one();
+    }
+    if (!_started) {
+        _stop = false;
+        _started = true;
+        _timer_thread = std::thread([this]() { run(); });
+    }
+}
+
+void LogBatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        if (!_started) {
+            return;
+        }
+        flush();
+        _started = false;
+        _stop = true;
+    }
+    _wake.notify_one();
+    _timer_thread.join();
+}
+
+bool LogBatcher::isStarted() const
+{
+    return _started;
+}
+
+bool LogBatcher::add(std::chrono::milliseconds time,
+                     fep3::LoggerSeverity severity,
+                     const std::string& participant_name,
+                     const std::string& logger_name,
+                     const std::string& message)
+{
+    return add(LogRecord{time, severity, participant_name, logger_name, message, false, {}});
+}
+
+bool LogBatcher::add(const LogRecord& record)
+{
+    if (!_started) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lck(_mutex);
+    if (!_started) {
+        return false;
+    }
+    if (_records.empty()) {
+        _deadline = std::chrono::steady_clock::now() + _max_latency;
+        _wake.notify_one();
+    }
+    _records.push_back(record);
+    if (_records.size() >= _max_records) {
+        flush();
+    }
+    return true;
+}
+
+void LogBatcher::run()
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    while (!_stop) {
+        if (_records.empty()) {
+            _wake.wait(lck);
+        }
+        else if (_wake.wait_until(lck, _deadline) == std::cv_status::timeout &&
+                 !_records.empty() && std::chrono::steady_clock::now() >= _deadline) {
+            flush();
+        }
+    }
+}
+
+// called with the locked mutex, so batches are passed on in order
+void LogBatcher::flush()
+{
+    if (_records.empty()) {
+        return;
+    }
+    _flush(_records);
+    _records.clear();
+}
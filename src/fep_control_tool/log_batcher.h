@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef LOG_BATCHER_H
+#define LOG_BATCHER_H
+
+#include "log_buffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Collects log records and passes them on in batches, once max_records are collected or the
+// oldest collected record waited max_latency, whichever comes first. The batches are passed on
+// in the order of the records.
+class LogBatcher {
+public:
+    using Flush = std::function<void(const std::vector<LogRecord>& records)>;
+
+    explicit LogBatcher(Flush flush);
+    // the pending records are dropped, call stop() before to pass them on
+    ~LogBatcher();
+
+    LogBatcher(const LogBatcher&) = delete;
+    LogBatcher& operator=(const LogBatcher&) = delete;
+
+    // starts batching or changes the limits, max_records and max_latency must not be 0
+    void start(std::size_t max_records, std::chrono::milliseconds max_latency);
+    // passes on the pending records and stops batching
+    void stop();
+    bool isStarted() const;
+    // returns false if batching is not started, the record is not taken then
+    bool add(std::chrono::milliseconds time,
+             fep3::LoggerSeverity severity,
+             const std::string& participant_name,
+             const std::string& logger_name,
+             const std::string& message);
+    bool add(const LogRecord& record);
+
+private:
+    void run();
+    void flush();
+
+    const Flush _flush;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::vector<LogRecord> _records;
+    std::chrono::steady_clock::time_point _deadline;
+    std::size_t _max_records = 0u;
+    std::chrono::milliseconds _max_latency{0};
+    std::atomic<bool> _started{false};
+    bool _stop = false;
+    std::thread _timer_thread;
+};
+
+#endif // LOG_BATCHER_H
@@ -0,0 +1,194 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "log_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace {
+// layout of a slot: time, severity, truncated flag, the three text lengths, then the texts
+constexpr std::size_t header_size = 16u;
+constexpr std::size_t max_name_size = 64u;
+
+std::size_t roundUpToPowerOfTwo(std::size_t value)
+{
+    std::size_t result = 1u;
+    while (result < value) {
+        result <<= 1u;
+    }
+    return result;
+}
+
+// cuts the text to at most max_size bytes without splitting a utf-8 sequence
+std::size_t truncatedSize(const std::string& text, std::size_t max_size)
+{
+    if (text.size() <= max_size) {
+        return text.size();
+    }
+    std::size_t size = max_size;
+    while (size > 0u && (static_cast<unsigned char>(text[size]) & 0xC0u) == 0x80u) {
+        --size;
+    }
+    return size;
+}
+
+std::uint64_t stableVersion(std::uint64_t sequence)
+{
+    return 2u * (sequence + 1u);
+}
+} // namespace
+
+LogRingBuffer::LogRingBuffer(std::size_t capacity)
+    : _capacity(roundUpToPowerOfTwo(std::max<std::size_t>(capacity, 1u))),
+      _slots(new Slot[_capacity])
+{
+}
+
+void LogRingBuffer::add(std::chrono::milliseconds time,
+                        fep3::LoggerSeverity severity,
+                        const std::string& participant_name,
+                        const std::string& logger_name,
+                        const std::string& message)
+{
+    constexpr std::size_t text_capacity = slot_size - header_size;
+    const auto participant_size = static_cast<std::uint16_t>(
+        truncatedSize(participant_name, max_name_size));
+    const auto logger_size =
+        static_cast<std::uint16_t>(truncatedSize(logger_name, max_name_size));
+    const auto message_size = static_cast<std::uint16_t>(
+        truncatedSize(message, text_capacity - participant_size - logger_size));
+    const bool truncated = participant_size != participant_name.size() ||
+                           logger_size != logger_name.size() || message_size != message.size();
+
+    std::array<char, slot_size> bytes{};
+    const std::int64_t milliseconds = time.count();
+    std::memcpy(bytes.data(), &milliseconds, sizeof(milliseconds));
+    bytes[8] = static_cast<char>(severity);
+    bytes[9] = truncated ? 1 : 0;
+    std::memcpy(bytes.data() + 10, &participant_size, sizeof(participant_size));
+    std::memcpy(bytes.data() + 12, &logger_size, sizeof(logger_size));
+    std::memcpy(bytes.data() + 14, &message_size, sizeof(message_size));
+    char* text = bytes.data() + header_size;
+    text = std::copy_n(participant_name.data(), participant_size, text);
+    text = std::copy_n(logger_name.data(), logger_size, text);
+    std::copy_n(message.data(), message_size, text);
+    if (truncated) {
+        ++_truncated;
+    }
+
+    const std::uint64_t sequence = _next_sequence++;
+    Slot& slot = _slots[sequence & (_capacity - 1u)];
+    std::uint64_t version = slot._version.load(std::memory_order_acquire);
+    for (;;) {
+        if (version >= stableVersion(sequence)) {
+            // a newer record took the slot meanwhile, this one counts as overwritten
+            return;
+        }
+        if (version % 2u == 1u) {
+            // an older record is still being written
+            std::this_thread::yield();
+            version = slot._version.load(std::memory_order_acquire);
+            continue;
+        }
+        if (slot._version.compare_exchange_weak(
+                version, stableVersion(sequence) - 1u, std::memory_order_acq_rel)) {
+            break;
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t index = 0u; index < slot_words; ++index) {
+        std::uint64_t word;
+        std::memcpy(&word, bytes.data() + index * sizeof(word), sizeof(word));
+        slot._words[index].store(word, std::memory_order_relaxed);
+    }
+    slot._version.store(stableVersion(sequence), std::memory_order_release);
+}
+
+bool LogRingBuffer::read(std::uint64_t sequence, LogRecord& record) const
+{
+    const Slot& slot = _slots[sequence & (_capacity - 1u)];
+    if (slot._version.load(std::memory_order_acquire) != stableVersion(sequence)) {
+        return false;
+    }
+    std::array<char, slot_size> bytes;
+    for (std::size_t index = 0u; index < slot_words; ++index) {
+        const std::uint64_t word = slot._words[index].load(std::memory_order_relaxed);
+        std::memcpy(bytes.data() + index * sizeof(word), &word, sizeof(word));
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot._version.load(std::memory_order_relaxed) != stableVersion(sequence)) {
+        return false;
+    }
+
+    std::int64_t milliseconds;
+    std::uint16_t participant_size, logger_size, message_size;
+    std::memcpy(&milliseconds, bytes.data(), sizeof(milliseconds));
+    std::memcpy(&participant_size, bytes.data() + 10, sizeof(participant_size));
+    std::memcpy(&logger_size, bytes.data() + 12, sizeof(logger_size));
+    std::memcpy(&message_size, bytes.data() + 14, sizeof(message_size));
+    const char* text = bytes.data() + header_size;
+    record._time = std::chrono::milliseconds(milliseconds);
+    record._severity = static_cast<fep3::LoggerSeverity>(bytes[8]);
+    record._truncated = bytes[9] != 0;
+    record._participant_name.assign(text, participant_size);
+    record._logger_name.assign(text + participant_size, logger_size);
+    record._message.assign(text + participant_size + logger_size, message_size);
+    return true;
+}
+
+std::vector<LogRecord> LogRingBuffer::query(const LogQuery& query) const
+{
+    const std::uint64_t end = _next_sequence.load(std::memory_order_acquire);
+    const std::uint64_t begin = end > _capacity ? end - _capacity : 0u;
+
+    // walk from the newest record backwards, so the limit keeps the most recent ones
+    std::vector<LogRecord> records;
+    LogRecord record;
+    for (std::uint64_t sequence = end; sequence > begin; --sequence) {
+        if (query._limit != 0u && records.size() >= query._limit) {
+            break;
+        }
+        if (!read(sequence - 1u, record)) {
+            continue;
+        }
+        if ((query._since && record._time < *query._since) ||
+            (query._severity && (record._severity == fep3::LoggerSeverity::off ||
+                                 record._severity > *query._severity)) ||
+            (query._participant_name && record._participant_name != *query._participant_name)) {
+            continue;
+        }
+        records.push_back(record);
+    }
+    std::reverse(records.begin(), records.end());
+    return records;
+}
+
+LogRingBuffer::Statistics LogRingBuffer::getStatistics() const
+{
+    Statistics statistics;
+    statistics._capacity = _capacity;
+    statistics._memory_size = sizeof(LogRingBuffer) + _capacity * sizeof(Slot);
+    statistics._written = _next_sequence;
+    statistics._stored = std::min<std::uint64_t>(statistics._written, _capacity);
+    statistics._overwritten = statistics._written - statistics._stored;
+    statistics._truncated = _truncated;
+    return statistics;
+}
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef LOG_BUFFER_H
+#define LOG_BUFFER_H
+
+#include <fep_system/fep_system.h>
+
+#include <array>
+#include <atomic>
+#include <boost/optional.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct LogRecord {
+    std::chrono::milliseconds _time{0};
+    fep3::LoggerSeverity _severity = fep3::LoggerSeverity::off;
+    std::string _participant_name;
+    std::string _logger_name;
+    std::string _message;
+    // the names or the message did not fit into the slot of the buffer
+    bool _truncated = false;
+    // set for the log messages received from a monitored system, not kept by the buffer
+    std::string _system_name;
+};
+
+struct LogQuery {
+    boost::optional<std::chrono::milliseconds> _since;
+    // only records of this or a higher severity (fatal is the highest)
+    boost::optional<fep3::LoggerSeverity> _severity;
+    boost::optional<std::string> _participant_name;
+    // the most recent records are returned if the limit is exceeded, 0 means no limit
+    std::size_t _limit = 0u;
+};
+
+// Fixed-capacity ring buffer of log records. Adding and querying are lock-free: each record is
+// copied into a slot of fixed size guarded by a sequence number (seqlock), so readers skip
+// records which are overwritten while they read them. Names and messages which do not fit into
+// a slot are truncated.
+class LogRingBuffer {
+public:
+    static constexpr std::size_t slot_size = 512u;
+    static constexpr std::size_t default_capacity = 4096u;
+
+    struct Statistics {
+        std::size_t _capacity = 0u;
+        std::size_t _memory_size = 0u;
+        std::uint64_t _written = 0u;
+        std::uint64_t _stored = 0u;
+        std::uint64_t _overwritten = 0u;
+        std::uint64_t _truncated = 0u;
+    };
+
+    // the capacity is rounded up to a power of two
+    explicit LogRingBuffer(std::size_t capacity = default_capacity);
+
+    void add(std::chrono::milliseconds time,
+             fep3::LoggerSeverity severity,
+             const std::string& participant_name,
+             const std::string& logger_name,
+             const std::string& message);
+    // returns the matching records, oldest first
+    std::vector<LogRecord> query(const LogQuery& query) const;
+    Statistics getStatistics() const;
+
+private:
+    static constexpr std::size_t slot_words = slot_size / sizeof(std::uint64_t);
+
+    struct Slot {
+        // 0: empty, odd: being written, even: 2 * (sequence number of the record + 1)
+        std::atomic<std::uint64_t> _version{0u};
+        std::array<std::atomic<std::uint64_t>, slot_words> _words;
+    };
+
+    bool read(std::uint64_t sequence, LogRecord& record) const;
+
+    const std::size_t _capacity;
+    std::unique_ptr<Slot[]> _slots;
+    std::atomic<std::uint64_t> _next_sequence{0u};
+    std::atomic<std::uint64_t> _truncated{0u};
+};
+
+#endif // LOG_BUFFER_H
@@ -0,0 +1,99 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "log_filter.h"
+
+GlobPattern::GlobPattern(std::string pattern)
+    : _pattern(std::move(pattern)),
+      _has_wildcards(_pattern.find_first_of("*?") != std::string::npos)
+{
+}
+
+bool GlobPattern::matches(const std::string& text) const
+{
+    if (!_has_wildcards) {
+        return text == _pattern;
+    }
+    // on a mismatch, the last '*' takes one more character of the text
+    std::size_t pattern_index = 0u, text_index = 0u;
+    std::size_t star_index = std::string::npos, star_text_index = 0u;
+    while (text_index < text.size()) {
+        if (pattern_index < _pattern.size() &&
+            (_pattern[pattern_index] == '?' || _pattern[pattern_index] == text[text_index])) {
+            ++pattern_index;
+            ++text_index;
+        }
+        else if (pattern_index < _pattern.size() && _pattern[pattern_index] == '*') {
+            star_index = pattern_index++;
+            star_text_index = text_index;
+        }
+        else if (star_index != std::string::npos) {
+            pattern_index = star_index + 1u;
+            text_index = ++star_text_index;
+        }
+        else {
+            return false;
+        }
+    }
+    while (pattern_index < _pattern.size() && _pattern[pattern_index] == '*') {
+        ++pattern_index;
+    }
+    return pattern_index == _pattern.size();
+}
+
+const std::string& GlobPattern::getPattern() const
+{
+    return _pattern;
+}
+
+LogFilter::LogFilter(boost::optional<fep3::LoggerSeverity> min_severity,
+                     boost::optional<std::string> participant_pattern,
+                     boost::optional<std::string> logger_pattern,
+                     boost::optional<std::string> message_regex)
+    : _min_severity(min_severity)
+{
+    if (participant_pattern) {
+        _participant_pattern.emplace(std::move(*participant_pattern));
+    }
+    if (logger_pattern) {
+        _logger_pattern.emplace(std::move(*logger_pattern));
+    }
+    if (message_regex) {
+        _message_regex.emplace(*message_regex, std::regex::ECMAScript | std::regex::optimize);
+    }
+}
+
+bool LogFilter::matches(fep3::LoggerSeverity severity,
+                        const std::string& participant_name,
+                        const std::string& logger_name,
+                        const std::string& message) const
+{
+    // fatal is the highest severity and has the lowest value
+    if (_min_severity &&
+        (severity == fep3::LoggerSeverity::off || severity > *_min_severity)) {
+        return false;
+    }
+    if (_participant_pattern && !_participant_pattern->matches(participant_name)) {
+        return false;
+    }
+    if (_logger_pattern && !_logger_pattern->matches(logger_name)) {
+        return false;
+    }
+    return !_message_regex || std::regex_search(message, *_message_regex);
+}
@@ -0,0 +1,65 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef LOG_FILTER_H
+#define LOG_FILTER_H
+
+#include <fep_system/fep_system.h>
+
+#include <boost/optional.hpp>
+#include <regex>
+#include <string>
+
+// Pattern with the wildcards '*' (any sequence of characters) and '?' (any single character)
+class GlobPattern {
+public:
+    explicit GlobPattern(std::string pattern);
+
+    bool matches(const std::string& text) const;
+    const std::string& getPattern() const;
+
+private:
+    std::string _pattern;
+    // patterns without wildcards are compared as a whole
+    bool _has_wildcards;
+};
+
+// Filter of log messages, built once per subscription and applied to each log message before
+// it is formatted. The cheap criteria are checked first, the regular expression last.
+class LogFilter {
+public:
+    // throws std::regex_error if the regular expression is invalid
+    LogFilter(boost::optional<fep3::LoggerSeverity> min_severity,
+              boost::optional<std::string> participant_pattern,
+              boost::optional<std::string> logger_pattern,
+              boost::optional<std::string> message_regex);
+
+    bool matches(fep3::LoggerSeverity severity,
+                 const std::string& participant_name,
+                 const std::string& logger_name,
+                 const std::string& message) const;
+
+private:
+    boost::optional<fep3::LoggerSeverity> _min_severity;
+    boost::optional<GlobPattern> _participant_pattern;
+    boost::optional<GlobPattern> _logger_pattern;
+    boost::optional<std::regex> _message_regex;
+};
+
+#endif // LOG_FILTER_H
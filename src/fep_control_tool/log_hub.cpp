@@ -0,0 +1,260 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "log_hub.h"
+
+#include "message_writer.h"
+#include "output_buffer.h"
+
+#include <algorithm>
+
+SharedLogRecord::SharedLogRecord(LogRecord record) : _record(std::move(record))
+{
+}
+
+const LogRecord& SharedLogRecord::getRecord() const
+{
+    return _record;
+}
+
+const std::string& SharedLogRecord::getEncoding(Encoding encoding) const
+{
+    const auto index = static_cast<std::size_t>(encoding);
+    std::call_once(_encoded[index], [this, encoding, index]() {
+        std::string& output = _encodings[index];
+        if (encoding == Encoding::text) {
+            // clang-format off
+            formatOutput(output, "    LOG [", getString(_record._severity), "] [",
+                         _record._time.count(), " ms] ", _record._logger_name, "@",
+                         _record._participant_name);
+            // clang-format on
+            if (!_record._system_name.empty()) {
+                appendOutput(output, "@");
+                appendOutput(output, _record._system_name);
+            }
+            appendOutput(output, " :");
+            appendOutput(output, _record._message);
+            appendOutput(output, "\nfep> ");
+            return;
+        }
+        MessageWriter writer;
+        writer.clear(encoding == Encoding::msgpack ? BinaryFormat::msgpack :
+                     encoding == Encoding::cbor    ? BinaryFormat::cbor :
+                                                     BinaryFormat::none);
+        writer.beginObject(_record._system_name.empty() ? 6u : 7u);
+        writer.key("log_type");
+        writer.value("message");
+        writer.key("logger_name");
+        writer.value(_record._logger_name);
+        writer.key("message");
+        writer.value(_record._message);
+        writer.key("participant_name");
+        writer.value(_record._participant_name);
+        writer.key("severity_level");
+        writer.value(getString(_record._severity));
+        if (!_record._system_name.empty()) {
+            writer.key("system_name");
+            writer.value(_record._system_name);
+        }
+        writer.key("timestamp");
+        writer.value(static_cast<std::int64_t>(_record._time.count()));
+        writer.endObject();
+        writer.endMessage();
+        output = writer.str();
+    });
+    return _encodings[index];
+}
+
+SharedLogRecord::Encoding SharedLogRecord::selectEncoding(bool json_mode,
+                                                          BinaryFormat binary_format)
+{
+    if (!json_mode) {
+        return Encoding::text;
+    }
+    switch (binary_format) {
+    case BinaryFormat::msgpack:
+        return Encoding::msgpack;
+    case BinaryFormat::cbor:
+        return Encoding::cbor;
+    default:
+        return Encoding::json;
+    }
+}
+
+LogChannel::LogChannel(std::string system_name) : _system_name(std::move(system_name))
+{
+}
+
+LogChannel::~LogChannel()
+{
+    std::lock_guard<std::mutex> lck(_registration_mutex);
+    unregister();
+}
+
+void LogChannel::subscribe(const fep3::System& system, LogSubscriber& subscriber)
+{
+    std::lock_guard<std::mutex> lck(_registration_mutex);
+    {
+        std::unique_lock<std::shared_mutex> subscribers_lck(_subscribers_mutex);
+        if (std::find(_subscribers.begin(), _subscribers.end(), &subscriber) ==
+            _subscribers.end()) {
+            _subscribers.push_back(&subscriber);
+        }
+    }
+    try {
+        unregister();
+        _system = system;
+        _system->registerMonitoring(*this);
+    }
+    catch (...) {
+        _system.reset();
+        std::unique_lock<std::shared_mutex> subscribers_lck(_subscribers_mutex);
+        _subscribers.erase(std::remove(_subscribers.begin(), _subscribers.end(), &subscriber),
+                           _subscribers.end());
+        throw;
+    }
+}
+
+void LogChannel::unsubscribe(LogSubscriber& subscriber)
+{
+    std::lock_guard<std::mutex> lck(_registration_mutex);
+    bool last_subscriber = false;
+    {
+        std::unique_lock<std::shared_mutex> subscribers_lck(_subscribers_mutex);
+        _subscribers.erase(std::remove(_subscribers.begin(), _subscribers.end(), &subscriber),
+                           _subscribers.end());
+        last_subscriber = _subscribers.empty();
+    }
+    if (last_subscriber) {
+        unregister();
+    }
+}
+
+std::size_t LogChannel::getSubscriberCount() const
+{
+    std::shared_lock<std::shared_mutex> lck(_subscribers_mutex);
+    return _subscribers.size();
+}
+
+const std::string& LogChannel::getSystemName() const
+{
+    return _system_name;
+}
+
+const LogRingBuffer& LogChannel::getLogBuffer() const
+{
+    return _log_buffer;
+}
+
+LogLatency& LogChannel::getLogLatency()
+{
+    return _log_latency;
+}
+
+LogStatistics& LogChannel::getLogStatistics()
+{
+    return _log_statistics;
+}
+
+void LogChannel::setArchive(std::shared_ptr<LogArchiveWriter> archive)
+{
+    std::atomic_store(&_archive, std::move(archive));
+}
+
+std::shared_ptr<LogArchiveWriter> LogChannel::getArchive() const
+{
+    return std::atomic_load(&_archive);
+}
+
+void LogChannel::onLog(std::chrono::milliseconds log_time,
+                       fep3::LoggerSeverity severity_level,
+                       const std::string& participant_name,
+                       const std::string& logger_name,
+                       const std::string& message)
+{
+    const auto delivery_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch());
+    _log_latency.add(participant_name, log_time, delivery_time);
+    _log_buffer.add(log_time, severity_level, participant_name, logger_name, message);
+    _log_statistics.add(log_time, severity_level, participant_name, logger_name, message.size());
+    LogRecord log_record{
+        log_time, severity_level, participant_name, logger_name, message, false, _system_name};
+    if (const auto archive = std::atomic_load(&_archive)) {
+        archive->add(log_record);
+    }
+
+    std::shared_lock<std::shared_mutex> lck(_subscribers_mutex);
+    if (_subscribers.empty()) {
+        return;
+    }
+    const auto record = std::make_shared<const SharedLogRecord>(std::move(log_record));
+    for (auto* subscriber: _subscribers) {
+        subscriber->push(record);
+    }
+}
+
+// called with the locked registration mutex
+void LogChannel::unregister()
+{
+    if (!_system) {
+        return;
+    }
+    try {
+        _system->unregisterMonitoring(*this);
+    }
+    catch (const std::exception&) {
+        // the system may be gone already
+    }
+    _system.reset();
+}
+
+LogHub& LogHub::getInstance()
+{
+    // never destroyed, the channels must not unregister while static objects are destroyed
+    static LogHub* hub = new LogHub();
+    return *hub;
+}
+
+std::shared_ptr<LogChannel> LogHub::getChannel(const std::string& system_name)
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    removeExpiredChannels();
+    auto& weak_channel = _channels[system_name];
+    auto channel = weak_channel.lock();
+    if (!channel) {
+        channel = std::make_shared<LogChannel>(system_name);
+        weak_channel = channel;
+    }
+    return channel;
+}
+
+std::size_t LogHub::getChannelCount()
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    removeExpiredChannels();
+    return _channels.size();
+}
+
+void LogHub::removeExpiredChannels()
+{
+    // the names of all systems ever monitored would be kept otherwise
+    for (auto it = _channels.begin(); it != _channels.end();) {
+        it = it->second.expired() ? _channels.erase(it) : std::next(it);
+    }
+}
@@ -0,0 +1,135 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef LOG_HUB_H
+#define LOG_HUB_H
+
+#include "binary_writer.h"
+#include "log_archive.h"
+#include "log_buffer.h"
+#include "log_latency.h"
+#include "log_statistics.h"
+
+#include <fep_system/fep_system.h>
+
+#include <array>
+#include <boost/optional.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// A log message received once for all sessions. Its encodings are built on first use, so the
+// message is formatted at most once per output format.
+class SharedLogRecord {
+public:
+    enum class Encoding : std::uint8_t { text, json, msgpack, cbor };
+
+    explicit SharedLogRecord(LogRecord record);
+
+    const LogRecord& getRecord() const;
+    // text: the log line followed by the prompt, otherwise the log message of the json mode
+    const std::string& getEncoding(Encoding encoding) const;
+    static Encoding selectEncoding(bool json_mode, BinaryFormat binary_format);
+
+private:
+    static constexpr std::size_t encoding_count = 4u;
+
+    LogRecord _record;
+    mutable std::array<std::once_flag, encoding_count> _encoded;
+    mutable std::array<std::string, encoding_count> _encodings;
+};
+
+class LogSubscriber {
+public:
+    virtual ~LogSubscriber() = default;
+    // called by the threads of fep3_system, must not block
+    virtual void push(std::shared_ptr<const SharedLogRecord> record) = 0;
+};
+
+// Receives the log messages of one system by a single registration and passes them to all
+// subscribed sessions. Keeps the log buffer and the latency of the system for all sessions.
+class LogChannel : public fep3::IEventMonitor {
+public:
+    explicit LogChannel(std::string system_name);
+    ~LogChannel();
+
+    LogChannel(const LogChannel&) = delete;
+    LogChannel& operator=(const LogChannel&) = delete;
+
+    // registers the monitoring again at the given system, so participants added meanwhile are
+    // monitored too
+    void subscribe(const fep3::System& system, LogSubscriber& subscriber);
+    // the monitoring is unregistered with the last subscriber
+    void unsubscribe(LogSubscriber& subscriber);
+    std::size_t getSubscriberCount() const;
+
+    const std::string& getSystemName() const;
+    const LogRingBuffer& getLogBuffer() const;
+    LogLatency& getLogLatency();
+    LogStatistics& getLogStatistics();
+    // the log messages are also written to the archive, nullptr stops archiving
+    void setArchive(std::shared_ptr<LogArchiveWriter> archive);
+    std::shared_ptr<LogArchiveWriter> getArchive() const;
+
+private:
+    void onLog(std::chrono::milliseconds log_time,
+               fep3::LoggerSeverity severity_level,
+               const std::string& participant_name,
+               const std::string& logger_name,
+               const std::string& message) override;
+    void unregister();
+
+    const std::string _system_name;
+    LogRingBuffer _log_buffer;
+    LogLatency _log_latency;
+    LogStatistics _log_statistics;
+    // replaced while log messages are received, so it is accessed atomically
+    std::shared_ptr<LogArchiveWriter> _archive;
+
+    // guards the registration, the system is a copy of the one of the subscribing session
+    std::mutex _registration_mutex;
+    boost::optional<fep3::System> _system;
+    mutable std::shared_mutex _subscribers_mutex;
+    std::vector<LogSubscriber*> _subscribers;
+};
+
+// Process wide registry of the log channels, one per system name
+class LogHub {
+public:
+    static LogHub& getInstance();
+
+    // the channel is kept as long as a session holds it
+    std::shared_ptr<LogChannel> getChannel(const std::string& system_name);
+    // counts the channels held by any session
+    std::size_t getChannelCount();
+
+private:
+    LogHub() = default;
+
+    // called with the mutex locked
+    void removeExpiredChannels();
+
+    std::mutex _mutex;
+    std::map<std::string, std::weak_ptr<LogChannel>> _channels;
+};
+
+#endif // LOG_HUB_H
@@ -0,0 +1,136 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "log_latency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+std::size_t getBucket(std::int64_t latency)
+{
+    std::size_t bucket = 0u;
+    while (bucket + 1u < LatencyHistogram::bucket_count && latency >= (std::int64_t(1) << bucket)) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+template <typename T, typename Compare>
+void exchangeIf(std::atomic<T>& target, T value, Compare compare)
+{
+    T current = target.load(std::memory_order_relaxed);
+    while (compare(value, current) &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+} // namespace
+
+std::int64_t LatencyHistogram::Snapshot::getPercentile(double percentile) const
+{
+    if (_count == 0u) {
+        return 0;
+    }
+    const auto rank = static_cast<std::uint64_t>(
+        std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * static_cast<double>(_count)));
+    std::uint64_t count = 0u;
+    for (std::size_t bucket = 0u; bucket < bucket_count; ++bucket) {
+        count += _buckets[bucket];
+        if (count >= std::max<std::uint64_t>(rank, 1u)) {
+            const std::int64_t upper_bound = getUpperBound(bucket);
+            return upper_bound < 0 ? _max : std::min(upper_bound, _max);
+        }
+    }
+    return _max;
+}
+
+std::int64_t LatencyHistogram::getUpperBound(std::size_t bucket)
+{
+    return bucket + 1u < bucket_count ? std::int64_t(1) << bucket : -1;
+}
+
+void LatencyHistogram::add(std::chrono::milliseconds latency)
+{
+    const std::int64_t value = std::max<std::int64_t>(latency.count(), 0);
+    _buckets[getBucket(value)].fetch_add(1u, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
+    exchangeIf(_min, value, std::less<std::int64_t>());
+    exchangeIf(_max, value, std::greater<std::int64_t>());
+    _count.fetch_add(1u, std::memory_order_release);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::getSnapshot() const
+{
+    // the fields are read one by one, a snapshot taken while adding may be off by some messages
+    Snapshot snapshot;
+    snapshot._count = _count.load(std::memory_order_acquire);
+    if (snapshot._count == 0u) {
+        return snapshot;
+    }
+    snapshot._sum = _sum.load(std::memory_order_relaxed);
+    snapshot._min = _min.load(std::memory_order_relaxed);
+    snapshot._max = _max.load(std::memory_order_relaxed);
+    for (std::size_t bucket = 0u; bucket < bucket_count; ++bucket) {
+        snapshot._buckets[bucket] = _buckets[bucket].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+void LatencyHistogram::reset()
+{
+    _count = 0u;
+    for (auto& bucket: _buckets) {
+        bucket = 0u;
+    }
+    _sum = 0;
+    _min = std::numeric_limits<std::int64_t>::max();
+    _max = 0;
+}
+
+void LogLatency::add(const std::string& participant_name,
+                     std::chrono::milliseconds log_time,
+                     std::chrono::milliseconds delivery_time)
+{
+    const std::int64_t offset = (delivery_time - log_time).count();
+    std::int64_t latency = 0;
+    {
+        std::lock_guard<std::mutex> lck(_offsets_mutex);
+        auto it = _offsets.emplace(participant_name, offset).first;
+        if (offset < it->second) {
+            it->second = offset;
+        }
+        latency = offset - it->second;
+    }
+    _histogram.add(std::chrono::milliseconds(latency));
+}
+
+LatencyHistogram::Snapshot LogLatency::getSnapshot() const
+{
+    return _histogram.getSnapshot();
+}
+
+void LogLatency::reset()
+{
+    {
+        std::lock_guard<std::mutex> lck(_offsets_mutex);
+        _offsets.clear();
+    }
+    _histogram.reset();
+}
@@ -0,0 +1,83 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef LOG_LATENCY_H
+#define LOG_LATENCY_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Histogram of latencies in ms with buckets of powers of two. Adding is lock-free.
+class LatencyHistogram {
+public:
+    // bucket 0 counts latencies below 1 ms, bucket i latencies in [2^(i-1), 2^i) ms,
+    // the last bucket all latencies above
+    static constexpr std::size_t bucket_count = 24u;
+
+    struct Snapshot {
+        std::uint64_t _count = 0u;
+        std::int64_t _sum = 0;
+        std::int64_t _min = 0;
+        std::int64_t _max = 0;
+        std::array<std::uint64_t, bucket_count> _buckets{};
+
+        // upper bound of the bucket holding the given percentile, at most the maximum
+        std::int64_t getPercentile(double percentile) const;
+    };
+
+    // exclusive upper bound of the bucket in ms, the last bucket has none (returns -1)
+    static std::int64_t getUpperBound(std::size_t bucket);
+
+    void add(std::chrono::milliseconds latency);
+    Snapshot getSnapshot() const;
+    void reset();
+
+private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> _buckets{};
+    std::atomic<std::uint64_t> _count{0u};
+    std::atomic<std::int64_t> _sum{0};
+    std::atomic<std::int64_t> _min{std::numeric_limits<std::int64_t>::max()};
+    std::atomic<std::int64_t> _max{0};
+};
+
+// Measures how long log messages take from the participant to fep_control. The clocks of the
+// participants are not synchronized with the local clock (and may even be simulation time), so
+// the offset between both is estimated per participant as the smallest difference seen so far.
+// The latency is the delay of a message relative to the fastest delivered message.
+class LogLatency {
+public:
+    void add(const std::string& participant_name,
+             std::chrono::milliseconds log_time,
+             std::chrono::milliseconds delivery_time);
+    LatencyHistogram::Snapshot getSnapshot() const;
+    void reset();
+
+private:
+    std::mutex _offsets_mutex;
+    std::map<std::string, std::int64_t> _offsets;
+    LatencyHistogram _histogram;
+};
+
+#endif // LOG_LATENCY_H
@@ -0,0 +1,149 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "log_rate_limiter.h"
+
+#include <algorithm>
+
+void LogRateLimiter::setLimit(const LogRateLimit& limit)
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    _limit = limit;
+    _limit._sample_every = std::max<std::size_t>(_limit._sample_every, 1u);
+    // the buckets start full with the new limit
+    for (auto& participant: _participants) {
+        participant.second._tokens = getBurst();
+        participant.second._sample_counter = 0u;
+    }
+    _limited = _limit._rate > 0.0 || _limit._sample_every > 1u;
+}
+
+LogRateLimit LogRateLimiter::getLimit() const
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    return _limit;
+}
+
+bool LogRateLimiter::isLimited() const
+{
+    return _limited;
+}
+
+bool LogRateLimiter::admit(const std::string& participant_name,
+                           std::chrono::milliseconds log_time,
+                           Clock::time_point now)
+{
+    if (!_limited) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lck(_mutex);
+    auto it = _participants.find(participant_name);
+    if (it == _participants.end()) {
+        it = _participants.emplace(participant_name, Participant()).first;
+        it->second._tokens = getBurst();
+        it->second._last_refill = now;
+        it->second._counters._participant_name = participant_name;
+    }
+    auto& participant = it->second;
+
+    bool passed = true;
+    if (_limit._sample_every > 1u && participant._sample_counter++ % _limit._sample_every != 0u) {
+        ++participant._counters._sampled_out;
+        passed = false;
+    }
+    else if (_limit._rate > 0.0) {
+        const std::chrono::duration<double> elapsed = now - participant._last_refill;
+        participant._tokens =
+            std::min(getBurst(), participant._tokens + elapsed.count() * _limit._rate);
+        participant._last_refill = now;
+        if (participant._tokens < 1.0) {
+            ++participant._counters._rate_limited;
+            passed = false;
+        }
+        else {
+            participant._tokens -= 1.0;
+        }
+    }
+
+    if (passed) {
+        ++participant._counters._passed;
+    }
+    else {
+        ++participant._dropped_since_summary;
+        participant._last_dropped_log_time = log_time;
+        ++_pending_drops;
+    }
+    return passed;
+}
+
+std::vector<LogRateLimiter::DropSummary> LogRateLimiter::takeDropSummaries(Clock::time_point now,
+                                                                           bool force)
+{
+    std::vector<DropSummary> summaries;
+    if (_pending_drops == 0u) {
+        return summaries;
+    }
+    std::lock_guard<std::mutex> lck(_mutex);
+    if (!force && now < _next_summary) {
+        return summaries;
+    }
+    for (auto& participant: _participants) {
+        if (participant.second._dropped_since_summary != 0u) {
+            summaries.push_back(DropSummary{participant.first,
+                                            participant.second._dropped_since_summary,
+                                            participant.second._last_dropped_log_time});
+            participant.second._dropped_since_summary = 0u;
+        }
+    }
+    _pending_drops = 0u;
+    _next_summary = now + _limit._summary_interval;
+    return summaries;
+}
+
+boost::optional<LogRateLimiter::Clock::time_point> LogRateLimiter::getSummaryDueTime() const
+{
+    if (_pending_drops == 0u) {
+        return boost::none;
+    }
+    std::lock_guard<std::mutex> lck(_mutex);
+    return _next_summary;
+}
+
+std::vector<LogRateLimiter::Counters> LogRateLimiter::getCounters() const
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    std::vector<Counters> counters;
+    for (const auto& participant: _participants) {
+        counters.push_back(participant.second._counters);
+    }
+    return counters;
+}
+
+void LogRateLimiter::resetCounters()
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    for (auto& participant: _participants) {
+        participant.second._counters = Counters{participant.first};
+    }
+}
+
+double LogRateLimiter::getBurst() const
+{
+    return _limit._burst != 0u ? static_cast<double>(_limit._burst) : std::max(_limit._rate, 1.0);
+}
@@ -0,0 +1,98 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef LOG_RATE_LIMITER_H
+#define LOG_RATE_LIMITER_H
+
+#include <boost/optional.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct LogRateLimit {
+    // messages per second of each participant, 0 means no limit
+    double _rate = 0.0;
+    // messages a participant may send at once, 0 means as many as per second
+    std::size_t _burst = 0u;
+    // only every n-th message of a participant is passed, 1 passes all
+    std::size_t _sample_every = 1u;
+    std::chrono::milliseconds _summary_interval{1000};
+};
+
+// Limits the log messages of each participant by a token bucket and 1-in-N sampling and counts
+// the dropped messages. Without limit, messages are passed without locking and not counted.
+class LogRateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Counters {
+        std::string _participant_name;
+        std::uint64_t _passed = 0u;
+        std::uint64_t _rate_limited = 0u;
+        std::uint64_t _sampled_out = 0u;
+    };
+    struct DropSummary {
+        std::string _participant_name;
+        std::uint64_t _dropped = 0u;
+        // of the last dropped message, in the time of the participant
+        std::chrono::milliseconds _log_time{0};
+    };
+
+    void setLimit(const LogRateLimit& limit);
+    LogRateLimit getLimit() const;
+    bool isLimited() const;
+
+    // returns false if the message is to be dropped
+    bool admit(const std::string& participant_name,
+               std::chrono::milliseconds log_time,
+               Clock::time_point now);
+    // the messages dropped since the last summary, at most once per summary interval
+    // unless forced
+    std::vector<DropSummary> takeDropSummaries(Clock::time_point now, bool force = false);
+    // from when on the messages dropped meanwhile are summarized, none if none were dropped
+    boost::optional<Clock::time_point> getSummaryDueTime() const;
+    std::vector<Counters> getCounters() const;
+    void resetCounters();
+
+private:
+    struct Participant {
+        double _tokens = 0.0;
+        Clock::time_point _last_refill;
+        std::uint64_t _sample_counter = 0u;
+        Counters _counters;
+        std::uint64_t _dropped_since_summary = 0u;
+        std::chrono::milliseconds _last_dropped_log_time{0};
+    };
+
+    double getBurst() const;
+
+    mutable std::mutex _mutex;
+    LogRateLimit _limit;
+    std::map<std::string, Participant> _participants;
+    Clock::time_point _next_summary;
+    std::atomic<bool> _limited{false};
+    // dropped messages not yet summarized, checked without locking
+    std::atomic<std::uint64_t> _pending_drops{0u};
+};
+
+#endif // LOG_RATE_LIMITER_H
@@ -0,0 +1,162 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+
+#include "log_statistics.h"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
+namespace {
+std::size_t getHash(fep3::LoggerSeverity severity,
+                    const std::string& participant_name,
+                    const std::string& logger_name)
+{
+    std::size_t hash = std::hash<std::string>()(participant_name);
+    hash ^= std::hash<std::string>()(logger_name) + 0x9E3779B97F4A7C15u + (hash << 6u) +
+            (hash >> 2u);
+    return hash * 31u + static_cast<std::size_t>(severity);
+}
+} // namespace
+
+LogStatistics::Entry::Entry(std::size_t hash,
+                            fep3::LoggerSeverity severity,
+                            const std::string& participant_name,
+                            const std::string& logger_name)
+    : _hash(hash),
+      _severity(severity),
+      _participant_name(participant_name),
+      _logger_name(logger_name)
+{
+}
+
+LogStatistics::~LogStatistics()
+{
+    for (auto& slot: _slots) {
+        delete slot.load(std::memory_order_relaxed);
+    }
+}
+
+void LogStatistics::add(std::chrono::milliseconds log_time,
+                        fep3::LoggerSeverity severity,
+                        const std::string& participant_name,
+                        const std::string& logger_name,
+                        std::size_t message_size)
+{
+    const std::size_t hash = getHash(severity, participant_name, logger_name);
+    Entry* entry = findOrInsert(hash, severity, participant_name, logger_name);
+    if (entry == nullptr) {
+        _overflow.fetch_add(1u, std::memory_order_relaxed);
+        return;
+    }
+    entry->_count.fetch_add(1u, std::memory_order_relaxed);
+    entry->_bytes.fetch_add(message_size, std::memory_order_relaxed);
+    entry->_last_seen.store(log_time.count(), std::memory_order_relaxed);
+}
+
+// returns nullptr if the key is new and the table is full
+LogStatistics::Entry* LogStatistics::findOrInsert(std::size_t hash,
+                                                  fep3::LoggerSeverity severity,
+                                                  const std::string& participant_name,
+                                                  const std::string& logger_name)
+{
+    const auto matches = [&](const Entry* entry) {
+        return entry->_hash == hash && entry->_severity == severity &&
+               entry->_participant_name == participant_name &&
+               entry->_logger_name == logger_name;
+    };
+
+    Entry* new_entry = nullptr;
+    for (std::size_t probe = 0u; probe < capacity; ++probe) {
+        auto& slot = _slots[(hash + probe) & (capacity - 1u)];
+        Entry* entry = slot.load(std::memory_order_acquire);
+        if (entry == nullptr) {
+            if (new_entry == nullptr) {
+                if (_entry_count.fetch_add(1u, std::memory_order_relaxed) >= max_entries) {
+                    _entry_count.fetch_sub(1u, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                new_entry = new Entry(hash, severity, participant_name, logger_name);
+            }
+            if (slot.compare_exchange_strong(entry, new_entry, std::memory_order_acq_rel)) {
+                return new_entry;
+            }
+            // another thread claimed the slot meanwhile, entry is its entry now
+        }
+        if (matches(entry)) {
+            if (new_entry != nullptr) {
+                delete new_entry;
+                _entry_count.fetch_sub(1u, std::memory_order_relaxed);
+            }
+            return entry;
+        }
+    }
+    // not reached as the table is never full
+    if (new_entry != nullptr) {
+        delete new_entry;
+        _entry_count.fetch_sub(1u, std::memory_order_relaxed);
+    }
+    return nullptr;
+}
+
+LogStatistics::Snapshot LogStatistics::getSnapshot() const
+{
+    Snapshot snapshot;
+    for (const auto& slot: _slots) {
+        const Entry* entry = slot.load(std::memory_order_acquire);
+        if (entry == nullptr) {
+            continue;
+        }
+        const std::uint64_t count = entry->_count.load(std::memory_order_relaxed);
+        if (count == 0u) {
+            continue;
+        }
+        snapshot._counters.push_back(
+            Counters{entry->_participant_name,
+                     entry->_logger_name,
+                     entry->_severity,
+                     count,
+                     entry->_bytes.load(std::memory_order_relaxed),
+                     std::chrono::milliseconds(entry->_last_seen.load(std::memory_order_relaxed))});
+    }
+    std::sort(snapshot._counters.begin(),
+              snapshot._counters.end(),
+              [](const Counters& left, const Counters& right) {
+                  if (left._count != right._count) {
+                      return left._count > right._count;
+                  }
+                  return std::tie(left._participant_name, left._logger_name, left._severity) <
+                         std::tie(right._participant_name, right._logger_name, right._severity);
+              });
+    snapshot._overflow = _overflow.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void LogStatistics::reset()
+{
+    for (auto& slot: _slots) {
+        Entry* entry = slot.load(std::memory_order_acquire);
+        if (entry != nullptr) {
+            entry->_count.store(0u, std::memory_order_relaxed);
+            entry->_bytes.store(0u, std::memory_order_relaxed);
+        }
+    }
+    _overflow.store(0u, std::memory_order_relaxed);
+}
@@ -0,0 +1,102 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+
+#ifndef LOG_STATISTICS_H
+#define LOG_STATISTICS_H
+
+#include <fep_system/fep_system.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Counts the log messages per participant, logger and severity. Counting is lock-free: the
+// entries are kept in a hash table of fixed capacity whose slots are claimed by compare and
+// swap, so the counters of a known key are updated by atomic increments only. Entries are never
+// removed, resetting sets their counters to zero.
+class LogStatistics {
+public:
+    static constexpr std::size_t capacity = 1024u;
+    // messages of further keys are counted as overflow only, so probing always ends
+    static constexpr std::size_t max_entries = capacity * 3u / 4u;
+
+    struct Counters {
+        std::string _participant_name;
+        std::string _logger_name;
+        fep3::LoggerSeverity _severity = fep3::LoggerSeverity::off;
+        std::uint64_t _count = 0u;
+        // size of the messages
+        std::uint64_t _bytes = 0u;
+        // time of the participant when it logged the last message
+        std::chrono::milliseconds _last_seen{0};
+    };
+
+    struct Snapshot {
+        // ordered by count, most messages first
+        std::vector<Counters> _counters;
+        // messages of keys which did not fit into the table
+        std::uint64_t _overflow = 0u;
+    };
+
+    LogStatistics() = default;
+    ~LogStatistics();
+
+    LogStatistics(const LogStatistics&) = delete;
+    LogStatistics& operator=(const LogStatistics&) = delete;
+
+    void add(std::chrono::milliseconds log_time,
+             fep3::LoggerSeverity severity,
+             const std::string& participant_name,
+             const std::string& logger_name,
+             std::size_t message_size);
+    // only keys with messages since the last reset
+    Snapshot getSnapshot() const;
+    void reset();
+
+private:
+    struct Entry {
+        Entry(std::size_t hash,
+              fep3::LoggerSeverity severity,
+              const std::string& participant_name,
+              const std::string& logger_name);
+
+        const std::size_t _hash;
+        const fep3::LoggerSeverity _severity;
+        const std::string _participant_name;
+        const std::string _logger_name;
+        std::atomic<std::uint64_t> _count{0u};
+        std::atomic<std::uint64_t> _bytes{0u};
+        std::atomic<std::int64_t> _last_seen{0};
+    };
+
+    Entry* findOrInsert(std::size_t hash,
+                        fep3::LoggerSeverity severity,
+                        const std::string& participant_name,
+                        const std::string& logger_name);
+
+    std::array<std::atomic<Entry*>, capacity> _slots{};
+    std::atomic<std::size_t> _entry_count{0u};
+    std::atomic<std::uint64_t> _overflow{0u};
+};
+
+#endif // LOG_STATISTICS_H
@@ -0,0 +1,184 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+#pragma once
+#include "binary_writer.h"
+#include "json_writer.h"
+
+#include <json/json.h>
+
+// Writes one answer or log message either as compact json or in one of the binary formats.
+// The calls are forwarded to the writer of the format selected on clear.
+class MessageWriter {
+public:
+    void clear(BinaryFormat format)
+    {
+        _format = format;
+        if (isBinary()) {
+            _binary.clear(format);
+        }
+        else {
+            _json.clear();
+        }
+    }
+
+    bool isBinary() const
+    {
+        return _format != BinaryFormat::none;
+    }
+
+    void beginObject(std::size_t size)
+    {
+        isBinary() ? _binary.beginObject(size) : _json.beginObject(size);
+    }
+
+    void endObject()
+    {
+        isBinary() ? _binary.endObject() : _json.endObject();
+    }
+
+    void beginArray(std::size_t size)
+    {
+        isBinary() ? _binary.beginArray(size) : _json.beginArray(size);
+    }
+
+    void endArray()
+    {
+        isBinary() ? _binary.endArray() : _json.endArray();
+    }
+
+    void key(std::string_view name)
+    {
+        isBinary() ? _binary.key(name) : _json.key(name);
+    }
+
+    void value(std::string_view text)
+    {
+        isBinary() ? _binary.value(text) : _json.value(text);
+    }
+
+    void value(const char* text)
+    {
+        value(std::string_view(text));
+    }
+
+    void value(const std::string& text)
+    {
+        value(std::string_view(text));
+    }
+
+    void value(std::int64_t number)
+    {
+        isBinary() ? _binary.value(number) : _json.value(number);
+    }
+
+    void value(bool flag)
+    {
+        isBinary() ? _binary.value(flag) : _json.value(flag);
+    }
+
+    void nullValue()
+    {
+        isBinary() ? _binary.nullValue() : _json.nullValue();
+    }
+
+    // writes a json document, object members in the order of Json::Value (ascending keys)
+    void value(const Json::Value& json)
+    {
+        if (!isBinary()) {
+            thread_local Json::StreamWriterBuilder builder = []() {
+                Json::StreamWriterBuilder compact_builder;
+                compact_builder.settings_["indentation"] = "";
+                return compact_builder;
+            }();
+            _json.rawValue(Json::writeString(builder, json));
+            return;
+        }
+        switch (json.type()) {
+        case Json::nullValue:
+            _binary.nullValue();
+            break;
+        case Json::intValue:
+            _binary.value(static_cast<std::int64_t>(json.asInt64()));
+            break;
+        case Json::uintValue:
+            _binary.value(static_cast<std::uint64_t>(json.asUInt64()));
+            break;
+        case Json::realValue:
+            _binary.value(json.asDouble());
+            break;
+        case Json::stringValue: {
+            const char* begin = nullptr;
+            const char* end = nullptr;
+            json.getString(&begin, &end);
+            _binary.value(std::string_view(begin, static_cast<std::size_t>(end - begin)));
+            break;
+        }
+        case Json::booleanValue:
+            _binary.value(json.asBool());
+            break;
+        case Json::arrayValue:
+            _binary.beginArray(json.size());
+            for (const auto& element: json) {
+                value(element);
+            }
+            _binary.endArray();
+            break;
+        case Json::objectValue:
+            _binary.beginObject(json.size());
+            for (auto it = json.begin(); it != json.end(); ++it) {
+                _binary.key(it.name());
+                value(*it);
+            }
+            _binary.endObject();
+            break;
+        }
+    }
+
+    // appends a complete message written before, without its terminating new line
+    void rawMessage(std::string_view message)
+    {
+        if (isBinary()) {
+            _binary.rawValue(message);
+        }
+        else {
+            if (!message.empty() && message.back() == '\n') {
+                message.remove_suffix(1u);
+            }
+            _json.rawValue(message);
+        }
+    }
+
+    // json messages are terminated by a new line, binary messages are self-delimiting
+    void endMessage()
+    {
+        if (!isBinary()) {
+            _json.newLine();
+        }
+    }
+
+    const std::string& str() const
+    {
+        return isBinary() ? _binary.str() : _json.str();
+    }
+
+private:
+    BinaryFormat _format = BinaryFormat::none;
+    JsonWriter _json;
+    BinaryWriter _binary;
+};
@@ -23,11 +23,158 @@ You may add additional accurate notices of copyright ownership.
 #include "fep_control.h"
 #include "helper.h"
 
-#include <json/json.h>
-#include <sstream>
+LogDelivery::~LogDelivery()
+{
+    stop();
+}
+
+void LogDelivery::start()
+{
+    std::lock_guard<std::mutex> lck(_queue_mutex);
+    if (!_delivery_thread.joinable()) {
+        _stopping = false;
+        _delivery_thread = std::thread([this]() { run(); });
+    }
+}
+
+void LogDelivery::stop()
+{
+    {
+        std::lock_guard<std::mutex> lck(_queue_mutex);
+        if (!_delivery_thread.joinable()) {
+            return;
+        }
+        _stopping = true;
+    }
+    _queue_changed.notify_one();
+    _delivery_thread.join();
+}
+
+void LogDelivery::flush()
+{
+    std::unique_lock<std::mutex> lck(_queue_mutex);
+    _queue_processed.wait(lck, [this]() { return _queue.empty() && !_processing; });
+}
+
+void LogDelivery::push(Monitor& monitor, std::shared_ptr<const SharedLogRecord> record)
+{
+    {
+        std::lock_guard<std::mutex> lck(_queue_mutex);
+        if (!_delivery_thread.joinable()) {
+            return;
+        }
+        if (_queue.size() >= max_queue_size) {
+            ++monitor._overflows;
+            return;
+        }
+        _queue.emplace_back(&monitor, std::move(record));
+    }
+    _queue_changed.notify_one();
+}
+
+void LogDelivery::addMonitor(Monitor& monitor)
+{
+    std::lock_guard<std::mutex> lck(_queue_mutex);
+    _monitors.insert(&monitor);
+}
+
+void LogDelivery::removeMonitor(Monitor& monitor)
+{
+    std::lock_guard<std::mutex> lck(_queue_mutex);
+    _monitors.erase(&monitor);
+}
 
-Monitor::Monitor(FepControl& parent, bool json_mode) : _parent(parent), _json_mode(json_mode)
+void LogDelivery::run()
 {
+    std::unique_lock<std::mutex> lck(_queue_mutex);
+    const auto has_work = [this]() { return _stopping || !_queue.empty(); };
+    for (;;) {
+        const auto summary_due_time = _queue.empty() ? getSummaryDueTime() : boost::none;
+        if (!summary_due_time) {
+            _queue_changed.wait(lck, has_work);
+        }
+        else if (!_queue_changed.wait_until(lck, *summary_due_time, has_work)) {
+            // no log message followed the dropped ones
+            writeDropSummaries(lck);
+            continue;
+        }
+        if (_queue.empty()) {
+            // all log messages received before stopping are written
+            return;
+        }
+        auto entry = std::move(_queue.front());
+        _queue.pop_front();
+        _processing = true;
+        lck.unlock();
+
+        entry.first->process(*entry.second);
+        entry.second.reset();
+        lck.lock();
+        _processing = false;
+        if (_queue.empty()) {
+            _queue_processed.notify_all();
+        }
+    }
+}
+
+boost::optional<LogRateLimiter::Clock::time_point> LogDelivery::getSummaryDueTime() const
+{
+    boost::optional<LogRateLimiter::Clock::time_point> due_time;
+    for (const Monitor* monitor: _monitors) {
+        const auto monitor_due_time = monitor->_rate_limiter.getSummaryDueTime();
+        if (monitor_due_time && (!due_time || *monitor_due_time < *due_time)) {
+            due_time = monitor_due_time;
+        }
+    }
+    return due_time;
+}
+
+void LogDelivery::writeDropSummaries(std::unique_lock<std::mutex>& lck)
+{
+    const std::vector<Monitor*> monitors(_monitors.begin(), _monitors.end());
+    _processing = true;
+    lck.unlock();
+
+    for (Monitor* monitor: monitors) {
+        monitor->writeDropSummaries(false);
+    }
+    lck.lock();
+    _processing = false;
+    if (_queue.empty()) {
+        _queue_processed.notify_all();
+    }
+}
+
+Monitor::Monitor(FepControl& parent, bool json_mode, std::shared_ptr<LogChannel> channel)
+    : _json_mode(json_mode), _parent(parent), _channel(std::move(channel))
+{
+}
+
+Monitor::~Monitor()
+{
+    stop();
+}
+
+void Monitor::start(const fep3::System& system)
+{
+    _parent.getLogDelivery().start();
+    _parent.getLogDelivery().addMonitor(*this);
+    _channel->subscribe(system, *this);
+    _started = true;
+}
+
+void Monitor::stop()
+{
+    _started = false;
+    _channel->unsubscribe(*this);
+    _parent.getLogDelivery().removeMonitor(*this);
+    // no log message is pushed anymore, the ones received before are written
+    _parent.getLogDelivery().flush();
+}
+
+bool Monitor::isStarted() const
+{
+    return _started;
 }
 
 void Monitor::setJsonMode(const bool json_mode)
@@ -35,25 +182,100 @@ void Monitor::setJsonMode(const bool json_mode)
     _json_mode = json_mode;
 }
 
-void Monitor::onLog(std::chrono::milliseconds,
-                    fep3::LoggerSeverity severity_level,
-                    const std::string& participant_name,
-                    const std::string& logger_name, // depends on the Category ...
-                    const std::string& message)
+void Monitor::setFilter(std::shared_ptr<const LogFilter> filter)
+{
+    std::atomic_store(&_filter, std::move(filter));
+}
+
+const LogRingBuffer& Monitor::getLogBuffer() const
 {
-    if (_json_mode) {
-        Json::Value log;
-        log["log_type"] = "message";
-        log["severity_level"] = getString(severity_level);
-        log["participant_name"] = participant_name;
-        log["logger_name"] = logger_name;
-        log["message"] = message;
-        _parent.writeOutput(_builder.convertJson(log), "\n");
+    return _channel->getLogBuffer();
+}
+
+LogLatency& Monitor::getLogLatency()
+{
+    return _channel->getLogLatency();
+}
+
+LogStatistics& Monitor::getLogStatistics()
+{
+    return _channel->getLogStatistics();
+}
+
+void Monitor::setArchive(std::shared_ptr<LogArchiveWriter> archive)
+{
+    _channel->setArchive(std::move(archive));
+}
+
+std::shared_ptr<LogArchiveWriter> Monitor::getArchive() const
+{
+    return _channel->getArchive();
+}
+
+LogRateLimiter& Monitor::getRateLimiter()
+{
+    return _rate_limiter;
+}
+
+void Monitor::writeDropSummaries(bool force)
+{
+    for (const auto& summary:
+         _rate_limiter.takeDropSummaries(std::chrono::steady_clock::now(), force)) {
+        writeLog(SharedLogRecord(LogRecord{summary._log_time,
+                                           fep3::LoggerSeverity::warning,
+                                           summary._participant_name,
+                                           "fep_control",
+                                           "dropped " + std::to_string(summary._dropped) +
+                                               " messages from " + summary._participant_name,
+                                           false,
+                                           _channel->getSystemName()}));
+    }
+}
+
+void Monitor::push(std::shared_ptr<const SharedLogRecord> record)
+{
+    _parent.getLogDelivery().push(*this, std::move(record));
+}
+
+void Monitor::process(const SharedLogRecord& shared_record)
+{
+    const auto& record = shared_record.getRecord();
+    if (const std::uint64_t overflows = _overflows.exchange(0u)) {
+        const auto& system_name = _channel->getSystemName();
+        writeLog(SharedLogRecord(LogRecord{record._time,
+                                           fep3::LoggerSeverity::warning,
+                                           system_name,
+                                           "fep_control",
+                                           "dropped " + std::to_string(overflows) +
+                                               " messages of " + system_name +
+                                               ", the output is too slow",
+                                           false,
+                                           system_name}));
     }
-    else {
-        // clang-format off
-        _parent.writeOutput("    LOG [", getString(severity_level), "] ",
-                            logger_name, "@", participant_name, " :", message, "\n", "fep> ");
-        // clang-format on
+    const auto filter = std::atomic_load(&_filter);
+    if (filter && !filter->matches(record._severity,
+                                   record._participant_name,
+                                   record._logger_name,
+                                   record._message)) {
+        return;
+    }
+    // dropped messages are reported by a summary once per interval
+    const bool admitted = _rate_limiter.admit(
+        record._participant_name, record._time, std::chrono::steady_clock::now());
+    writeDropSummaries(false);
+    if (admitted) {
+        writeLog(shared_record);
+    }
+}
+
+void Monitor::writeLog(const SharedLogRecord& shared_record)
+{
+    const auto& record = shared_record.getRecord();
+    const bool json_mode = _json_mode;
+    if (json_mode && _parent.getLogBatcher().add(record)) {
+        return;
     }
+    // the encoding is shared by all sessions using the same format
+    _parent.writeOutput(shared_record.getEncoding(
+        SharedLogRecord::selectEncoding(json_mode, _parent.getBinaryFormat())));
 }
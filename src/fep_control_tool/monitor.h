@@ -23,28 +23,112 @@ You may add additional accurate notices of copyright ownership.
 
 #include <fep_system/fep_system.h>
 #include "helper.h"
+#include "log_filter.h"
+#include "log_hub.h"
+#include "log_rate_limiter.h"
 
-namespace Json {
-class Value;
-}
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
 
 class FepControl;
+class Monitor;
 
-class Monitor : public fep3::IEventMonitor {
+// Writes the log messages of all monitors of a session by one thread in the order they are
+// received, so the log messages of several systems form one stream. A slow session does not
+// delay the other ones.
+class LogDelivery {
 public:
-    Monitor(FepControl& parent, bool json_mode);
+    LogDelivery() = default;
+    // the log messages received before are written
+    ~LogDelivery();
+
+    LogDelivery(const LogDelivery&) = delete;
+    LogDelivery& operator=(const LogDelivery&) = delete;
+
+    // starts the delivery thread if not running
+    void start();
+    // writes the log messages received before and stops the delivery thread
+    void stop();
+    // waits until the log messages received before are written
+    void flush();
+    // called by the threads of fep3_system, does not block
+    void push(Monitor& monitor, std::shared_ptr<const SharedLogRecord> record);
+    // the drop summaries of the monitor are written when due, even if no log message follows
+    void addMonitor(Monitor& monitor);
+    // flush afterwards, the delivery thread may still write a summary of the monitor until then
+    void removeMonitor(Monitor& monitor);
+
+private:
+    // log messages exceeding this are dropped until the session catches up
+    static constexpr std::size_t max_queue_size = 64u * 1024u;
+
+    void run();
+    // called with the queue mutex locked
+    boost::optional<LogRateLimiter::Clock::time_point> getSummaryDueTime() const;
+    void writeDropSummaries(std::unique_lock<std::mutex>& lck);
+
+    std::mutex _queue_mutex;
+    std::condition_variable _queue_changed;
+    std::condition_variable _queue_processed;
+    std::deque<std::pair<Monitor*, std::shared_ptr<const SharedLogRecord>>> _queue;
+    bool _processing = false;
+    bool _stopping = false;
+    std::set<Monitor*> _monitors;
+    std::thread _delivery_thread;
+};
+
+// The subscription of a session to the log messages of a system. The log messages are received
+// by the shared channel of the system and written by the log delivery of the session.
+class Monitor : public LogSubscriber {
+public:
+    Monitor(FepControl& parent, bool json_mode, std::shared_ptr<LogChannel> channel);
+    ~Monitor();
+
+    // subscribes to the log messages of the given system
+    void start(const fep3::System& system);
+    // writes the log messages received before and unsubscribes
+    void stop();
+    bool isStarted() const;
     void setJsonMode(const bool json_mode);
+    // only matching log messages are written, nullptr writes all
+    void setFilter(std::shared_ptr<const LogFilter> filter);
+    // keeps the most recent log messages of the monitored system
+    const LogRingBuffer& getLogBuffer() const;
+    // delivery latency of the log messages of the monitored system
+    LogLatency& getLogLatency();
+    // counts the log messages of the monitored system per participant, logger and severity
+    LogStatistics& getLogStatistics();
+    // the archive of the log messages of the monitored system, shared by all sessions
+    void setArchive(std::shared_ptr<LogArchiveWriter> archive);
+    std::shared_ptr<LogArchiveWriter> getArchive() const;
+    // limits the log messages written per participant
+    LogRateLimiter& getRateLimiter();
+    // writes a summary of the messages dropped by the rate limiter for each participant,
+    // without force only once per summary interval; the log delivery calls it when due
+    void writeDropSummaries(bool force);
+
+    void push(std::shared_ptr<const SharedLogRecord> record) override;
 
 private:
-    void onLog(std::chrono::milliseconds,
-               fep3::LoggerSeverity severity_level,
-               const std::string& participant_name,
-               const std::string& logger_name,
-               const std::string& message) override;
+    friend class LogDelivery;
+
+    void process(const SharedLogRecord& record);
+    void writeLog(const SharedLogRecord& record);
 
-    bool _json_mode;
+    std::atomic<bool> _json_mode;
+    std::atomic<bool> _started{false};
     FepControl& _parent;
-    CompactJsonStream _builder;
+    const std::shared_ptr<LogChannel> _channel;
+    LogRateLimiter _rate_limiter;
+    // replaced while log messages are received, so it is accessed atomically
+    std::shared_ptr<const LogFilter> _filter;
+    // log messages dropped by the log delivery, reported with the next one written
+    std::atomic<std::uint64_t> _overflows{0u};
 };
 
 #endif // MONITOR_H
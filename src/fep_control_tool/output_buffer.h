@@ -0,0 +1,62 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+#pragma once
+#include <charconv>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Appends the text of value to output, the result is the same as of 'stream << value'.
+// Strings, characters and integers are appended directly, all other types are formatted by
+// their stream operator.
+template <typename T>
+void appendOutput(std::string& output, const T& value)
+{
+    using Type = std::decay_t<T>;
+    if constexpr (std::is_convertible<const T&, std::string_view>::value) {
+        const std::string_view text(value);
+        output.append(text.data(), text.size());
+    }
+    else if constexpr (std::is_same<Type, bool>::value) {
+        output += value ? '1' : '0';
+    }
+    else if constexpr (std::is_same<Type, char>::value || std::is_same<Type, signed char>::value ||
+                       std::is_same<Type, unsigned char>::value) {
+        output += static_cast<char>(value);
+    }
+    else if constexpr (std::is_integral<Type>::value) {
+        char digits[24];
+        const auto result = std::to_chars(std::begin(digits), std::end(digits), value);
+        output.append(digits, result.ptr);
+    }
+    else {
+        std::ostringstream stream;
+        stream << value;
+        output += stream.str();
+    }
+}
+
+// concatenates the text of all args into output
+template <typename... Args>
+void formatOutput(std::string& output, const Args&... args)
+{
+    output.clear();
+    (appendOutput(output, args), ...);
+}
@@ -0,0 +1,251 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "output_writer.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+// used while nothing is to be written, so large output is also written with policy 'prompt'
+constexpr std::chrono::milliseconds idle_timeout{100};
+
+void writeToStandardOutput(const char* data, std::size_t size)
+{
+    while (size > 0u) {
+#ifdef _WIN32
+        const auto written = _write(_fileno(stdout), data, static_cast<unsigned int>(size));
+#else
+        const auto written = ::write(STDOUT_FILENO, data, size);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+} // namespace
+
+bool parseFlushPolicy(const std::string& text, FlushPolicy& policy)
+{
+    if (text == "line") {
+        policy = FlushPolicy{FlushPolicy::Mode::line, std::chrono::milliseconds(0)};
+        return true;
+    }
+    if (text == "prompt") {
+        policy = FlushPolicy{FlushPolicy::Mode::prompt, std::chrono::milliseconds(0)};
+        return true;
+    }
+    const std::string unit = "ms";
+    if (text.size() <= unit.size() || text.compare(text.size() - unit.size(), unit.size(), unit) != 0) {
+        return false;
+    }
+    const std::string number = text.substr(0u, text.size() - unit.size());
+    if (number.find_first_not_of("0123456789") != std::string::npos || number.size() > 9u) {
+        return false;
+    }
+    const std::chrono::milliseconds interval(std::stol(number));
+    if (interval.count() == 0) {
+        return false;
+    }
+    policy = FlushPolicy{FlushPolicy::Mode::interval, interval};
+    return true;
+}
+
+AsyncOutputWriter::AsyncOutputWriter(FlushPolicy policy)
+    : AsyncOutputWriter(policy, &writeToStandardOutput)
+{
+}
+
+AsyncOutputWriter::AsyncOutputWriter(FlushPolicy policy, Sink sink)
+    : _policy(policy), _sink(std::move(sink)), _writer_thread([this]() { run(); })
+{
+}
+
+AsyncOutputWriter::~AsyncOutputWriter()
+{
+    _stop = true;
+    wake();
+    _writer_thread.join();
+}
+
+void AsyncOutputWriter::push(std::string_view output)
+{
+    Node* node = new Node();
+    node->_output.assign(output.data(), output.size());
+    enqueue(node);
+    ++_pushed;
+    if (_writer_sleeping && (_policy._mode == FlushPolicy::Mode::line || _flush_waiters > 0u)) {
+        wake();
+    }
+}
+
+void AsyncOutputWriter::flush()
+{
+    // the queue keeps the order of enqueue, so the node of the flush follows all output this
+    // thread pushed before; output of other threads is not waited for
+    bool flushed = false;
+    Node flush_node;
+    flush_node._flushed = &flushed;
+    ++_flush_waiters;
+    enqueue(&flush_node);
+    ++_pushed;
+    wake();
+    {
+        std::unique_lock<std::mutex> lck(_flush_mutex);
+        _flushed.wait(lck, [&flushed]() { return flushed; });
+    }
+    --_flush_waiters;
+}
+
+void AsyncOutputWriter::enqueue(Node* node)
+{
+    node->_next.store(nullptr, std::memory_order_relaxed);
+    Node* previous = _head.exchange(node, std::memory_order_acq_rel);
+    previous->_next.store(node, std::memory_order_release);
+}
+
+// only called by the writer thread, returns nullptr if the queue is empty or the next node
+// is not linked yet by its producer
+AsyncOutputWriter::Node* AsyncOutputWriter::dequeue()
+{
+    Node* tail = _tail;
+    Node* next = tail->_next.load(std::memory_order_acquire);
+    if (tail == &_stub) {
+        if (next == nullptr) {
+            return nullptr;
+        }
+        _tail = next;
+        tail = next;
+        next = next->_next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+        _tail = next;
+        return tail;
+    }
+    if (tail != _head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    // tail is the last node, the stub is put behind it so it can be taken out
+    enqueue(&_stub);
+    next = tail->_next.load(std::memory_order_acquire);
+    if (next != nullptr) {
+        _tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void AsyncOutputWriter::run()
+{
+    std::string pending;
+    std::vector<Node*> flush_nodes;
+    auto last_write = std::chrono::steady_clock::now();
+    for (;;) {
+        while (Node* node = dequeue()) {
+            ++_dequeued;
+            if (node->_flushed != nullptr) {
+                flush_nodes.push_back(node);
+                continue;
+            }
+            pending += node->_output;
+            delete node;
+        }
+
+        const bool stopping = _stop;
+        if (!pending.empty()) {
+            const auto now = std::chrono::steady_clock::now();
+            bool write_now =
+                stopping || !flush_nodes.empty() || pending.size() >= max_pending_size;
+            switch (_policy._mode) {
+            case FlushPolicy::Mode::line:
+                write_now = true;
+                break;
+            case FlushPolicy::Mode::interval:
+                write_now = write_now || now - last_write >= _policy._interval;
+                break;
+            case FlushPolicy::Mode::prompt:
+                break;
+            }
+            if (write_now) {
+                _sink(pending.data(), pending.size());
+                pending.clear();
+                last_write = now;
+            }
+        }
+        if (!flush_nodes.empty()) {
+            // the flushing threads return and release their nodes once they are notified
+            {
+                std::lock_guard<std::mutex> lck(_flush_mutex);
+                for (Node* flush_node: flush_nodes) {
+                    *flush_node->_flushed = true;
+                }
+            }
+            flush_nodes.clear();
+            _flushed.notify_all();
+        }
+
+        if (_pushed > _dequeued) {
+            // a producer is just linking its output into the queue
+            std::this_thread::yield();
+            continue;
+        }
+        if (stopping) {
+            return;
+        }
+        wait(pending.size(), last_write);
+    }
+}
+
+void AsyncOutputWriter::wait(std::size_t pending_size,
+                             std::chrono::steady_clock::time_point last_write)
+{
+    auto timeout = idle_timeout;
+    if (_policy._mode == FlushPolicy::Mode::interval && pending_size > 0u) {
+        timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+            last_write + _policy._interval - std::chrono::steady_clock::now());
+    }
+
+    std::unique_lock<std::mutex> lck(_wake_mutex);
+    _writer_sleeping = true;
+    _wake.wait_for(lck, timeout, [this, pending_size]() {
+        const bool flush_requested = _flush_waiters > 0u;
+        const bool new_output = _pushed > _dequeued;
+        return _stop || (flush_requested && (new_output || pending_size > 0u)) ||
+               (_policy._mode == FlushPolicy::Mode::line && new_output);
+    });
+    _writer_sleeping = false;
+}
+
+void AsyncOutputWriter::wake()
+{
+    std::lock_guard<std::mutex> lck(_wake_mutex);
+    _wake.notify_one();
+}
@@ -0,0 +1,109 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// When the output collected by the writer thread is written
+struct FlushPolicy {
+    enum class Mode : std::uint8_t {
+        // as soon as the writer thread gets it, output arriving meanwhile is written at once
+        line,
+        // at most once per interval
+        interval,
+        // only before the prompt is shown (see AsyncOutputWriter::flush)
+        prompt
+    };
+    Mode _mode = Mode::line;
+    std::chrono::milliseconds _interval{0};
+};
+
+// parses 'line', 'prompt' or an interval like '50ms'
+bool parseFlushPolicy(const std::string& text, FlushPolicy& policy);
+
+// Writes the output of several threads by one writer thread. The producers only append the
+// output to a lock-free queue, the writer thread concatenates all queued output and writes it
+// with one call of the sink. Independent of the policy, the output is written once it exceeds
+// max_pending_size.
+class AsyncOutputWriter {
+public:
+    using Sink = std::function<void(const char* data, std::size_t size)>;
+    static constexpr std::size_t max_pending_size = 64u * 1024u;
+
+    // writes to the standard output
+    explicit AsyncOutputWriter(FlushPolicy policy);
+    AsyncOutputWriter(FlushPolicy policy, Sink sink);
+    // writes all pending output
+    ~AsyncOutputWriter();
+
+    AsyncOutputWriter(const AsyncOutputWriter&) = delete;
+    AsyncOutputWriter& operator=(const AsyncOutputWriter&) = delete;
+
+    void push(std::string_view output);
+    // blocks until all output pushed before by the calling thread is written
+    void flush();
+
+private:
+    struct Node {
+        std::atomic<Node*> _next{nullptr};
+        std::string _output;
+        // set for the node queued by flush, it is owned by the flushing thread
+        bool* _flushed = nullptr;
+    };
+
+    void enqueue(Node* node);
+    Node* dequeue();
+    void run();
+    void wait(std::size_t pending_size, std::chrono::steady_clock::time_point last_write);
+    void wake();
+
+    const FlushPolicy _policy;
+    const Sink _sink;
+
+    // intrusive multi producer single consumer queue, producers exchange the head,
+    // the writer thread consumes from the tail
+    Node _stub;
+    std::atomic<Node*> _head{&_stub};
+    Node* _tail = &_stub;
+
+    // counts of complete pushes and of nodes taken from the queue
+    std::atomic<std::uint64_t> _pushed{0u};
+    std::uint64_t _dequeued = 0u;
+
+    std::atomic<bool> _writer_sleeping{false};
+    std::atomic<bool> _stop{false};
+    std::atomic<std::size_t> _flush_waiters{0u};
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    std::mutex _flush_mutex;
+    std::condition_variable _flushed;
+    std::thread _writer_thread;
+};
+
+#endif // OUTPUT_WRITER_H
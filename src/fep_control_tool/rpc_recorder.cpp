@@ -0,0 +1,215 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "rpc_recorder.h"
+
+#include <json/json.h>
+#include <memory>
+
+namespace {
+// separates the identifying fields of an exchange inside the lookup key
+constexpr char key_separator = '\x1f';
+} // namespace
+
+bool RPCRecorder::startRecording(const std::string& file_name)
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    if (_record_file.is_open()) {
+        _record_file.close();
+    }
+    _record_file.open(file_name, std::ios::out | std::ios::trunc);
+    _record_statistics = Statistics();
+    return _record_file.is_open();
+}
+
+RPCRecorder::Statistics RPCRecorder::stopRecording()
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    if (_record_file.is_open()) {
+        _record_file.close();
+    }
+    return _record_statistics;
+}
+
+bool RPCRecorder::isRecording() const
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    return _record_file.is_open();
+}
+
+std::size_t RPCRecorder::startReplay(const std::string& file_name)
+{
+    std::ifstream replay_file(file_name);
+    if (!replay_file.is_open()) {
+        throw std::runtime_error("cannot open RPC recording '" + file_name + "'");
+    }
+
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+    std::map<std::string, std::deque<RecordedResponse>> responses;
+    std::size_t exchanges = 0u;
+    std::string line;
+    while (std::getline(replay_file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        Json::Value exchange;
+        std::string parse_errors;
+        if (!reader->parse(line.c_str(), line.c_str() + line.size(), &exchange, &parse_errors)) {
+            throw std::runtime_error("invalid RPC recording '" + file_name + "' at exchange " +
+                                     std::to_string(exchanges + 1u) + ": " + parse_errors);
+        }
+        const std::string key = makeKey(exchange["system"].asString(),
+                                        exchange["participant"].asString(),
+                                        exchange["component"].asString(),
+                                        exchange["method"].asString(),
+                                        exchange["request"].asString());
+        responses[key].push_back(
+            RecordedResponse{exchange["response"].asString(), exchange["error"].asString()});
+        ++exchanges;
+    }
+
+    std::lock_guard<std::mutex> lck(_mutex);
+    _replay_responses = std::move(responses);
+    _replaying = true;
+    return exchanges;
+}
+
+void RPCRecorder::stopReplay()
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    _replaying = false;
+    _replay_responses.clear();
+}
+
+bool RPCRecorder::isReplaying() const
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    return _replaying;
+}
+
+std::string RPCRecorder::makeKey(const std::string& system_name,
+                                 const std::string& participant_name,
+                                 const std::string& component,
+                                 const std::string& method,
+                                 const std::string& request)
+{
+    std::string key;
+    key.reserve(system_name.size() + participant_name.size() + component.size() +
+                method.size() + request.size() + 4u);
+    key.append(system_name).append(1u, key_separator);
+    key.append(participant_name).append(1u, key_separator);
+    key.append(component).append(1u, key_separator);
+    key.append(method).append(1u, key_separator);
+    key.append(request);
+    return key;
+}
+
+std::chrono::microseconds RPCRecorder::elapsedSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+}
+
+void RPCRecorder::record(const std::string& key,
+                         const std::string& response,
+                         std::chrono::microseconds duration,
+                         const std::string& error)
+{
+    static const char* const field_names[] = {
+        "system", "participant", "component", "method", "request"};
+
+    Json::Value exchange;
+    std::size_t field_begin = 0u;
+    for (const char* field_name: field_names) {
+        const std::size_t field_end = key.find(key_separator, field_begin);
+        exchange[field_name] = key.substr(field_begin, field_end - field_begin);
+        field_begin = field_end == std::string::npos ? key.size() : field_end + 1u;
+    }
+    exchange["response"] = response;
+    exchange["duration_us"] = static_cast<Json::Int64>(duration.count());
+    if (!error.empty()) {
+        exchange["error"] = error;
+    }
+
+    std::lock_guard<std::mutex> lck(_mutex);
+    if (!_record_file.is_open()) {
+        return;
+    }
+    _record_file << _builder.convertJson(exchange) << '\n';
+    ++_record_statistics._exchanges;
+    _record_statistics._duration += duration;
+}
+
+std::string RPCRecorder::replay(const std::string& key)
+{
+    std::lock_guard<std::mutex> lck(_mutex);
+    auto found = _replay_responses.find(key);
+    if (found == _replay_responses.end() || found->second.empty()) {
+        const std::string method = key.substr(0u, key.rfind(key_separator));
+        throw std::runtime_error("no recorded RPC response for '" +
+                                 method.substr(method.rfind(key_separator) + 1u) + "'");
+    }
+
+    // responses are served in recorded order, the last one is repeated once exhausted
+    RecordedResponse recorded = found->second.front();
+    if (found->second.size() > 1u) {
+        found->second.pop_front();
+    }
+    if (!recorded._error.empty()) {
+        throw std::runtime_error(recorded._error);
+    }
+    return recorded._response;
+}
+
+std::string RPCRecorder::encode(const std::string& value)
+{
+    return value;
+}
+
+std::string RPCRecorder::encode(const std::vector<std::string>& value)
+{
+    Json::Value list(Json::arrayValue);
+    for (const auto& item: value) {
+        list.append(item);
+    }
+    CompactJsonStream builder;
+    return builder.convertJson(list);
+}
+
+std::string RPCRecorder::encode(bool value)
+{
+    return value ? "true" : "false";
+}
+
+std::vector<std::string> RPCRecorder::decodeList(const std::string& response)
+{
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+    Json::Value list;
+    std::string parse_errors;
+    if (!reader->parse(response.c_str(), response.c_str() + response.size(), &list, &parse_errors)) {
+        throw std::runtime_error("invalid recorded RPC response: " + parse_errors);
+    }
+    std::vector<std::string> result;
+    for (const auto& item: list) {
+        result.push_back(item.asString());
+    }
+    return result;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef RPC_RECORDER_H
+#define RPC_RECORDER_H
+
+#include "helper.h"
+
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Records every RPC exchange going through it to a file (one compact json object per line)
+// or, in replay mode, serves the responses of such a file instead of calling the participants.
+// The exchanges are identified by system, participant, component, method and request, so a
+// replay does not need any live participant.
+class RPCRecorder {
+public:
+    struct Statistics {
+        std::size_t _exchanges = 0u;
+        std::chrono::microseconds _duration{0};
+    };
+
+    bool startRecording(const std::string& file_name);
+    Statistics stopRecording();
+    bool isRecording() const;
+
+    // throws std::runtime_error if the file cannot be read or parsed
+    std::size_t startReplay(const std::string& file_name);
+    void stopReplay();
+    bool isReplaying() const;
+
+    // executes live_call (or serves the recorded response in replay mode)
+    template <typename Call>
+    auto exchange(const std::string& system_name,
+                  const std::string& participant_name,
+                  const std::string& component,
+                  const std::string& method,
+                  const std::string& request,
+                  Call&& live_call) -> decltype(live_call())
+    {
+        using Result = decltype(live_call());
+
+        if (isReplaying()) {
+            const std::string response =
+                replay(makeKey(system_name, participant_name, component, method, request));
+            if constexpr (!std::is_void<Result>::value) {
+                return decode<Result>(response);
+            }
+            else {
+                return;
+            }
+        }
+        if (!isRecording()) {
+            return live_call();
+        }
+
+        const std::string key = makeKey(system_name, participant_name, component, method, request);
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            if constexpr (!std::is_void<Result>::value) {
+                Result result = live_call();
+                record(key, encode(result), elapsedSince(start), "");
+                return result;
+            }
+            else {
+                live_call();
+                record(key, "", elapsedSince(start), "");
+            }
+        }
+        catch (const std::exception& e) {
+            record(key, "", elapsedSince(start), e.what());
+            throw;
+        }
+    }
+
+private:
+    struct RecordedResponse {
+        std::string _response;
+        std::string _error;
+    };
+
+    static std::string makeKey(const std::string& system_name,
+                               const std::string& participant_name,
+                               const std::string& component,
+                               const std::string& method,
+                               const std::string& request);
+    static std::chrono::microseconds elapsedSince(std::chrono::steady_clock::time_point start);
+
+    void record(const std::string& key,
+                const std::string& response,
+                std::chrono::microseconds duration,
+                const std::string& error);
+    std::string replay(const std::string& key);
+
+    static std::string encode(const std::string& value);
+    static std::string encode(const std::vector<std::string>& value);
+    static std::string encode(bool value);
+    template <typename T>
+    static std::string encode(T value)
+    {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                      "no recording encoding for this RPC result type");
+        return std::to_string(static_cast<long long>(value));
+    }
+
+    template <typename T>
+    static T decode(const std::string& response)
+    {
+        if constexpr (std::is_same<T, std::string>::value) {
+            return response;
+        }
+        else if constexpr (std::is_same<T, std::vector<std::string>>::value) {
+            return decodeList(response);
+        }
+        else if constexpr (std::is_same<T, bool>::value) {
+            return response == "true";
+        }
+        else {
+            static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                          "no recording encoding for this RPC result type");
+            return static_cast<T>(std::stoll(response));
+        }
+    }
+    static std::vector<std::string> decodeList(const std::string& response);
+
+    mutable std::mutex _mutex;
+    std::ofstream _record_file;
+    Statistics _record_statistics;
+    CompactJsonStream _builder;
+    bool _replaying = false;
+    std::map<std::string, std::deque<RecordedResponse>> _replay_responses;
+};
+
+#endif // RPC_RECORDER_H
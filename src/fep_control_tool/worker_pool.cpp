@@ -0,0 +1,83 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#include "worker_pool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(std::size_t thread_count)
+{
+    thread_count = std::max<std::size_t>(thread_count, 1u);
+    for (std::size_t index = 0u; index < thread_count; ++index) {
+        _threads.emplace_back([this]() { run(); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        _stop = true;
+    }
+    _task_submitted.notify_all();
+    for (auto& thread: _threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lck(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _task_submitted.notify_one();
+}
+
+void WorkerPool::wait()
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    _tasks_done.wait(lck, [this]() { return _tasks.empty() && _running == 0u; });
+}
+
+std::size_t WorkerPool::getThreadCount() const
+{
+    return _threads.size();
+}
+
+void WorkerPool::run()
+{
+    std::unique_lock<std::mutex> lck(_mutex);
+    for (;;) {
+        _task_submitted.wait(lck, [this]() { return _stop || !_tasks.empty(); });
+        if (_tasks.empty()) {
+            return;
+        }
+        auto task = std::move(_tasks.front());
+        _tasks.pop_front();
+        ++_running;
+        lck.unlock();
+        task();
+        lck.lock();
+        --_running;
+        if (_tasks.empty() && _running == 0u) {
+            _tasks_done.notify_all();
+        }
+    }
+}
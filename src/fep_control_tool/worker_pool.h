@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs the submitted tasks on a fixed number of threads, in the order of submission. The tasks
+// must not throw.
+class WorkerPool {
+public:
+    static constexpr std::size_t default_thread_count = 8u;
+
+    explicit WorkerPool(std::size_t thread_count = default_thread_count);
+    // runs the tasks submitted before, then stops the threads
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(std::function<void()> task);
+    // blocks until all tasks submitted before are done
+    void wait();
+    std::size_t getThreadCount() const;
+
+private:
+    void run();
+
+    std::mutex _mutex;
+    std::condition_variable _task_submitted;
+    std::condition_variable _tasks_done;
+    std::deque<std::function<void()>> _tasks;
+    // tasks taken by a thread and not done yet
+    std::size_t _running = 0u;
+    bool _stop = false;
+    std::vector<std::thread> _threads;
+};
+
+#endif // WORKER_POOL_H
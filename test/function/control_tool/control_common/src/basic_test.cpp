@@ -22,7 +22,9 @@ You may add additional accurate notices of copyright ownership.
 
 #include <a_util/filesystem.h>
 #include <a_util/strings.h>
+#include <boost/filesystem.hpp>
 #include <chrono>
+#include <fstream>
 #include <fep3/components/clock/clock_service_intf.h>
 #include <thread>
 #include <unordered_set>
@@ -93,6 +95,9 @@ TEST_F(ControlTool, testHelp)
         "setCurrentWorkingDirectory",
         "getCurrentWorkingDirectory",
         "help",
+        "source",
+        "job",
+        "jobs",
         "loadSystem",
         "unloadSystem",
         "setInitPriority",
@@ -107,6 +112,17 @@ TEST_F(ControlTool, testHelp)
         "shutdownSystem",
         "startMonitoringSystem",
         "stopMonitoringSystem",
+        "startMonitoringAll",
+        "stopMonitoringAll",
+        "showLogs",
+        "getLogBufferStatistics",
+        "getLogLatency",
+        "logStats",
+        "setLogRateLimit",
+        "getLogDropStatistics",
+        "startLogArchive",
+        "stopLogArchive",
+        "queryLogArchive",
         "loadParticipant",
         "unloadParticipant",
         "initializeParticipant",
@@ -134,6 +150,10 @@ TEST_F(ControlTool, testHelp)
         "getCurrentTimingMaster",
         "enableAutoDiscovery",
         "disableAutoDiscovery",
+        "startRPCRecording",
+        "stopRPCRecording",
+        "startRPCReplay",
+        "stopRPCReplay",
     };
     std::vector<std::string> listed_commands;
 
@@ -503,6 +523,189 @@ TEST_F(ControlTool, testCommandlineArgument)
     // closeSession(c, writer_stream);
 }
 
+/**
+ * Test batch execution of the commands piped to the test object
+ *
+ * @req_id          ???
+ * @testData        none
+ * @testType        positive test
+ * @precondition    none
+ * @postcondition   none
+ * @expectedResult  commands are executed without prompt, a summary is written
+ */
+TEST_F(ControlTool, testBatchMode)
+{
+    for (const bool stop_on_error: {false, true}) {
+        bp::opstream writer_stream;
+        bp::ipstream reader_stream;
+        bp::child c(binary_tool_path + " --batch" + (stop_on_error ? " --stop-on-error" : ""),
+                    bp::std_out > reader_stream,
+                    bp::std_in < writer_stream);
+        ASSERT_TRUE(c.running());
+
+        writer_stream << "getCurrentWorkingDirectory" << std::endl;
+        writer_stream << "noSuchCommand" << std::endl;
+        writer_stream << "getCurrentWorkingDirectory" << std::endl;
+        // quit ends the batch, the summary is written anyway
+        writer_stream << "quit" << std::endl;
+        writer_stream << "getCurrentWorkingDirectory" << std::endl;
+        writer_stream.pipe().close();
+
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(reader_stream, line)) {
+            a_util::strings::trim(line);
+            lines.push_back(line);
+        }
+        c.wait();
+        EXPECT_EQ(c.exit_code(), 1);
+
+        ASSERT_FALSE(lines.empty());
+        EXPECT_EQ(lines.front().compare(0u, 20u, "working_directory : "), 0);
+        EXPECT_TRUE(std::none_of(lines.begin(), lines.end(), [](const std::string& line) {
+            return line.find("fep>") != std::string::npos;
+        }));
+        const std::string summary =
+            stop_on_error ? "batch: 2 commands, 1 failed" : "batch: 3 commands, 1 failed";
+        EXPECT_TRUE(std::any_of(lines.begin(), lines.end(), [&summary](const std::string& line) {
+            return line.compare(0u, summary.size(), summary) == 0;
+        }));
+        EXPECT_TRUE(std::any_of(lines.begin(), lines.end(), [](const std::string& line) {
+            return line.compare(0u, 7u, "command") == 0 && line.find("max us") != std::string::npos;
+        }));
+    }
+}
+
+/**
+ * Test running a script file with a parallel block in the session
+ *
+ * @req_id          ???
+ * @testData        none
+ * @testType        positive test
+ * @precondition    none
+ * @postcondition   none
+ * @expectedResult  all commands of the script are executed, invalid scripts are rejected
+ */
+TEST_F(ControlTool, testSource)
+{
+    const auto script_file = boost::filesystem::temp_directory_path() /
+                             boost::filesystem::unique_path("fep_control_script_%%%%%%.txt");
+    {
+        std::ofstream script(script_file.string());
+        script << "# runs the same command sequentially and in parallel\n"
+               << "getCurrentWorkingDirectory\n"
+               << "parallel {\n"
+               << "    getCurrentWorkingDirectory\n"
+               << "    getCurrentWorkingDirectory\n"
+               << "}\n"
+               << "wait\n";
+    }
+
+    bp::opstream writer_stream;
+    bp::ipstream reader_stream;
+    bp::child c(binary_tool_path, bp::std_out > reader_stream, bp::std_in < writer_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "source " << quoteNameIfNecessary(script_file.string()) << " --threads 2"
+                  << std::endl;
+    std::string output = getStreamUntilPromt(c, reader_stream);
+    std::size_t working_directories = 0u;
+    for (auto position = output.find("working_directory"); position != std::string::npos;
+         position = output.find("working_directory", position + 1u)) {
+        ++working_directories;
+    }
+    EXPECT_EQ(working_directories, 3u);
+    EXPECT_NE(output.find("commands : 3"), std::string::npos) << output;
+    EXPECT_NE(output.find("failed : 0"), std::string::npos) << output;
+
+    {
+        std::ofstream script(script_file.string());
+        script << "parallel {\n"
+               << "    exit\n"
+               << "}\n";
+    }
+    writer_stream << "source " << quoteNameIfNecessary(script_file.string()) << std::endl;
+    output = getStreamUntilPromt(c, reader_stream);
+    EXPECT_NE(output.find("line 2: 'exit' cannot run in a parallel block"), std::string::npos)
+        << output;
+
+    {
+        std::ofstream script(script_file.string());
+        script << "help\n"
+               << "quit\n";
+    }
+    writer_stream << "source " << quoteNameIfNecessary(script_file.string()) << std::endl;
+    output = getStreamUntilPromt(c, reader_stream);
+    EXPECT_NE(output.find("line 2: scripts cannot quit the session"), std::string::npos)
+        << output;
+    ASSERT_TRUE(c.running());
+
+    // independent commands run concurrently, their output keeps the order of the script
+    {
+        std::ofstream script(script_file.string());
+        script << "help getParticipants\n"
+               << "help callRPC\n"
+               << "getCurrentWorkingDirectory\n"
+               << "help help\n";
+    }
+    writer_stream << "source " << quoteNameIfNecessary(script_file.string()) << " --auto-parallel"
+                  << std::endl;
+    output = getStreamUntilPromt(c, reader_stream);
+    const auto get_participants = output.find("getParticipants");
+    const auto call_rpc = output.find("callRPC");
+    const auto working_directory = output.find("working_directory");
+    const auto help = output.find("help <command name>");
+    ASSERT_NE(help, std::string::npos) << output;
+    EXPECT_LT(get_participants, call_rpc);
+    EXPECT_LT(call_rpc, working_directory);
+    EXPECT_LT(working_directory, help);
+    EXPECT_NE(output.find("commands : 4"), std::string::npos) << output;
+
+    closeSession(c, writer_stream);
+    boost::filesystem::remove(script_file);
+}
+
+/**
+ * Test running a command as job in the background of the session
+ *
+ * @req_id          ???
+ * @testData        none
+ * @testType        positive test
+ * @precondition    none
+ * @postcondition   none
+ * @expectedResult  the job is run, waited for and listed, unknown jobs are reported
+ */
+TEST_F(ControlTool, testJobs)
+{
+    bp::opstream writer_stream;
+    bp::ipstream reader_stream;
+    bp::child c(binary_tool_path, bp::std_out > reader_stream, bp::std_in < writer_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "job run getCurrentWorkingDirectory && job wait 1" << std::endl;
+    std::string output = getStreamUntilPromt(c, reader_stream);
+    EXPECT_NE(output.find("working_directory"), std::string::npos) << output;
+    EXPECT_NE(output.find("job 1 done, result 0"), std::string::npos) << output;
+
+    writer_stream << "jobs" << std::endl;
+    output = getStreamUntilPromt(c, reader_stream);
+    EXPECT_NE(output.find("getCurrentWorkingDirectory  done"), std::string::npos) << output;
+
+    writer_stream << "job cancel 1" << std::endl;
+    output = getStreamUntilPromt(c, reader_stream);
+    EXPECT_NE(output.find("only queued jobs can be cancelled"), std::string::npos) << output;
+
+    writer_stream << "job wait 7" << std::endl;
+    output = getStreamUntilPromt(c, reader_stream);
+    EXPECT_NE(output.find("Unknown job 7"), std::string::npos) << output;
+
+    writer_stream << "job run quit" << std::endl;
+    output = getStreamUntilPromt(c, reader_stream);
+    EXPECT_NE(output.find("'quit' cannot run as job"), std::string::npos) << output;
+
+    closeSession(c, writer_stream);
+}
+
 /**
  * Test exit of test object
  *
@@ -1108,6 +1311,459 @@ TEST_F(ControlTool, testJsonMonitoring_enableJSON)
     skipUntilPrompt(c, reader_stream);
 }
 
+/**
+ * Test query of the log buffer of a monitored FEP system in json mode
+ *
+ * @req_id          ???
+ * @testData        FEP_SYSTEM
+ * @testType        positive test
+ * @precondition    none
+ * @postcondition   none
+ * @expectedResult  method returns expected results
+ */
+TEST_F(ControlTool, testShowLogs)
+{
+    TestParticipants test_parts;
+    ASSERT_TRUE(createSystem(test_parts));
+
+    bp::opstream writer_stream;
+    bp::ipstream reader_stream;
+    bp::child c(binary_tool_path, bp::std_out > reader_stream, bp::std_in < writer_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "enableJson" << std::endl;
+    auto root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "showLogs " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root["action"].asString(), "showLogs");
+    EXPECT_EQ(root["status"].asInt(), 1);
+
+    writer_stream << "discoverSystem " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "startMonitoringSystem " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root["value"]["note"].asString(), "monitoring: enabled");
+
+    writer_stream << "stopSystem " << _system_name << std::endl;
+    bool log_received = false;
+    bool system_stopped = false;
+    while (!log_received || !system_stopped) {
+        root = readJsonArray(reader_stream);
+        ASSERT_TRUE(root.isObject());
+        if (root["log_type"].asString() == "message") {
+            EXPECT_TRUE(root["timestamp"].isIntegral());
+            log_received = true;
+        }
+        system_stopped = system_stopped || root["action"].asString() == "stopSystem";
+    }
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "stopMonitoringSystem " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    // the buffer is kept after the monitoring stopped
+    writer_stream << "showLogs " << _system_name << " --limit 1 --severity debug" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root["action"].asString(), "showLogs");
+    EXPECT_EQ(root["status"].asInt(), 0);
+    ASSERT_TRUE(root["value"].isArray());
+    ASSERT_EQ(root["value"].size(), 1u);
+    EXPECT_FALSE(root["value"][0]["participant_name"].asString().empty());
+    EXPECT_FALSE(root["value"][0]["message"].asString().empty());
+    EXPECT_TRUE(root["value"][0]["timestamp"].isIntegral());
+
+    writer_stream << "showLogs " << _system_name << " --participant no_such_participant"
+                  << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    ASSERT_TRUE(root["value"].isArray());
+    EXPECT_EQ(root["value"].size(), 0u);
+
+    writer_stream << "showLogs " << _system_name << " --limit many" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["status"].asInt(), 2);
+
+    writer_stream << "showLogs " << _system_name << " --unknown 1" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["action"].asString(), "processCommandline");
+    EXPECT_EQ(root["status"].asInt(), 2);
+
+    writer_stream << "getLogBufferStatistics " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root["action"].asString(), "getLogBufferStatistics");
+    EXPECT_GE(std::stoul(root["value"]["records_stored"].asString()), 1u);
+    EXPECT_EQ(root["value"]["records_overwritten"].asString(), "0");
+    EXPECT_GT(std::stoul(root["value"]["memory_bytes"].asString()), 0u);
+
+    // in text mode each used bucket of the histogram is written as a line of its own
+    writer_stream << "disableJson" << std::endl;
+    skipUntilPrompt(c, reader_stream);
+    writer_stream << "getLogLatency " << _system_name << std::endl;
+    std::size_t bucket_lines = 0u;
+    std::string word;
+    while (c.running() && reader_stream >> word && word != "fep>") {
+        if (word == "<" || word == ">=") {
+            ++bucket_lines;
+        }
+    }
+    writer_stream << "enableJson" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "getLogLatency " << _system_name << " --reset" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root["action"].asString(), "getLogLatency");
+    EXPECT_GE(root["value"]["count"].asUInt64(), 1u);
+    EXPECT_LE(root["value"]["p50_ms"].asInt64(), root["value"]["max_ms"].asInt64());
+    ASSERT_TRUE(root["value"]["buckets"].isArray());
+    EXPECT_GE(root["value"]["buckets"].size(), 1u);
+    EXPECT_EQ(bucket_lines, root["value"]["buckets"].size());
+
+    writer_stream << "getLogLatency " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["value"]["count"].asUInt64(), 0u);
+
+    closeSession(c, writer_stream);
+}
+
+/**
+ * Test filtering of log messages of a monitored FEP system in json mode
+ *
+ * @req_id          ???
+ * @testData        FEP_SYSTEM
+ * @testType        positive test
+ * @precondition    none
+ * @postcondition   none
+ * @expectedResult  method returns expected results
+ */
+TEST_F(ControlTool, testMonitoringFilter)
+{
+    TestParticipants test_parts;
+    ASSERT_TRUE(createSystem(test_parts));
+
+    bp::opstream writer_stream;
+    bp::ipstream reader_stream;
+    bp::child c(binary_tool_path, bp::std_out > reader_stream, bp::std_in < writer_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "enableJson" << std::endl;
+    auto root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "discoverSystem " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "startMonitoringSystem " << _system_name << " --regex (" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["action"].asString(), "startMonitoringSystem");
+    EXPECT_EQ(root["status"].asInt(), 2);
+
+    writer_stream << "startMonitoringSystem " << _system_name << " --min-severity loud"
+                  << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["status"].asInt(), 2);
+
+    writer_stream << "startMonitoringSystem " << _system_name
+                  << " --participant * --logger * --min-severity debug --regex ." << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root["status"].asInt(), 0);
+    EXPECT_EQ(root["value"]["note"].asString(), "monitoring: enabled");
+
+    writer_stream << "stopSystem " << _system_name << std::endl;
+    bool log_received = false;
+    bool system_stopped = false;
+    while (!log_received || !system_stopped) {
+        root = readJsonArray(reader_stream);
+        ASSERT_TRUE(root.isObject());
+        if (root["log_type"].asString() == "message") {
+            EXPECT_FALSE(root["message"].asString().empty());
+            log_received = true;
+        }
+        system_stopped = system_stopped || root["action"].asString() == "stopSystem";
+    }
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "stopMonitoringSystem " << _system_name << std::endl;
+    skipUntilPrompt(c, reader_stream);
+
+    closeSession(c, writer_stream);
+}
+
+/**
+ * Test monitoring all systems matching a pattern as one stream in json mode
+ *
+ * @req_id          ???
+ * @testData        FEP_SYSTEM
+ * @testType        positive test
+ * @precondition    none
+ * @postcondition   none
+ * @expectedResult  method returns expected results
+ */
+TEST_F(ControlTool, testMonitoringAll)
+{
+    TestParticipants test_parts;
+    ASSERT_TRUE(createSystem(test_parts));
+
+    bp::opstream writer_stream;
+    bp::ipstream reader_stream;
+    bp::child c(binary_tool_path, bp::std_out > reader_stream, bp::std_in < writer_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "enableJson" << std::endl;
+    auto root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "startMonitoringAll " << _system_name << " --min-severity debug" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root["action"].asString(), "startMonitoringAll");
+    EXPECT_EQ(root["status"].asInt(), 0);
+    EXPECT_EQ(root["value"]["monitoring"].asString(), "enabled");
+    EXPECT_EQ(root["value"]["systems"].asString(), _system_name);
+
+    writer_stream << "stopSystem " << _system_name << std::endl;
+    bool log_received = false;
+    bool system_stopped = false;
+    while (!log_received || !system_stopped) {
+        root = readJsonArray(reader_stream);
+        ASSERT_TRUE(root.isObject());
+        if (root["log_type"].asString() == "message") {
+            // the records of all systems are tagged with their system
+            EXPECT_EQ(root["system_name"].asString(), _system_name);
+            log_received = true;
+        }
+        system_stopped = system_stopped || root["action"].asString() == "stopSystem";
+    }
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "stopMonitoringAll" << std::endl;
+    root = readJsonArray(reader_stream);
+    while (root["action"].asString() != "stopMonitoringAll") {
+        root = readJsonArray(reader_stream);
+    }
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["status"].asInt(), 0);
+    EXPECT_EQ(root["value"]["monitoring"].asString(), "disabled");
+    EXPECT_EQ(root["value"]["systems"].asString(), _system_name);
+
+    closeSession(c, writer_stream);
+}
+
+/**
+ * Test rate limit of log messages of a monitored FEP system in json mode
+ *
+ * @req_id          ???
+ * @testData        FEP_SYSTEM
+ * @testType        positive test
+ * @precondition    none
+ * @postcondition   none
+ * @expectedResult  method returns expected results
+ */
+TEST_F(ControlTool, testLogRateLimit)
+{
+    TestParticipants test_parts;
+    ASSERT_TRUE(createSystem(test_parts));
+
+    bp::opstream writer_stream;
+    bp::ipstream reader_stream;
+    bp::child c(binary_tool_path, bp::std_out > reader_stream, bp::std_in < writer_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "enableJson" << std::endl;
+    auto root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "setLogRateLimit " << _system_name << " 10" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["status"].asInt(), 1);
+
+    writer_stream << "discoverSystem " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "startMonitoringSystem " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "setLogRateLimit " << _system_name << " 10 --sample 0" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["status"].asInt(), 2);
+
+    // only the first message of each participant is written
+    writer_stream << "setLogRateLimit " << _system_name << " 0 --sample 1000000" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root["value"]["note"].asString(), "log_rate_limit: enabled");
+
+    std::uint64_t summarized = 0u;
+    const auto countSummaries = [&summarized](const Json::Value& frame) {
+        const auto count = [&summarized](const Json::Value& log) {
+            const std::string message = log["message"].asString();
+            if (message.compare(0u, 8u, "dropped ") == 0 &&
+                message.find(" from ") != std::string::npos) {
+                summarized += std::stoull(message.substr(8u));
+            }
+        };
+        if (frame["log_type"].asString() == "log_batch") {
+            for (const auto& log: frame["messages"]) {
+                count(log);
+            }
+        }
+        else if (frame["log_type"].asString() == "message") {
+            count(frame);
+        }
+    };
+
+    writer_stream << "stopSystem " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    countSummaries(root);
+    while (root["action"].asString() != "stopSystem") {
+        root = readJsonArray(reader_stream);
+        countSummaries(root);
+    }
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "getLogDropStatistics " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    countSummaries(root);
+    while (root["action"].asString() != "getLogDropStatistics") {
+        root = readJsonArray(reader_stream);
+        countSummaries(root);
+    }
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["status"].asInt(), 0);
+    std::uint64_t sampled_out = 0u;
+    if (root["value"].isArray()) {
+        for (const auto& participant: root["value"]) {
+            EXPECT_FALSE(participant["participant_name"].asString().empty());
+            EXPECT_EQ(participant["passed"].asString(), "1");
+            EXPECT_EQ(participant["rate_limited"].asString(), "0");
+            sampled_out += std::stoull(participant["sampled_out"].asString());
+        }
+    }
+
+    // the dropped messages are summarized after the interval, although no message follows
+    while (summarized < sampled_out) {
+        countSummaries(readJsonArray(reader_stream));
+    }
+
+    writer_stream << "setLogRateLimit " << _system_name << " 0" << std::endl;
+    root = readJsonArray(reader_stream);
+    while (root["action"].asString() != "setLogRateLimit") {
+        root = readJsonArray(reader_stream);
+    }
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["value"]["note"].asString(), "log_rate_limit: disabled");
+
+    writer_stream << "stopMonitoringSystem " << _system_name << std::endl;
+    skipUntilPrompt(c, reader_stream);
+
+    closeSession(c, writer_stream);
+}
+
+/**
+ * Test batching of log messages in json mode
+ *
+ * @req_id          ???
+ * @testData        FEP_SYSTEM
+ * @testType        positive test
+ * @precondition    none
+ * @postcondition   none
+ * @expectedResult  method returns expected results
+ */
+TEST_F(ControlTool, testLogBatching)
+{
+    TestParticipants test_parts;
+    ASSERT_TRUE(createSystem(test_parts));
+
+    bp::opstream writer_stream;
+    bp::ipstream reader_stream;
+    bp::child c(binary_tool_path, bp::std_out > reader_stream, bp::std_in < writer_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "enableJson" << std::endl;
+    auto root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "enableLogBatching 0 50" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["status"].asInt(), 2);
+
+    writer_stream << "enableLogBatching 1000 50" << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root["value"]["note"].asString(), "log_batching: enabled");
+
+    writer_stream << "discoverSystem " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "startMonitoringSystem " << _system_name << std::endl;
+    root = readJsonArray(reader_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    // the log messages arrive as batch, at the latest 50 ms after the first of them
+    writer_stream << "stopSystem " << _system_name << std::endl;
+    bool batch_received = false;
+    bool system_stopped = false;
+    while (!batch_received || !system_stopped) {
+        root = readJsonArray(reader_stream);
+        ASSERT_TRUE(root.isObject());
+        EXPECT_NE(root["log_type"].asString(), "message");
+        if (root["log_type"].asString() == "log_batch") {
+            ASSERT_TRUE(root["messages"].isArray());
+            ASSERT_GE(root["messages"].size(), 1u);
+            EXPECT_FALSE(root["messages"][0]["message"].asString().empty());
+            EXPECT_TRUE(root["messages"][0]["timestamp"].isIntegral());
+            batch_received = true;
+        }
+        system_stopped = system_stopped || root["action"].asString() == "stopSystem";
+    }
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "disableLogBatching" << std::endl;
+    root = readJsonArray(reader_stream);
+    while (root["action"].asString() != "disableLogBatching") {
+        root = readJsonArray(reader_stream);
+    }
+    skipUntilPrompt(c, reader_stream);
+    EXPECT_EQ(root["value"]["note"].asString(), "log_batching: disabled");
+
+    writer_stream << "stopMonitoringSystem " << _system_name << std::endl;
+    skipUntilPrompt(c, reader_stream);
+
+    closeSession(c, writer_stream);
+}
+
 /**
  * Test json output of a note message
  *
@@ -1593,6 +2249,70 @@ TEST_F(ControlTool, testRPC)
     closeSession(c, writer_stream);
 }
 
+/**
+ * Test recording RPC calls and answering the same commands from the recording
+ * while the participants are no longer available
+ *
+ * @req_id          ???
+ * @testData        FEP_SYSTEM
+ * @testType        positive test
+ * @precondition    none
+ * @postcondition   none
+ * @expectedResult  method returns expected results
+ */
+TEST_F(ControlTool, testRPCRecordAndReplay)
+{
+    TestParticipants test_parts;
+    ASSERT_TRUE(createSystem(test_parts, false));
+
+    const std::string recording_file =
+        (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+            .string();
+
+    bp::opstream writer_stream;
+    bp::ipstream reader_stream;
+    bp::child c(binary_tool_path, bp::std_out > reader_stream, bp::std_in < writer_stream);
+    skipUntilPrompt(c, reader_stream);
+
+    writer_stream << "discoverSystem " << _system_name << std::endl;
+    const std::vector<std::string> expected_answer_discover = {
+        _system_name, ":", "test_part_0,", "test_part_1"};
+    EXPECT_TRUE(checkUntilPrompt(c, reader_stream, expected_answer_discover));
+
+    writer_stream << "startRPCRecording " << quoteNameIfNecessary(recording_file) << std::endl;
+    EXPECT_TRUE(checkUntilPrompt(c, reader_stream, {"rpc_recording:", "enabled"}));
+
+    const std::string get_name_rpc = "callRPC " + _system_name +
+                                     " test_part_0 participant_info"
+                                     " participant_info.arya.fep3.iid getName";
+    writer_stream << "getParticipantState " << _system_name << " test_part_0" << std::endl;
+    EXPECT_TRUE(checkUntilPrompt(c, reader_stream, {"4", ":", "initialized"}));
+    writer_stream << get_name_rpc << std::endl;
+    std::string ss = getStreamUntilPromt(c, reader_stream);
+    EXPECT_TRUE(ss.find("\"result\":\"test_part_0\"") != std::string::npos);
+
+    writer_stream << "stopRPCRecording" << std::endl;
+    EXPECT_TRUE(checkUntilPrompt(c, reader_stream, {"2", ":"}));
+
+    // no participant will answer anymore
+    test_parts.clear();
+
+    writer_stream << "startRPCReplay " << quoteNameIfNecessary(recording_file) << std::endl;
+    EXPECT_TRUE(checkUntilPrompt(c, reader_stream, {"replayed_calls", ":", "2"}));
+
+    writer_stream << "getParticipantState " << _system_name << " test_part_0" << std::endl;
+    EXPECT_TRUE(checkUntilPrompt(c, reader_stream, {"4", ":", "initialized"}));
+    writer_stream << get_name_rpc << std::endl;
+    ss = getStreamUntilPromt(c, reader_stream);
+    EXPECT_TRUE(ss.find("\"result\":\"test_part_0\"") != std::string::npos);
+
+    writer_stream << "stopRPCReplay" << std::endl;
+    EXPECT_TRUE(checkUntilPrompt(c, reader_stream, {"rpc_replay:", "disabled"}));
+
+    closeSession(c, writer_stream);
+    boost::filesystem::remove(recording_file);
+}
+
 TEST(ControlToolCommonHelper, quoteNameIfNecessary)
 {
     EXPECT_EQ(quoteNameIfNecessary(""), "\"\"");
@@ -0,0 +1,1842 @@
+/**
+ * @file
+ * @copyright
+ * @verbatim
+Copyright @ 2021 VW Group. All rights reserved.
+
+    This Source Code Form is subject to the terms of the Mozilla
+    Public License, v. 2.0. If a copy of the MPL was not distributed
+    with this file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+If it is not possible or desirable to put the notice in a particular file, then
+You may include the notice in a location (such as a LICENSE file in a
+relevant directory) where a recipient would be likely to look for such a notice.
+
+You may add additional accurate notices of copyright ownership.
+
+@endverbatim
+ */
+#include "../../../../../src/fep_control_tool/binary_writer.h"
+#include "../../../../../src/fep_control_tool/command_index.h"
+#include "../../../../../src/fep_control_tool/command_script.h"
+#include "../../../../../src/fep_control_tool/completion_cache.h"
+#include "../../../../../src/fep_control_tool/completion_index.h"
+#include "../../../../../src/fep_control_tool/control_tool_common_helper.h"
+#include "../../../../../src/fep_control_tool/job_queue.h"
+#include "../../../../../src/fep_control_tool/json_writer.h"
+#include "../../../../../src/fep_control_tool/line_tokenizer.h"
+#include "../../../../../src/fep_control_tool/log_archive.h"
+#include "../../../../../src/fep_control_tool/log_batcher.h"
+#include "../../../../../src/fep_control_tool/log_buffer.h"
+#include "../../../../../src/fep_control_tool/log_filter.h"
+#include "../../../../../src/fep_control_tool/log_hub.h"
+#include "../../../../../src/fep_control_tool/log_rate_limiter.h"
+#include "../../../../../src/fep_control_tool/log_statistics.h"
+#include "../../../../../src/fep_control_tool/log_latency.h"
+#include "../../../../../src/fep_control_tool/message_writer.h"
+#include "../../../../../src/fep_control_tool/output_buffer.h"
+#include "../../../../../src/fep_control_tool/output_writer.h"
+#include "../../../../../src/fep_control_tool/worker_pool.h"
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <iostream>
+#include <json/json.h>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+std::string writeCompact(const Json::Value& value)
+{
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+    return Json::writeString(builder, value);
+}
+
+// runs the given function and prints the average duration per call, used by the benchmarks
+// which are disabled by default (run them with --gtest_also_run_disabled_tests)
+template <typename Function>
+void measureNanoseconds(const std::string& name, std::size_t iterations, Function&& function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0u; i < iterations; ++i) {
+        function();
+    }
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    const double nanoseconds_per_call = static_cast<double>(duration.count()) / iterations;
+    std::cout << "[ BENCHMARK] " << name << ": " << nanoseconds_per_call << " ns" << std::endl;
+}
+
+const std::string log_message = "Participant test_part_0 changed its state to \"initialized\"";
+
+template <typename... Args>
+std::string formatWithStream(const Args&... args)
+{
+    std::ostringstream stream;
+    using List = int[];
+    (void)List{0, (void(stream << args), 0)...};
+    return stream.str();
+}
+
+std::string bytes(std::initializer_list<unsigned char> values)
+{
+    return std::string(values.begin(), values.end());
+}
+
+template <typename Writer>
+void writeLogRecord(Writer& writer)
+{
+    writer.beginObject(5u);
+    writer.key("log_type");
+    writer.value("message");
+    writer.key("logger_name");
+    writer.value("participant");
+    writer.key("message");
+    writer.value(log_message);
+    writer.key("participant_name");
+    writer.value("test_part_0");
+    writer.key("severity_level");
+    writer.value("Info");
+    writer.endObject();
+}
+
+template <typename... Args>
+std::string formatWithBuffer(const Args&... args)
+{
+    std::string output;
+    formatOutput(output, args...);
+    return output;
+}
+
+} // namespace
+
+TEST(ControlToolJsonWriter, equalsJsonCpp)
+{
+    Json::Value envelope;
+    envelope["action"] = "getSystemState";
+    envelope["status"] = 0;
+    envelope["value"]["homogeneous"] = "homogeneous";
+    envelope["value"]["stateID"] = "4";
+    envelope["value"]["stateName"] = "initialized";
+
+    JsonWriter writer;
+    writer.beginObject(3u);
+    writer.key("action");
+    writer.value("getSystemState");
+    writer.key("status");
+    writer.value(std::int64_t{0});
+    writer.key("value");
+    writer.beginObject(3u);
+    writer.key("homogeneous");
+    writer.value("homogeneous");
+    writer.key("stateID");
+    writer.value("4");
+    writer.key("stateName");
+    writer.value("initialized");
+    writer.endObject();
+    writer.endObject();
+    EXPECT_EQ(writer.str(), writeCompact(envelope));
+
+    Json::Value systems;
+    systems["action"] = "discoverAllSystems";
+    systems["status"] = 0;
+    systems["value"].append(Json::Value());
+    systems["value"][1]["system_name"] = "demo";
+
+    writer.clear();
+    writer.beginObject(3u);
+    writer.key("action");
+    writer.value("discoverAllSystems");
+    writer.key("status");
+    writer.value(std::int64_t{0});
+    writer.key("value");
+    writer.beginArray(2u);
+    writer.nullValue();
+    writer.beginObject(1u);
+    writer.key("system_name");
+    writer.value("demo");
+    writer.endObject();
+    writer.endArray();
+    writer.endObject();
+    EXPECT_EQ(writer.str(), writeCompact(systems));
+}
+
+TEST(ControlToolJsonWriter, escapesLikeJsonCpp)
+{
+    const std::vector<std::string> texts = {"",
+                                            "plain",
+                                            "quote \" and backslash \\",
+                                            "control \b\f\n\r\t\x01\x1f\x7f",
+                                            std::string("nul \0 inside", 12),
+                                            "umlaut \xc3\xa4 euro \xe2\x82\xac",
+                                            "emoji \xf0\x9f\x98\x80",
+                                            "invalid \xc3 \xe2\x82 \xff \xed\xa0\x80",
+                                            "C:\\Program Files (x86)\\"};
+    for (const auto& text: texts) {
+        JsonWriter writer;
+        writer.beginObject(1u);
+        writer.key("note");
+        writer.value(text);
+        writer.endObject();
+
+        Json::Value value;
+        value["note"] = text;
+        EXPECT_EQ(writer.str(), writeCompact(value));
+    }
+}
+
+TEST(ControlToolJsonWriter, DISABLED_benchmarkNotesAndMonitor)
+{
+    constexpr std::size_t iterations = 100000u;
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+
+    measureNanoseconds("note, Json::Value", iterations, [&]() {
+        Json::Value envelope;
+        envelope["action"] = "setParticipantProperty";
+        envelope["status"] = 0;
+        envelope["value"] = Json::Value();
+        envelope["value"]["note"] = "property set";
+        std::ostringstream stream;
+        stream << Json::writeString(builder, envelope) << "\n";
+        return stream.str();
+    });
+    JsonWriter writer;
+    measureNanoseconds("note, JsonWriter", iterations, [&]() {
+        writer.clear();
+        writer.beginObject(3u);
+        writer.key("action");
+        writer.value("setParticipantProperty");
+        writer.key("status");
+        writer.value(std::int64_t{0});
+        writer.key("value");
+        writer.beginObject(1u);
+        writer.key("note");
+        writer.value("property set");
+        writer.endObject();
+        writer.endObject();
+        writer.newLine();
+    });
+
+    measureNanoseconds("log, Json::Value", iterations, [&]() {
+        Json::Value log;
+        log["log_type"] = "message";
+        log["severity_level"] = "Info";
+        log["participant_name"] = "test_part_0";
+        log["logger_name"] = "participant";
+        log["message"] = log_message;
+        std::ostringstream stream;
+        stream << Json::writeString(builder, log) << "\n";
+        return stream.str();
+    });
+    measureNanoseconds("log, JsonWriter", iterations, [&]() {
+        writer.clear();
+        writer.beginObject(5u);
+        writer.key("log_type");
+        writer.value("message");
+        writer.key("logger_name");
+        writer.value("participant");
+        writer.key("message");
+        writer.value(log_message);
+        writer.key("participant_name");
+        writer.value("test_part_0");
+        writer.key("severity_level");
+        writer.value("Info");
+        writer.endObject();
+        writer.newLine();
+    });
+}
+
+TEST(ControlToolOutputBuffer, equalsStreamOutput)
+{
+    const std::string text = "text";
+    const std::string with_nul("a\0b", 3);
+    const char char_array[] = "array";
+    const char* c_string = "c_string";
+    Json::Value json;
+    json["result"] = "test_part_0";
+
+    EXPECT_EQ(formatWithBuffer(text, with_nul, char_array, c_string, "literal"),
+              formatWithStream(text, with_nul, char_array, c_string, "literal"));
+    EXPECT_EQ(formatWithBuffer('c', true, false, 0, -42, 42u, std::int64_t{-9000000000}),
+              formatWithStream('c', true, false, 0, -42, 42u, std::int64_t{-9000000000}));
+    EXPECT_EQ(formatWithBuffer(std::uint8_t{65}, std::size_t{123}, 1.5, 0.1f),
+              formatWithStream(std::uint8_t{65}, std::size_t{123}, 1.5, 0.1f));
+    EXPECT_EQ(formatWithBuffer(json, "\n"), formatWithStream(json, "\n"));
+    // the text line of Monitor::onLog
+    EXPECT_EQ(formatWithBuffer("    LOG [", "Info", "] ", "participant", "@", "test_part_0", " :",
+                               log_message, "\n", "fep> "),
+              formatWithStream("    LOG [", "Info", "] ", "participant", "@", "test_part_0", " :",
+                               log_message, "\n", "fep> "));
+}
+
+TEST(ControlToolOutputBuffer, DISABLED_benchmarkLogLine)
+{
+    constexpr std::size_t iterations = 100000u;
+    const std::string severity = "Info";
+    const std::string logger_name = "participant";
+    const std::string participant_name = "test_part_0";
+
+    // the text line of Monitor::onLog
+    measureNanoseconds("log line, ostringstream", iterations, [&]() {
+        return formatWithStream("    LOG [", severity, "] ", logger_name, "@", participant_name,
+                                " :", log_message, "\n", "fep> ");
+    });
+    std::string output;
+    measureNanoseconds("log line, formatOutput", iterations, [&]() {
+        formatOutput(output, "    LOG [", severity, "] ", logger_name, "@", participant_name,
+                     " :", log_message, "\n", "fep> ");
+    });
+}
+
+TEST(ControlToolBinaryWriter, encodesMsgpack)
+{
+    BinaryWriter writer;
+    const auto encode = [&writer](auto value) {
+        writer.clear(BinaryFormat::msgpack);
+        writer.value(value);
+        return writer.str();
+    };
+    EXPECT_EQ(encode(std::int64_t{0}), bytes({0x00}));
+    EXPECT_EQ(encode(std::int64_t{127}), bytes({0x7f}));
+    EXPECT_EQ(encode(std::int64_t{128}), bytes({0xcc, 0x80}));
+    EXPECT_EQ(encode(std::int64_t{256}), bytes({0xcd, 0x01, 0x00}));
+    EXPECT_EQ(encode(std::int64_t{65536}), bytes({0xce, 0x00, 0x01, 0x00, 0x00}));
+    EXPECT_EQ(encode(std::int64_t{-1}), bytes({0xff}));
+    EXPECT_EQ(encode(std::int64_t{-32}), bytes({0xe0}));
+    EXPECT_EQ(encode(std::int64_t{-33}), bytes({0xd0, 0xdf}));
+    EXPECT_EQ(encode(std::int64_t{-129}), bytes({0xd1, 0xff, 0x7f}));
+    EXPECT_EQ(encode(std::int64_t{INT64_MIN}),
+              bytes({0xd3, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}));
+    EXPECT_EQ(encode(1.1), bytes({0xcb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a}));
+    EXPECT_EQ(encode(true), bytes({0xc3}));
+    EXPECT_EQ(encode("a"), bytes({0xa1, 'a'}));
+    EXPECT_EQ(encode(std::string(32u, 'x')).substr(0u, 2u), bytes({0xd9, 0x20}));
+    EXPECT_EQ(encode(std::string(256u, 'x')).substr(0u, 3u), bytes({0xda, 0x01, 0x00}));
+
+    writer.clear(BinaryFormat::msgpack);
+    writer.beginObject(2u);
+    writer.key("compact");
+    writer.value(true);
+    writer.key("schema");
+    writer.beginArray(2u);
+    writer.nullValue();
+    writer.value(std::int64_t{0});
+    writer.endArray();
+    writer.endObject();
+    EXPECT_EQ(writer.str(),
+              bytes({0x82, 0xa7, 'c', 'o', 'm', 'p', 'a', 'c', 't', 0xc3,
+                     0xa6, 's', 'c', 'h', 'e', 'm', 'a', 0x92, 0xc0, 0x00}));
+}
+
+TEST(ControlToolBinaryWriter, encodesCbor)
+{
+    BinaryWriter writer;
+    const auto encode = [&writer](auto value) {
+        writer.clear(BinaryFormat::cbor);
+        writer.value(value);
+        return writer.str();
+    };
+    // examples of RFC 8949, appendix A
+    EXPECT_EQ(encode(std::int64_t{23}), bytes({0x17}));
+    EXPECT_EQ(encode(std::int64_t{24}), bytes({0x18, 0x18}));
+    EXPECT_EQ(encode(std::int64_t{1000}), bytes({0x19, 0x03, 0xe8}));
+    EXPECT_EQ(encode(std::int64_t{1000000}), bytes({0x1a, 0x00, 0x0f, 0x42, 0x40}));
+    EXPECT_EQ(encode(std::int64_t{1000000000000}),
+              bytes({0x1b, 0x00, 0x00, 0x00, 0xe8, 0xd4, 0xa5, 0x10, 0x00}));
+    EXPECT_EQ(encode(std::int64_t{-1}), bytes({0x20}));
+    EXPECT_EQ(encode(std::int64_t{-100}), bytes({0x38, 0x63}));
+    EXPECT_EQ(encode(std::int64_t{-1000}), bytes({0x39, 0x03, 0xe7}));
+    EXPECT_EQ(encode(1.1), bytes({0xfb, 0x3f, 0xf1, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9a}));
+    EXPECT_EQ(encode(false), bytes({0xf4}));
+    EXPECT_EQ(encode("IETF"), bytes({0x64, 'I', 'E', 'T', 'F'}));
+
+    writer.clear(BinaryFormat::cbor);
+    writer.beginObject(2u);
+    writer.key("a");
+    writer.value(std::int64_t{1});
+    writer.key("b");
+    writer.beginArray(2u);
+    writer.value(std::int64_t{2});
+    writer.nullValue();
+    writer.endArray();
+    writer.endObject();
+    EXPECT_EQ(writer.str(), bytes({0xa2, 0x61, 'a', 0x01, 0x61, 'b', 0x82, 0x02, 0xf6}));
+}
+
+TEST(ControlToolBinaryWriter, replacesInvalidUtf8)
+{
+    BinaryWriter writer;
+    writer.clear(BinaryFormat::cbor);
+    writer.value("\xc3\xa4\xc3 \xed\xa0\x80");
+    EXPECT_EQ(writer.str(), bytes({0x6f, 0xc3, 0xa4, 0xef, 0xbf, 0xbd, ' ', 0xef, 0xbf, 0xbd,
+                                   0xef, 0xbf, 0xbd, 0xef, 0xbf, 0xbd}));
+}
+
+TEST(ControlToolMessageWriter, appendsMessagesWrittenBefore)
+{
+    for (const auto format: {BinaryFormat::none, BinaryFormat::msgpack, BinaryFormat::cbor}) {
+        MessageWriter message;
+        message.clear(format);
+        message.beginObject(1u);
+        message.key("action");
+        message.value("help");
+        message.endObject();
+        message.endMessage();
+        const std::string first = message.str();
+
+        MessageWriter writer;
+        writer.clear(format);
+        writer.beginArray(2u);
+        writer.rawMessage(first);
+        writer.rawMessage(first);
+        writer.endArray();
+        writer.endMessage();
+
+        MessageWriter expected;
+        expected.clear(format);
+        expected.beginArray(2u);
+        for (int index = 0; index < 2; ++index) {
+            expected.beginObject(1u);
+            expected.key("action");
+            expected.value("help");
+            expected.endObject();
+        }
+        expected.endArray();
+        expected.endMessage();
+        EXPECT_EQ(writer.str(), expected.str());
+    }
+}
+
+TEST(ControlToolMessageWriter, encodesJsonValue)
+{
+    Json::Value output;
+    output["action"] = "getParticipantProperty";
+    output["status"] = 0;
+    output["value"]["participant"] = "test_part_0";
+    output["value"]["participant_property"]["value"] = "1.5";
+    output["value"]["list"].append(Json::Value(-7));
+    output["value"]["list"].append(Json::Value(true));
+
+    MessageWriter writer;
+    writer.clear(BinaryFormat::none);
+    writer.value(output);
+    EXPECT_EQ(writer.str(), writeCompact(output));
+
+    for (const auto format: {BinaryFormat::msgpack, BinaryFormat::cbor}) {
+        BinaryWriter expected(format);
+        expected.clear(format);
+        expected.beginObject(3u);
+        expected.key("action");
+        expected.value("getParticipantProperty");
+        expected.key("status");
+        expected.value(std::int64_t{0});
+        expected.key("value");
+        expected.beginObject(3u);
+        expected.key("list");
+        expected.beginArray(2u);
+        expected.value(std::int64_t{-7});
+        expected.value(true);
+        expected.endArray();
+        expected.key("participant");
+        expected.value("test_part_0");
+        expected.key("participant_property");
+        expected.beginObject(1u);
+        expected.key("value");
+        expected.value("1.5");
+        expected.endObject();
+        expected.endObject();
+        expected.endObject();
+
+        writer.clear(format);
+        writer.value(output);
+        EXPECT_EQ(writer.str(), expected.str());
+    }
+}
+
+TEST(ControlToolMessageWriter, writesSmallerBinaryRecords)
+{
+    MessageWriter writer;
+    std::size_t sizes[3] = {};
+    const BinaryFormat formats[3] = {BinaryFormat::none, BinaryFormat::msgpack, BinaryFormat::cbor};
+    for (std::size_t i = 0u; i < 3u; ++i) {
+        writer.clear(formats[i]);
+        writeLogRecord(writer);
+        writer.endMessage();
+        sizes[i] = writer.str().size();
+    }
+
+    // the binary records do not need the json punctuation
+    EXPECT_LT(sizes[1], sizes[0]);
+    EXPECT_LT(sizes[2], sizes[0]);
+}
+
+TEST(ControlToolMessageWriter, DISABLED_benchmarkLogRecord)
+{
+    constexpr std::size_t iterations = 100000u;
+    MessageWriter writer;
+    const BinaryFormat formats[3] = {BinaryFormat::none, BinaryFormat::msgpack, BinaryFormat::cbor};
+    for (const auto format: formats) {
+        measureNanoseconds(std::string("log, ") + getString(format), iterations, [&]() {
+            writer.clear(format);
+            writeLogRecord(writer);
+            writer.endMessage();
+        });
+    }
+}
+
+TEST(ControlToolOutputWriter, parsesFlushPolicy)
+{
+    FlushPolicy policy;
+    EXPECT_TRUE(parseFlushPolicy("prompt", policy));
+    EXPECT_EQ(policy._mode, FlushPolicy::Mode::prompt);
+    EXPECT_TRUE(parseFlushPolicy("25ms", policy));
+    EXPECT_EQ(policy._mode, FlushPolicy::Mode::interval);
+    EXPECT_EQ(policy._interval, std::chrono::milliseconds(25));
+    EXPECT_TRUE(parseFlushPolicy("line", policy));
+    EXPECT_EQ(policy._mode, FlushPolicy::Mode::line);
+    EXPECT_FALSE(parseFlushPolicy("0ms", policy));
+    EXPECT_FALSE(parseFlushPolicy("ms", policy));
+    EXPECT_FALSE(parseFlushPolicy("-5ms", policy));
+    EXPECT_FALSE(parseFlushPolicy("5s", policy));
+}
+
+TEST(ControlToolOutputWriter, writesOutputOfAllThreadsInOrder)
+{
+    constexpr std::size_t producers = 4u;
+    constexpr std::size_t lines_per_producer = 2000u;
+    const FlushPolicy policies[] = {
+        FlushPolicy{FlushPolicy::Mode::line, std::chrono::milliseconds(0)},
+        FlushPolicy{FlushPolicy::Mode::interval, std::chrono::milliseconds(5)},
+        FlushPolicy{FlushPolicy::Mode::prompt, std::chrono::milliseconds(0)}};
+    for (const auto& policy: policies) {
+        std::string written;
+        std::size_t writes = 0u;
+        {
+            AsyncOutputWriter writer(policy, [&written, &writes](const char* data, std::size_t size) {
+                written.append(data, size);
+                ++writes;
+            });
+            std::vector<std::thread> threads;
+            for (std::size_t producer = 0u; producer < producers; ++producer) {
+                threads.emplace_back([&writer, producer]() {
+                    for (std::size_t line = 0u; line < lines_per_producer; ++line) {
+                        writer.push(std::to_string(producer) + ":" + std::to_string(line) + "\n");
+                    }
+                });
+            }
+            for (auto& thread: threads) {
+                thread.join();
+            }
+            writer.push("fep> ");
+            writer.flush();
+            // everything pushed before flush is written when it returns
+            ASSERT_EQ(written.substr(written.size() - 5u), "fep> ");
+        }
+
+        // each producer's lines are complete and in order
+        std::vector<std::size_t> next_line(producers, 0u);
+        std::istringstream lines(written.substr(0u, written.size() - 5u));
+        std::string line;
+        while (std::getline(lines, line)) {
+            const auto separator = line.find(':');
+            const auto producer = std::stoul(line.substr(0u, separator));
+            ASSERT_LT(producer, producers);
+            EXPECT_EQ(std::stoul(line.substr(separator + 1u)), next_line[producer]++);
+        }
+        for (const auto count: next_line) {
+            EXPECT_EQ(count, lines_per_producer);
+        }
+        // fragments are coalesced into fewer writes
+        EXPECT_LT(writes, producers * lines_per_producer);
+    }
+}
+
+TEST(ControlToolOutputWriter, flushesTheOutputOfTheCallingThread)
+{
+    constexpr std::size_t producers = 4u;
+    constexpr std::size_t lines_per_producer = 500u;
+    std::mutex written_mutex;
+    std::string written;
+    AsyncOutputWriter writer(
+        FlushPolicy{FlushPolicy::Mode::prompt, std::chrono::milliseconds(0)},
+        [&written, &written_mutex](const char* data, std::size_t size) {
+            std::lock_guard<std::mutex> lck(written_mutex);
+            written.append(data, size);
+        });
+    std::atomic<std::size_t> missing{0u};
+    std::vector<std::thread> threads;
+    for (std::size_t producer = 0u; producer < producers; ++producer) {
+        threads.emplace_back([&, producer]() {
+            for (std::size_t line = 0u; line < lines_per_producer; ++line) {
+                const std::string text =
+                    "<" + std::to_string(producer) + ":" + std::to_string(line) + ">";
+                writer.push(text);
+                writer.flush();
+                std::lock_guard<std::mutex> lck(written_mutex);
+                if (written.find(text) == std::string::npos) {
+                    ++missing;
+                }
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    EXPECT_EQ(missing, 0u);
+}
+
+TEST(ControlToolLogBuffer, queriesRecords)
+{
+    using namespace std::chrono_literals;
+    LogRingBuffer buffer(8u);
+    buffer.add(10ms, fep3::LoggerSeverity::info, "test_part_0", "participant", "first");
+    buffer.add(20ms, fep3::LoggerSeverity::error, "test_part_1", "participant", "second");
+    buffer.add(30ms, fep3::LoggerSeverity::debug, "test_part_0", "element", "third");
+
+    auto records = buffer.query(LogQuery());
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0]._message, "first");
+    EXPECT_EQ(records[0]._time, 10ms);
+    EXPECT_EQ(records[0]._severity, fep3::LoggerSeverity::info);
+    EXPECT_EQ(records[0]._participant_name, "test_part_0");
+    EXPECT_EQ(records[0]._logger_name, "participant");
+    EXPECT_EQ(records[2]._message, "third");
+
+    LogQuery query;
+    query._since = 20ms;
+    records = buffer.query(query);
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[0]._message, "second");
+
+    query = LogQuery();
+    query._severity = fep3::LoggerSeverity::info;
+    records = buffer.query(query);
+    ASSERT_EQ(records.size(), 2u);
+    EXPECT_EQ(records[1]._message, "second");
+
+    query = LogQuery();
+    query._participant_name = std::string("test_part_0");
+    query._limit = 1u;
+    records = buffer.query(query);
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0]._message, "third");
+}
+
+TEST(ControlToolLogBuffer, overwritesOldestRecords)
+{
+    using namespace std::chrono_literals;
+    LogRingBuffer buffer(5u);
+    const auto statistics_empty = buffer.getStatistics();
+    EXPECT_EQ(statistics_empty._capacity, 8u);
+    EXPECT_EQ(statistics_empty._stored, 0u);
+    EXPECT_GE(statistics_empty._memory_size, 8u * LogRingBuffer::slot_size);
+
+    for (int i = 0; i < 20; ++i) {
+        buffer.add(std::chrono::milliseconds(i), fep3::LoggerSeverity::info, "p", "l",
+                   std::to_string(i));
+    }
+    const auto records = buffer.query(LogQuery());
+    ASSERT_EQ(records.size(), 8u);
+    EXPECT_EQ(records.front()._message, "12");
+    EXPECT_EQ(records.back()._message, "19");
+
+    const auto statistics = buffer.getStatistics();
+    EXPECT_EQ(statistics._written, 20u);
+    EXPECT_EQ(statistics._stored, 8u);
+    EXPECT_EQ(statistics._overwritten, 12u);
+    EXPECT_EQ(statistics._truncated, 0u);
+}
+
+TEST(ControlToolLogBuffer, truncatesLongRecords)
+{
+    using namespace std::chrono_literals;
+    LogRingBuffer buffer(2u);
+    // the cut must not split the two byte sequences of the umlauts
+    std::string message;
+    for (int i = 0; i < 400; ++i) {
+        message += "\xc3\xa4";
+    }
+    buffer.add(1ms, fep3::LoggerSeverity::warning, std::string(100u, 'p'), "logger", message);
+
+    const auto records = buffer.query(LogQuery());
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_TRUE(records[0]._truncated);
+    EXPECT_EQ(records[0]._participant_name, std::string(64u, 'p'));
+    EXPECT_EQ(records[0]._logger_name, "logger");
+    EXPECT_LT(records[0]._message.size(), message.size());
+    EXPECT_EQ(records[0]._message.size() % 2u, 0u);
+    EXPECT_EQ(message.compare(0u, records[0]._message.size(), records[0]._message), 0);
+    EXPECT_EQ(buffer.getStatistics()._truncated, 1u);
+}
+
+TEST(ControlToolLogBuffer, addsAndQueriesConcurrently)
+{
+    constexpr std::size_t writers = 3u;
+    constexpr std::size_t records_per_writer = 5000u;
+    LogRingBuffer buffer(64u);
+    std::atomic<bool> writing{true};
+
+    std::thread reader([&]() {
+        while (writing) {
+            for (const auto& record: buffer.query(LogQuery())) {
+                // a record is either read completely or skipped
+                ASSERT_EQ(record._message, record._participant_name + ":" + record._logger_name);
+            }
+        }
+    });
+    std::vector<std::thread> threads;
+    for (std::size_t writer = 0u; writer < writers; ++writer) {
+        threads.emplace_back([&buffer, writer]() {
+            const std::string participant_name = "test_part_" + std::to_string(writer);
+            for (std::size_t i = 0u; i < records_per_writer; ++i) {
+                const std::string logger_name = std::to_string(i);
+                buffer.add(std::chrono::milliseconds(i), fep3::LoggerSeverity::info,
+                           participant_name, logger_name, participant_name + ":" + logger_name);
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    writing = false;
+    reader.join();
+
+    const auto statistics = buffer.getStatistics();
+    EXPECT_EQ(statistics._written, writers * records_per_writer);
+    EXPECT_EQ(statistics._stored, 64u);
+}
+
+TEST(ControlToolLogLatency, countsLatenciesInBuckets)
+{
+    using namespace std::chrono_literals;
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.getSnapshot()._count, 0u);
+    EXPECT_EQ(histogram.getSnapshot().getPercentile(50.0), 0);
+
+    for (int i = 0; i < 90; ++i) {
+        histogram.add(0ms);
+    }
+    for (int i = 0; i < 9; ++i) {
+        histogram.add(5ms);
+    }
+    histogram.add(100000000ms);
+
+    const auto snapshot = histogram.getSnapshot();
+    EXPECT_EQ(snapshot._count, 100u);
+    EXPECT_EQ(snapshot._min, 0);
+    EXPECT_EQ(snapshot._max, 100000000);
+    EXPECT_EQ(snapshot._buckets[0], 90u);
+    // 5 ms is in [4, 8)
+    EXPECT_EQ(snapshot._buckets[3], 9u);
+    EXPECT_EQ(snapshot._buckets[LatencyHistogram::bucket_count - 1u], 1u);
+    EXPECT_EQ(LatencyHistogram::getUpperBound(3u), 8);
+    EXPECT_EQ(LatencyHistogram::getUpperBound(LatencyHistogram::bucket_count - 1u), -1);
+    EXPECT_EQ(snapshot.getPercentile(50.0), 1);
+    EXPECT_EQ(snapshot.getPercentile(99.0), 8);
+    EXPECT_EQ(snapshot.getPercentile(100.0), 100000000);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.getSnapshot()._count, 0u);
+}
+
+TEST(ControlToolLogLatency, estimatesClockOffsetPerParticipant)
+{
+    using namespace std::chrono_literals;
+    LogLatency latency;
+    // the clocks of both participants differ from the local one
+    latency.add("test_part_0", 100ms, 10100ms);
+    latency.add("test_part_1", 5000ms, 10200ms);
+    latency.add("test_part_0", 200ms, 10230ms);
+    latency.add("test_part_1", 5100ms, 10300ms);
+
+    auto snapshot = latency.getSnapshot();
+    EXPECT_EQ(snapshot._count, 4u);
+    EXPECT_EQ(snapshot._min, 0);
+    EXPECT_EQ(snapshot._max, 30);
+    EXPECT_EQ(snapshot._sum, 30);
+
+    latency.reset();
+    latency.add("test_part_0", 300ms, 10330ms);
+    snapshot = latency.getSnapshot();
+    EXPECT_EQ(snapshot._count, 1u);
+    EXPECT_EQ(snapshot._max, 0);
+}
+
+TEST(ControlToolLogBatcher, passesOnFullBatches)
+{
+    using namespace std::chrono_literals;
+    std::vector<std::vector<LogRecord>> batches;
+    LogBatcher batcher([&batches](const std::vector<LogRecord>& records) {
+        batches.push_back(records);
+    });
+    EXPECT_FALSE(batcher.isStarted());
+    EXPECT_FALSE(batcher.add(1ms, fep3::LoggerSeverity::info, "p", "l", "not batched"));
+
+    batcher.start(3u, 1h);
+    for (int i = 0; i < 7; ++i) {
+        ASSERT_TRUE(batcher.add(
+            std::chrono::milliseconds(i), fep3::LoggerSeverity::info, "p", "l", std::to_string(i)));
+    }
+    ASSERT_EQ(batches.size(), 2u);
+    EXPECT_EQ(batches[0].size(), 3u);
+    EXPECT_EQ(batches[0][0]._message, "0");
+    EXPECT_EQ(batches[1][2]._message, "5");
+    EXPECT_EQ(batches[1][2]._time, 5ms);
+
+    // the pending record is passed on when stopping
+    batcher.stop();
+    ASSERT_EQ(batches.size(), 3u);
+    ASSERT_EQ(batches[2].size(), 1u);
+    EXPECT_EQ(batches[2][0]._message, "6");
+    EXPECT_FALSE(batcher.isStarted());
+}
+
+TEST(ControlToolLogBatcher, passesOnBatchesAfterLatency)
+{
+    using namespace std::chrono_literals;
+    std::mutex batches_mutex;
+    std::condition_variable batch_passed;
+    std::vector<std::vector<LogRecord>> batches;
+    LogBatcher batcher([&](const std::vector<LogRecord>& records) {
+        std::lock_guard<std::mutex> lck(batches_mutex);
+        batches.push_back(records);
+        batch_passed.notify_all();
+    });
+
+    batcher.start(1000u, 20ms);
+    const auto start = std::chrono::steady_clock::now();
+    batcher.add(1ms, fep3::LoggerSeverity::warning, "p", "l", "first");
+    batcher.add(2ms, fep3::LoggerSeverity::warning, "p", "l", "second");
+    {
+        std::unique_lock<std::mutex> lck(batches_mutex);
+        ASSERT_TRUE(batch_passed.wait_for(lck, 5s, [&]() { return !batches.empty(); }));
+        EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+        ASSERT_EQ(batches[0].size(), 2u);
+        EXPECT_EQ(batches[0][1]._message, "second");
+    }
+
+    batcher.add(3ms, fep3::LoggerSeverity::warning, "p", "l", "third");
+    {
+        std::unique_lock<std::mutex> lck(batches_mutex);
+        ASSERT_TRUE(batch_passed.wait_for(lck, 5s, [&]() { return batches.size() == 2u; }));
+        ASSERT_EQ(batches[1].size(), 1u);
+    }
+    batcher.stop();
+    EXPECT_EQ(batches.size(), 2u);
+}
+
+TEST(ControlToolLogFilter, matchesGlobPatterns)
+{
+    EXPECT_TRUE(GlobPattern("test_part_0").matches("test_part_0"));
+    EXPECT_FALSE(GlobPattern("test_part_0").matches("test_part_01"));
+    EXPECT_TRUE(GlobPattern("*").matches(""));
+    EXPECT_TRUE(GlobPattern("test_*").matches("test_part_0"));
+    EXPECT_TRUE(GlobPattern("*_0").matches("test_part_0"));
+    EXPECT_TRUE(GlobPattern("test_part_?").matches("test_part_1"));
+    EXPECT_FALSE(GlobPattern("test_part_?").matches("test_part_"));
+    EXPECT_TRUE(GlobPattern("*part*0").matches("test_part_part_0"));
+    EXPECT_FALSE(GlobPattern("*part*1").matches("test_part_part_0"));
+    EXPECT_TRUE(GlobPattern("a*b*c**").matches("aXbYbZc"));
+    EXPECT_FALSE(GlobPattern("a*b?c").matches("abc"));
+}
+
+TEST(ControlToolLogFilter, appliesAllCriteria)
+{
+    const LogFilter filter(fep3::LoggerSeverity::warning,
+                           std::string("test_part_*"),
+                           std::string("element"),
+                           std::string("time(out|limit)"));
+    EXPECT_TRUE(filter.matches(
+        fep3::LoggerSeverity::error, "test_part_0", "element", "the timeout elapsed"));
+    EXPECT_FALSE(filter.matches(
+        fep3::LoggerSeverity::info, "test_part_0", "element", "the timeout elapsed"));
+    EXPECT_FALSE(filter.matches(
+        fep3::LoggerSeverity::error, "other_part", "element", "the timeout elapsed"));
+    EXPECT_FALSE(filter.matches(
+        fep3::LoggerSeverity::error, "test_part_0", "participant", "the timeout elapsed"));
+    EXPECT_FALSE(
+        filter.matches(fep3::LoggerSeverity::error, "test_part_0", "element", "the time elapsed"));
+
+    const LogFilter no_filter(boost::none, boost::none, boost::none, boost::none);
+    EXPECT_TRUE(no_filter.matches(fep3::LoggerSeverity::debug, "p", "l", "m"));
+
+    EXPECT_THROW(LogFilter(boost::none, boost::none, boost::none, std::string("time(out")),
+                 std::regex_error);
+}
+
+TEST(ControlToolLogRateLimiter, limitsRatePerParticipant)
+{
+    using namespace std::chrono_literals;
+    LogRateLimiter limiter;
+    auto now = LogRateLimiter::Clock::now();
+    EXPECT_TRUE(limiter.admit("test_part_0", 1ms, now));
+    EXPECT_TRUE(limiter.takeDropSummaries(now).empty());
+    EXPECT_TRUE(limiter.getCounters().empty());
+
+    LogRateLimit limit;
+    limit._rate = 10.0;
+    limit._burst = 5u;
+    limiter.setLimit(limit);
+    EXPECT_TRUE(limiter.isLimited());
+
+    std::size_t passed = 0u;
+    for (int i = 0; i < 20; ++i) {
+        passed += limiter.admit("test_part_0", std::chrono::milliseconds(i), now) ? 1u : 0u;
+    }
+    EXPECT_EQ(passed, 5u);
+    // the other participant has its own bucket
+    EXPECT_TRUE(limiter.admit("test_part_1", 1ms, now));
+
+    // 10 messages per second refill a token each 100 ms
+    now += 250ms;
+    passed = 0u;
+    for (int i = 0; i < 5; ++i) {
+        passed += limiter.admit("test_part_0", 30ms, now) ? 1u : 0u;
+    }
+    EXPECT_EQ(passed, 2u);
+
+    const auto summaries = limiter.takeDropSummaries(now);
+    ASSERT_EQ(summaries.size(), 1u);
+    EXPECT_EQ(summaries[0]._participant_name, "test_part_0");
+    EXPECT_EQ(summaries[0]._dropped, 18u);
+    EXPECT_EQ(summaries[0]._log_time, 30ms);
+
+    // the next summary is due after the interval only, unless forced
+    EXPECT_FALSE(limiter.admit("test_part_0", 31ms, now));
+    EXPECT_TRUE(limiter.takeDropSummaries(now + 10ms).empty());
+    EXPECT_EQ(limiter.takeDropSummaries(now + 10ms, true).size(), 1u);
+
+    const auto counters = limiter.getCounters();
+    ASSERT_EQ(counters.size(), 2u);
+    EXPECT_EQ(counters[0]._participant_name, "test_part_0");
+    EXPECT_EQ(counters[0]._passed, 7u);
+    EXPECT_EQ(counters[0]._rate_limited, 19u);
+    EXPECT_EQ(counters[0]._sampled_out, 0u);
+    EXPECT_EQ(counters[1]._passed, 1u);
+
+    limiter.resetCounters();
+    EXPECT_EQ(limiter.getCounters()[0]._rate_limited, 0u);
+}
+
+TEST(ControlToolLogRateLimiter, tellsWhenTheSummaryIsDue)
+{
+    using namespace std::chrono_literals;
+    LogRateLimiter limiter;
+    LogRateLimit limit;
+    limit._sample_every = 2u;
+    limit._summary_interval = 500ms;
+    limiter.setLimit(limit);
+
+    const auto now = LogRateLimiter::Clock::now();
+    EXPECT_TRUE(limiter.admit("test_part_0", 1ms, now));
+    EXPECT_FALSE(limiter.getSummaryDueTime());
+    EXPECT_FALSE(limiter.admit("test_part_0", 2ms, now));
+    ASSERT_TRUE(limiter.getSummaryDueTime());
+    EXPECT_LE(*limiter.getSummaryDueTime(), now);
+    EXPECT_EQ(limiter.takeDropSummaries(now).size(), 1u);
+    EXPECT_FALSE(limiter.getSummaryDueTime());
+
+    // the burst ends with a dropped message, its summary is due after the interval
+    EXPECT_TRUE(limiter.admit("test_part_0", 3ms, now));
+    EXPECT_FALSE(limiter.admit("test_part_0", 4ms, now));
+    ASSERT_TRUE(limiter.getSummaryDueTime());
+    EXPECT_EQ(*limiter.getSummaryDueTime(), now + 500ms);
+    EXPECT_TRUE(limiter.takeDropSummaries(now + 499ms).empty());
+    const auto summaries = limiter.takeDropSummaries(*limiter.getSummaryDueTime());
+    ASSERT_EQ(summaries.size(), 1u);
+    EXPECT_EQ(summaries[0]._dropped, 1u);
+    EXPECT_EQ(summaries[0]._log_time, 4ms);
+}
+
+TEST(ControlToolLogRateLimiter, samplesMessages)
+{
+    using namespace std::chrono_literals;
+    LogRateLimiter limiter;
+    LogRateLimit limit;
+    limit._sample_every = 4u;
+    limiter.setLimit(limit);
+
+    const auto now = LogRateLimiter::Clock::now();
+    std::vector<bool> admitted;
+    for (int i = 0; i < 8; ++i) {
+        admitted.push_back(limiter.admit("test_part_0", 1ms, now));
+    }
+    EXPECT_EQ(admitted,
+              std::vector<bool>({true, false, false, false, true, false, false, false}));
+    EXPECT_EQ(limiter.getCounters()[0]._sampled_out, 6u);
+
+    limiter.setLimit(LogRateLimit());
+    EXPECT_FALSE(limiter.isLimited());
+    EXPECT_TRUE(limiter.admit("test_part_0", 1ms, now));
+}
+
+TEST(ControlToolLogHub, encodesRecordOncePerFormat)
+{
+    using namespace std::chrono_literals;
+    const SharedLogRecord record(LogRecord{
+        42ms, fep3::LoggerSeverity::info, "test_part_0", "participant", "started", false});
+
+    const auto& text = record.getEncoding(SharedLogRecord::Encoding::text);
+    EXPECT_EQ(text,
+              "    LOG [" + getString(fep3::LoggerSeverity::info) +
+                  "] [42 ms] participant@test_part_0 :started\nfep> ");
+
+    const auto& json = record.getEncoding(SharedLogRecord::Encoding::json);
+    Json::Value root;
+    ASSERT_TRUE(Json::Reader().parse(json, root));
+    EXPECT_EQ(root["log_type"].asString(), "message");
+    EXPECT_EQ(root["participant_name"].asString(), "test_part_0");
+    EXPECT_EQ(root["timestamp"].asInt64(), 42);
+    EXPECT_EQ(json.back(), '\n');
+
+    const auto& msgpack = record.getEncoding(SharedLogRecord::Encoding::msgpack);
+    ASSERT_FALSE(msgpack.empty());
+    // fixmap of 6 entries
+    EXPECT_EQ(static_cast<unsigned char>(msgpack[0]), 0x86u);
+    const auto& cbor = record.getEncoding(SharedLogRecord::Encoding::cbor);
+    ASSERT_FALSE(cbor.empty());
+    EXPECT_EQ(static_cast<unsigned char>(cbor[0]), 0xA6u);
+
+    // all threads get the same encoding
+    std::vector<const std::string*> encodings(4u, nullptr);
+    std::vector<std::thread> threads;
+    for (std::size_t index = 0u; index < encodings.size(); ++index) {
+        threads.emplace_back([&record, &encodings, index]() {
+            encodings[index] = &record.getEncoding(SharedLogRecord::Encoding::json);
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    for (const auto* encoding: encodings) {
+        EXPECT_EQ(encoding, &json);
+    }
+
+    EXPECT_EQ(SharedLogRecord::selectEncoding(false, BinaryFormat::cbor),
+              SharedLogRecord::Encoding::text);
+    EXPECT_EQ(SharedLogRecord::selectEncoding(true, BinaryFormat::none),
+              SharedLogRecord::Encoding::json);
+    EXPECT_EQ(SharedLogRecord::selectEncoding(true, BinaryFormat::msgpack),
+              SharedLogRecord::Encoding::msgpack);
+}
+
+TEST(ControlToolLogHub, tagsRecordsWithTheSystem)
+{
+    using namespace std::chrono_literals;
+    const SharedLogRecord record(LogRecord{42ms,
+                                           fep3::LoggerSeverity::info,
+                                           "test_part_0",
+                                           "participant",
+                                           "started",
+                                           false,
+                                           "test_system"});
+    EXPECT_EQ(record.getEncoding(SharedLogRecord::Encoding::text),
+              "    LOG [" + getString(fep3::LoggerSeverity::info) +
+                  "] [42 ms] participant@test_part_0@test_system :started\nfep> ");
+
+    Json::Value root;
+    ASSERT_TRUE(Json::Reader().parse(record.getEncoding(SharedLogRecord::Encoding::json), root));
+    EXPECT_EQ(root["system_name"].asString(), "test_system");
+    EXPECT_EQ(root.size(), 7u);
+    // fixmap of 7 entries
+    EXPECT_EQ(static_cast<unsigned char>(record.getEncoding(SharedLogRecord::Encoding::msgpack)[0]),
+              0x87u);
+}
+
+namespace {
+class TestLogSubscriber : public LogSubscriber {
+public:
+    void push(std::shared_ptr<const SharedLogRecord> record) override
+    {
+        _records.push_back(std::move(record));
+    }
+    std::vector<std::shared_ptr<const SharedLogRecord>> _records;
+};
+} // namespace
+
+TEST(ControlToolLogHub, sharesOneChannelPerSystem)
+{
+    using namespace std::chrono_literals;
+    auto channel = LogHub::getInstance().getChannel("log_hub_test_system");
+    EXPECT_EQ(LogHub::getInstance().getChannel("log_hub_test_system"), channel);
+    EXPECT_NE(LogHub::getInstance().getChannel("other_log_hub_test_system"), channel);
+    EXPECT_EQ(channel->getSystemName(), "log_hub_test_system");
+
+    fep3::System system("log_hub_test_system");
+    TestLogSubscriber first_session, second_session;
+    channel->subscribe(system, first_session);
+    channel->subscribe(system, second_session);
+    channel->subscribe(system, second_session);
+    EXPECT_EQ(channel->getSubscriberCount(), 2u);
+
+    fep3::IEventMonitor& monitor = *channel;
+    monitor.onLog(1ms, fep3::LoggerSeverity::info, "test_part_0", "participant", "first");
+    ASSERT_EQ(first_session._records.size(), 1u);
+    ASSERT_EQ(second_session._records.size(), 1u);
+    // the record is shared, not copied per session
+    EXPECT_EQ(first_session._records[0], second_session._records[0]);
+    EXPECT_EQ(first_session._records[0]->getRecord()._message, "first");
+
+    channel->unsubscribe(first_session);
+    monitor.onLog(2ms, fep3::LoggerSeverity::info, "test_part_0", "participant", "second");
+    EXPECT_EQ(first_session._records.size(), 1u);
+    EXPECT_EQ(second_session._records.size(), 2u);
+    channel->unsubscribe(second_session);
+    EXPECT_EQ(channel->getSubscriberCount(), 0u);
+
+    // the log buffer keeps the messages of all sessions
+    EXPECT_EQ(channel->getLogBuffer().query(LogQuery()).size(), 2u);
+    EXPECT_EQ(channel->getLogLatency().getSnapshot()._count, 2u);
+
+    // the hub forgets a channel once no session holds it
+    const auto channel_count = LogHub::getInstance().getChannelCount();
+    channel.reset();
+    EXPECT_EQ(LogHub::getInstance().getChannelCount(), channel_count - 1u);
+}
+
+namespace {
+// an empty directory for the archive, removed again by the destructor
+struct TemporaryDirectory {
+    explicit TemporaryDirectory(const std::string& name)
+        : _path((std::filesystem::temp_directory_path() / name).string())
+    {
+        std::filesystem::remove_all(_path);
+    }
+    ~TemporaryDirectory()
+    {
+        std::error_code error;
+        std::filesystem::remove_all(_path, error);
+    }
+    const std::string _path;
+};
+
+void writeArchive(const std::string& directory, std::int64_t first_time, std::int64_t count)
+{
+    // the smallest segment size, so the records are spread over several segments
+    LogArchiveWriter writer(directory, 4096u);
+    for (std::int64_t time = first_time; time < first_time + count; ++time) {
+        writer.add(LogRecord{std::chrono::milliseconds(time),
+                             fep3::LoggerSeverity::info,
+                             time % 2 == 0 ? "test_part_0" : "test_part_1",
+                             "participant",
+                             "archived message " + std::to_string(time),
+                             false});
+    }
+    writer.flush();
+    const auto statistics = writer.getStatistics();
+    EXPECT_EQ(statistics._written, static_cast<std::uint64_t>(count));
+    EXPECT_EQ(statistics._dropped, 0u);
+    EXPECT_GT(statistics._segments, 1u);
+}
+} // namespace
+
+TEST(ControlToolLogArchive, queriesRecordsOfAllSegments)
+{
+    const TemporaryDirectory directory("fep_control_log_archive_query");
+    writeArchive(directory._path, 0, 1000);
+
+    auto records = queryLogArchive(directory._path, LogArchiveQuery());
+    ASSERT_EQ(records.size(), 1000u);
+    for (std::size_t index = 0u; index < records.size(); ++index) {
+        EXPECT_EQ(records[index]._time.count(), static_cast<std::int64_t>(index));
+    }
+    EXPECT_EQ(records[7]._participant_name, "test_part_1");
+    EXPECT_EQ(records[7]._logger_name, "participant");
+    EXPECT_EQ(records[7]._message, "archived message 7");
+
+    LogArchiveQuery query;
+    query._since = std::chrono::milliseconds(100);
+    query._until = std::chrono::milliseconds(199);
+    query._participant_name = std::string("test_part_0");
+    records = queryLogArchive(directory._path, query);
+    ASSERT_EQ(records.size(), 50u);
+    EXPECT_EQ(records.front()._time.count(), 100);
+    EXPECT_EQ(records.back()._time.count(), 198);
+
+    // the limit keeps the most recent records
+    query = LogArchiveQuery();
+    query._limit = 10u;
+    records = queryLogArchive(directory._path, query);
+    ASSERT_EQ(records.size(), 10u);
+    EXPECT_EQ(records.front()._time.count(), 990);
+
+    query = LogArchiveQuery();
+    query._participant_name = std::string("unknown");
+    EXPECT_TRUE(queryLogArchive(directory._path, query).empty());
+    EXPECT_THROW(queryLogArchive(directory._path + "_missing", query), std::runtime_error);
+}
+
+TEST(ControlToolLogArchive, appendsAndRebuildsMissingIndexes)
+{
+    const TemporaryDirectory directory("fep_control_log_archive_append");
+    writeArchive(directory._path, 0, 500);
+    // a second writer appends new segments
+    writeArchive(directory._path, 500, 500);
+
+    // the segments of a crashed writer have no index
+    for (const auto& entry: std::filesystem::directory_iterator(directory._path)) {
+        if (entry.path().extension() == ".idx") {
+            std::filesystem::remove(entry.path());
+        }
+    }
+    LogArchiveQuery query;
+    query._participant_name = std::string("test_part_1");
+    const auto records = queryLogArchive(directory._path, query);
+    ASSERT_EQ(records.size(), 500u);
+    EXPECT_EQ(records.front()._time.count(), 1);
+    EXPECT_EQ(records.back()._time.count(), 999);
+}
+
+TEST(ControlToolLogStatistics, countsPerParticipantLoggerAndSeverity)
+{
+    using namespace std::chrono_literals;
+    LogStatistics statistics;
+    statistics.add(10ms, fep3::LoggerSeverity::info, "test_part_0", "element", 5u);
+    statistics.add(20ms, fep3::LoggerSeverity::info, "test_part_0", "element", 7u);
+    statistics.add(30ms, fep3::LoggerSeverity::error, "test_part_0", "element", 1u);
+    statistics.add(40ms, fep3::LoggerSeverity::info, "test_part_1", "element", 3u);
+
+    auto snapshot = statistics.getSnapshot();
+    ASSERT_EQ(snapshot._counters.size(), 3u);
+    // the most messages first
+    EXPECT_EQ(snapshot._counters[0]._participant_name, "test_part_0");
+    EXPECT_EQ(snapshot._counters[0]._logger_name, "element");
+    EXPECT_EQ(snapshot._counters[0]._severity, fep3::LoggerSeverity::info);
+    EXPECT_EQ(snapshot._counters[0]._count, 2u);
+    EXPECT_EQ(snapshot._counters[0]._bytes, 12u);
+    EXPECT_EQ(snapshot._counters[0]._last_seen, 20ms);
+    EXPECT_EQ(snapshot._counters[1]._severity, fep3::LoggerSeverity::error);
+    EXPECT_EQ(snapshot._counters[2]._participant_name, "test_part_1");
+    EXPECT_EQ(snapshot._overflow, 0u);
+
+    statistics.reset();
+    EXPECT_TRUE(statistics.getSnapshot()._counters.empty());
+    statistics.add(50ms, fep3::LoggerSeverity::info, "test_part_1", "element", 3u);
+    snapshot = statistics.getSnapshot();
+    ASSERT_EQ(snapshot._counters.size(), 1u);
+    EXPECT_EQ(snapshot._counters[0]._count, 1u);
+    EXPECT_EQ(snapshot._counters[0]._last_seen, 50ms);
+}
+
+TEST(ControlToolLogStatistics, countsConcurrentlyAndOverflows)
+{
+    using namespace std::chrono_literals;
+    LogStatistics statistics;
+    constexpr std::size_t thread_count = 4u;
+    constexpr std::size_t key_count = 100u;
+    std::vector<std::thread> threads;
+    for (std::size_t thread = 0u; thread < thread_count; ++thread) {
+        threads.emplace_back([&statistics]() {
+            for (std::size_t message = 0u; message < 10u * key_count; ++message) {
+                statistics.add(1ms,
+                               fep3::LoggerSeverity::debug,
+                               "test_part_" + std::to_string(message % key_count),
+                               "element",
+                               1u);
+            }
+        });
+    }
+    for (auto& thread: threads) {
+        thread.join();
+    }
+    auto snapshot = statistics.getSnapshot();
+    ASSERT_EQ(snapshot._counters.size(), key_count);
+    for (const auto& counters: snapshot._counters) {
+        EXPECT_EQ(counters._count, 10u * thread_count);
+    }
+
+    // messages of keys exceeding the table are counted as overflow
+    for (std::size_t key = key_count; key < LogStatistics::max_entries + 10u; ++key) {
+        statistics.add(1ms, fep3::LoggerSeverity::debug, "test_part_" + std::to_string(key), "", 1u);
+    }
+    snapshot = statistics.getSnapshot();
+    EXPECT_EQ(snapshot._counters.size(), LogStatistics::max_entries);
+    EXPECT_EQ(snapshot._overflow, 10u);
+}
+
+TEST(ControlToolCompletionCache, fetchesInTheBackground)
+{
+    std::mutex mutex;
+    std::condition_variable released;
+    bool release = false;
+    std::size_t fetch_count = 0u;
+    CompletionCache cache([&](const fep3::System&) {
+        std::unique_lock<std::mutex> lck(mutex);
+        // a slow service bus
+        released.wait(lck, [&release]() { return release; });
+        ++fetch_count;
+        return std::vector<std::string>{"test_part_0", "test_part_1"};
+    });
+    const fep3::System system("completion_test_system");
+    std::vector<std::string> participant_names;
+
+    // refreshes are ignored until enabled
+    cache.refresh("completion_test_system", system);
+    cache.waitForRefresh();
+    EXPECT_FALSE(cache.getParticipantNames("completion_test_system", participant_names));
+
+    cache.enable();
+    cache.refresh("completion_test_system", system);
+    // reading does not wait for the fetch
+    EXPECT_FALSE(cache.getParticipantNames("completion_test_system", participant_names));
+    {
+        std::lock_guard<std::mutex> lck(mutex);
+        release = true;
+    }
+    released.notify_all();
+    cache.waitForRefresh();
+    ASSERT_TRUE(cache.getParticipantNames("completion_test_system", participant_names));
+    EXPECT_EQ(participant_names, (std::vector<std::string>{"test_part_0", "test_part_1"}));
+    EXPECT_EQ(fetch_count, 1u);
+
+    cache.remove("completion_test_system");
+    EXPECT_FALSE(cache.getParticipantNames("completion_test_system", participant_names));
+}
+
+TEST(ControlToolCompletionIndex, completesByPrefixAndEvictsLeastRecentlyUsed)
+{
+    const std::vector<std::string> sorted_names = {"clock", "clock/main_clock", "clock/step_size",
+                                                   "system"};
+    EXPECT_EQ(completePrefix(sorted_names, "clock/"),
+              (std::vector<std::string>{"clock/main_clock", "clock/step_size"}));
+    EXPECT_EQ(completePrefix(sorted_names, "").size(), 4u);
+    EXPECT_TRUE(completePrefix(sorted_names, "t").empty());
+
+    CompletionIndex index(3u);
+    index.add("b/path");
+    index.add("a/path");
+    index.add("c/path");
+    index.add("b/path");
+    EXPECT_EQ(index.complete(""), (std::vector<std::string>{"a/path", "b/path", "c/path"}));
+    // a/path is used least recently
+    index.add("d/path");
+    EXPECT_EQ(index.getSize(), 3u);
+    EXPECT_EQ(index.complete(""), (std::vector<std::string>{"b/path", "c/path", "d/path"}));
+    EXPECT_EQ(index.complete("c"), (std::vector<std::string>{"c/path"}));
+}
+
+TEST(ControlToolCompletionIndex, persistsTheRecentlyUsedNames)
+{
+    const std::string file_path =
+        (std::filesystem::temp_directory_path() / "fep_control_completion_test").string();
+    CompletionIndex index(3u);
+    index.add("a/path");
+    index.add("b/path");
+    index.add("c/path");
+    index.add("a/path");
+    ASSERT_TRUE(index.save(file_path));
+
+    CompletionIndex loaded(2u);
+    ASSERT_TRUE(loaded.load(file_path));
+    // the most recently used names are kept
+    EXPECT_EQ(loaded.complete(""), (std::vector<std::string>{"a/path", "c/path"}));
+    std::filesystem::remove(file_path);
+    EXPECT_FALSE(loaded.load(file_path));
+}
+
+TEST(ControlToolCommandIndex, findsEveryName)
+{
+    std::vector<std::string> names;
+    for (std::size_t index = 0u; index < 200u; ++index) {
+        names.push_back("command" + std::to_string(index));
+    }
+    const std::vector<std::string_view> name_views(names.begin(), names.end());
+    const CommandIndex index(name_views);
+    EXPECT_EQ(index.getSize(), names.size());
+    for (std::size_t position = 0u; position < names.size(); ++position) {
+        EXPECT_EQ(index.find(names[position]), position);
+    }
+    EXPECT_EQ(index.find("command200"), CommandIndex::npos);
+    EXPECT_EQ(index.find("command"), CommandIndex::npos);
+    EXPECT_EQ(index.find(""), CommandIndex::npos);
+}
+
+TEST(ControlToolCommandIndex, rejectsAnInconsistentTable)
+{
+    EXPECT_THROW(CommandIndex({"help", "exit", "help"}), std::logic_error);
+    EXPECT_THROW(CommandIndex({"help", ""}), std::logic_error);
+    EXPECT_EQ(CommandIndex({}).find("help"), CommandIndex::npos);
+}
+
+namespace {
+// parseLine as it was before the line tokenizer, copying every word twice
+bool getNextWordCopied(const char*& src, std::string& dest)
+{
+    dest.clear();
+    while (std::isspace(*src)) {
+        src++;
+    }
+    if (*src == '\0') {
+        return false;
+    }
+    bool escape_active = false;
+    char last_char = '\0';
+    char quote = '\0';
+    if (*src == '\"' || *src == '\'') {
+        quote = *(src++);
+        const char* src_start = src;
+        while (*src != '\0' && (escape_active || *src != quote)) {
+            escape_active = (*src == '\\' && last_char != '\\');
+            last_char = *src;
+            src++;
+        }
+        dest = std::string(src_start, src);
+        if (*src == quote) {
+            src++;
+        }
+    }
+    else {
+        const char* src_start = src;
+        while (*src != '\0' && !std::isspace(*src)) {
+            src++;
+            if (*src == '\"' || *src == '\'') {
+                quote = *(src);
+                do {
+                    escape_active = (*src == '\\' && last_char != '\\');
+                    last_char = *src;
+                    src++;
+                } while (*src != '\0' && (escape_active || *src != quote));
+            }
+        }
+        dest = std::string(src_start, src);
+    }
+    return true;
+}
+
+std::vector<std::string> parseLineCopied(const std::string& line, bool add_empty = false)
+{
+    const char* p = line.c_str();
+    std::vector<std::string> words;
+    std::string word;
+    const char* last_p = p;
+    while (getNextWordCopied(p, word)) {
+        words.push_back(unEscape(word));
+        last_p = p;
+    }
+    if (add_empty && last_p != p) {
+        words.emplace_back();
+    }
+    return words;
+}
+} // namespace
+
+TEST(ControlToolLineTokenizer, splitsLikeTheFormerParser)
+{
+    LineTokenizer tokenizer;
+    const auto tokenize = [&tokenizer](const std::string& line, bool add_empty) {
+        const auto& words = tokenizer.tokenize(line, add_empty);
+        return std::vector<std::string>(words.begin(), words.end());
+    };
+    for (const std::string line: {"",
+                                  "   ",
+                                  "help",
+                                  "  getParticipantState  system  part ",
+                                  "setParticipantProperty \"my system\" part 'a b' \"\"",
+                                  "loadSystem \"my \\\"quoted\\\" system\"",
+                                  "word\"with quotes\"inside 'open quote",
+                                  "back\\\\slash \\\\\\\" end\\",
+                                  "tab\tseparated\nwords"}) {
+        EXPECT_EQ(tokenize(line, false), parseLineCopied(line)) << line;
+        EXPECT_EQ(tokenize(line, true), parseLineCopied(line, true)) << line;
+    }
+
+    // all short lines of the characters which matter to the parser
+    const std::string characters = "a \"'\\";
+    std::string line;
+    std::vector<std::string> words;
+    for (std::size_t combination = 0u; combination < 5u * 5u * 5u * 5u * 5u * 5u * 5u;
+         ++combination) {
+        line.clear();
+        for (std::size_t value = combination; value > 0u; value /= 5u) {
+            line += characters[value % 5u];
+        }
+        ASSERT_EQ(tokenize(line, true), parseLineCopied(line, true)) << line;
+        tokenizer.tokenize(line, words);
+        ASSERT_EQ(words, parseLineCopied(line)) << line;
+    }
+}
+
+TEST(ControlToolLineTokenizer, DISABLED_benchmarkCommandLine)
+{
+    constexpr std::size_t iterations = 100000u;
+    const std::string line =
+        "setParticipantProperty \"my system\" test_part_0 clock/main_clock local_system_realtime";
+    const std::string escaped_line = "loadSystem \"my \\\"quoted\\\" system\"";
+
+    std::size_t word_count = 0u;
+    measureNanoseconds("command line, copied words", iterations, [&]() {
+        word_count += parseLineCopied(line).size();
+    });
+    LineTokenizer tokenizer;
+    measureNanoseconds("command line, sliced words", iterations, [&]() {
+        word_count += tokenizer.tokenize(line).size();
+    });
+    std::vector<std::string> words;
+    measureNanoseconds("command line, reused strings", iterations, [&]() {
+        tokenizer.tokenize(line, words);
+        word_count += words.size();
+    });
+    measureNanoseconds("escaped line, copied words", iterations, [&]() {
+        word_count += parseLineCopied(escaped_line).size();
+    });
+    measureNanoseconds("escaped line, sliced words", iterations, [&]() {
+        word_count += tokenizer.tokenize(escaped_line).size();
+    });
+    EXPECT_EQ(word_count, iterations * (5u + 5u + 5u + 2u + 2u));
+}
+
+TEST(ControlToolCommandScript, parsesParallelBlocksAndBarriers)
+{
+    std::istringstream script("# set up the participants\n"
+                              "discoverSystem my_system\n"
+                              "\n"
+                              "parallel {\n"
+                              "    initializeParticipant my_system \"part 0\"\n"
+                              "    initializeParticipant my_system part_1\n"
+                              "}\n"
+                              "wait\n"
+                              "getSystemState my_system\n");
+    std::vector<ScriptStep> steps;
+    std::string error;
+    ASSERT_TRUE(parseCommandScript(script, steps, error)) << error;
+    ASSERT_EQ(steps.size(), 4u);
+    EXPECT_EQ(steps[0]._kind, ScriptStep::Kind::command);
+    EXPECT_EQ(steps[0]._commands.front()._line_number, 2u);
+    EXPECT_EQ(steps[1]._kind, ScriptStep::Kind::parallel);
+    ASSERT_EQ(steps[1]._commands.size(), 2u);
+    EXPECT_EQ(steps[1]._commands[0]._tokens,
+              (std::vector<std::string>{"initializeParticipant", "my_system", "part 0"}));
+    EXPECT_EQ(steps[1]._commands[1]._line_number, 6u);
+    EXPECT_EQ(steps[2]._kind, ScriptStep::Kind::wait);
+    EXPECT_TRUE(steps[2]._commands.empty());
+    EXPECT_EQ(steps[3]._kind, ScriptStep::Kind::command);
+
+    const std::vector<std::pair<std::string, std::string>> invalid_scripts = {
+        {"parallel {\nparallel {\n}\n}\n", "line 2"},
+        {"parallel {\nwait\n}\n", "line 2"},
+        {"help\n}\n", "line 2"},
+        {"parallel\n", "line 1"},
+        {"help\nparallel {\nhelp\n", "line 2"}};
+    for (const auto& invalid_script: invalid_scripts) {
+        std::istringstream input(invalid_script.first);
+        EXPECT_FALSE(parseCommandScript(input, steps, error)) << invalid_script.first;
+        EXPECT_EQ(error.compare(0u, 6u, invalid_script.second), 0) << error;
+    }
+}
+
+TEST(ControlToolCommandScript, splitsChainedCommands)
+{
+    LineTokenizer tokenizer;
+    std::vector<ChainedCommand> commands;
+    std::string error;
+    ASSERT_TRUE(parseCommandChain(
+        "discoverSystem s && startSystem s; setParticipantProperty s p x \";\" '&&' a\\; ;",
+        tokenizer,
+        commands,
+        error))
+        << error;
+    ASSERT_EQ(commands.size(), 3u);
+    EXPECT_EQ(commands[0]._tokens, (std::vector<std::string>{"discoverSystem", "s"}));
+    EXPECT_FALSE(commands[0]._after_success);
+    EXPECT_EQ(commands[1]._tokens, (std::vector<std::string>{"startSystem", "s"}));
+    EXPECT_TRUE(commands[1]._after_success);
+    EXPECT_EQ(commands[2]._tokens,
+              (std::vector<std::string>{"setParticipantProperty", "s", "p", "x", ";", "&&", "a;"}));
+    EXPECT_FALSE(commands[2]._after_success);
+
+    ASSERT_TRUE(parseCommandChain("   ", tokenizer, commands, error));
+    EXPECT_TRUE(commands.empty());
+    for (const auto* invalid_line: {"; help", "help ; ; help", "help &&"}) {
+        EXPECT_FALSE(parseCommandChain(invalid_line, tokenizer, commands, error)) << invalid_line;
+    }
+}
+
+TEST(ControlToolCommandScript, parsesJsonCommands)
+{
+    std::vector<ChainedCommand> commands;
+    std::string error;
+    ASSERT_TRUE(parseJsonCommands(
+        R"([{"cmd": "help"},)"
+        R"( {"id": 7, "cmd": "configureTiming3ClockSimOnly", "args": ["s", 100, 0.5]}])",
+        commands,
+        error))
+        << error;
+    ASSERT_EQ(commands.size(), 2u);
+    EXPECT_EQ(commands[0]._tokens, (std::vector<std::string>{"help"}));
+    EXPECT_TRUE(commands[0]._id.isNull());
+    EXPECT_EQ(commands[1]._tokens,
+              (std::vector<std::string>{"configureTiming3ClockSimOnly", "s", "100", "0.5"}));
+    EXPECT_EQ(commands[1]._id, Json::Value(7));
+    EXPECT_FALSE(commands[1]._after_success);
+
+    // structured arguments are passed on as compact json, without escaping them twice
+    ASSERT_TRUE(parseJsonCommands(
+        R"({"id": "a", "cmd": "callRPC", "args": ["s", "p", "svc", "iid", "f", {"x": [1, "y"]}]})",
+        commands,
+        error))
+        << error;
+    ASSERT_EQ(commands.size(), 1u);
+    EXPECT_EQ(commands[0]._id, Json::Value("a"));
+    EXPECT_EQ(commands[0]._tokens.back(), R"({"x":[1,"y"]})");
+
+    ASSERT_TRUE(parseJsonCommands(
+        R"({"cmd": "startSystem", "args": ["s"], "async": true})", commands, error))
+        << error;
+    EXPECT_TRUE(commands[0]._async);
+
+    for (const auto* invalid_commands: {"[", "[]", "\"help\"", R"([{"args": []}])",
+                                        R"([{"cmd": "help", "args": "s"}])",
+                                        R"([{"cmd": "help", "args": [null]}])",
+                                        R"({"id": [1], "cmd": "help"})",
+                                        R"({"cmd": "help", "async": 1})"}) {
+        EXPECT_FALSE(parseJsonCommands(invalid_commands, commands, error)) << invalid_commands;
+    }
+    // the id of an invalid command is known for its error message
+    EXPECT_FALSE(parseJsonCommands(R"([{"cmd": "help"}, {"id": 3}])", commands, error));
+    ASSERT_EQ(commands.size(), 2u);
+    EXPECT_EQ(commands.back()._id, Json::Value(3));
+}
+
+TEST(ControlToolWorkerPool, runsTasksConcurrentlyUntilWait)
+{
+    WorkerPool workers(4u);
+    EXPECT_EQ(workers.getThreadCount(), 4u);
+
+    // the tasks only finish if all of them run at the same time
+    std::mutex mutex;
+    std::condition_variable all_started;
+    std::size_t started = 0u;
+    std::atomic<std::size_t> done{0u};
+    for (std::size_t index = 0u; index < 4u; ++index) {
+        workers.submit([&]() {
+            std::unique_lock<std::mutex> lck(mutex);
+            ++started;
+            all_started.notify_all();
+            all_started.wait_for(lck, std::chrono::seconds(10), [&]() { return started == 4u; });
+            ++done;
+        });
+    }
+    workers.wait();
+    EXPECT_EQ(started, 4u);
+    EXPECT_EQ(done, 4u);
+
+    for (std::size_t index = 0u; index < 100u; ++index) {
+        workers.submit([&done]() { ++done; });
+    }
+    workers.wait();
+    EXPECT_EQ(done, 104u);
+}
+
+TEST(ControlToolScriptGraph, ordersCommandsPerTarget)
+{
+    ScriptGraph graph;
+    graph.add(CommandTarget{false, "a", ""});
+    graph.add(CommandTarget{false, "a", "p1"});
+    graph.add(CommandTarget{false, "a", "p2"});
+    graph.add(CommandTarget{false, "a", "p1"});
+    graph.add(CommandTarget{false, "b", ""});
+    graph.add(CommandTarget{false, "", ""});
+    graph.add(CommandTarget{false, "a", ""});
+    graph.add(CommandTarget{true, "", ""});
+    graph.add(CommandTarget{false, "b", "p1"});
+    ASSERT_EQ(graph.getSize(), 9u);
+
+    using Dependencies = std::vector<std::size_t>;
+    EXPECT_EQ(graph.getDependencies(0u), Dependencies{});
+    EXPECT_EQ(graph.getDependencies(1u), Dependencies{0u});
+    EXPECT_EQ(graph.getDependencies(2u), Dependencies{0u});
+    EXPECT_EQ(graph.getDependencies(3u), (Dependencies{0u, 1u}));
+    // other systems and commands without target are independent
+    EXPECT_EQ(graph.getDependencies(4u), Dependencies{});
+    EXPECT_EQ(graph.getDependencies(5u), Dependencies{});
+    EXPECT_EQ(graph.getDependencies(6u), (Dependencies{0u, 1u, 2u, 3u}));
+    EXPECT_EQ(graph.getDependencies(7u), (Dependencies{0u, 1u, 2u, 3u, 4u, 5u, 6u}));
+    EXPECT_EQ(graph.getDependencies(8u), Dependencies{7u});
+
+    // each command starts after the commands it waits for
+    WorkerPool workers(4u);
+    std::vector<std::atomic<bool>> done(graph.getSize());
+    std::atomic<std::size_t> started_too_early{0u};
+    std::atomic<std::size_t> run_count{0u};
+    graph.run(workers, [&](std::size_t index) {
+        for (const std::size_t dependency: graph.getDependencies(index)) {
+            if (!done[dependency]) {
+                ++started_too_early;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++run_count;
+        done[index] = true;
+    });
+    EXPECT_EQ(run_count, graph.getSize());
+    EXPECT_EQ(started_too_early, 0u);
+}
+
+TEST(ControlToolCommandScheduler, ordersSubmittedCommandsLikeTheScriptGraph)
+{
+    const std::vector<CommandTarget> targets = {CommandTarget{false, "a", ""},
+                                                CommandTarget{false, "a", "p1"},
+                                                CommandTarget{false, "a", "p2"},
+                                                CommandTarget{false, "a", "p1"},
+                                                CommandTarget{false, "b", ""},
+                                                CommandTarget{false, "", ""},
+                                                CommandTarget{false, "a", ""},
+                                                CommandTarget{true, "", ""},
+                                                CommandTarget{false, "b", "p1"}};
+    ScriptGraph graph;
+    for (const auto& target: targets) {
+        graph.add(target);
+    }
+
+    WorkerPool workers(4u);
+    std::vector<std::atomic<bool>> done(targets.size());
+    std::atomic<std::size_t> started_too_early{0u};
+    std::atomic<std::size_t> run_count{0u};
+    std::mutex mutex;
+    std::condition_variable overtaken;
+    bool other_system_done = false;
+    std::vector<std::string> order;
+    {
+        CommandScheduler scheduler(workers);
+        for (std::size_t index = 0u; index < targets.size(); ++index) {
+            scheduler.submit(targets[index], [&, index]() {
+                for (const std::size_t dependency: graph.getDependencies(index)) {
+                    if (!done[dependency]) {
+                        ++started_too_early;
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                ++run_count;
+                done[index] = true;
+            });
+        }
+        scheduler.wait();
+        EXPECT_EQ(run_count, targets.size());
+        EXPECT_EQ(started_too_early, 0u);
+
+        // a command on another system overtakes a blocked one, the same system waits for it
+        scheduler.submit(CommandTarget{false, "a", ""}, [&]() {
+            std::unique_lock<std::mutex> lck(mutex);
+            overtaken.wait_for(
+                lck, std::chrono::seconds(10), [&]() { return other_system_done; });
+            order.push_back("a blocked");
+        });
+        scheduler.submit(CommandTarget{false, "a", "p1"}, [&]() {
+            std::lock_guard<std::mutex> lck(mutex);
+            order.push_back("a p1");
+        });
+        scheduler.submit(CommandTarget{false, "b", ""}, [&]() {
+            std::lock_guard<std::mutex> lck(mutex);
+            order.push_back("b");
+            other_system_done = true;
+            overtaken.notify_all();
+        });
+    }
+    // the scheduler waited for its commands when it was destroyed
+    EXPECT_EQ(order, (std::vector<std::string>{"b", "a blocked", "a p1"}));
+}
+
+TEST(ControlToolJobQueue, runsWaitsForAndCancelsJobs)
+{
+    std::mutex mutex;
+    std::vector<std::string> events;
+    JobQueue jobs([&](const JobInfo& job) {
+        std::lock_guard<std::mutex> lck(mutex);
+        events.push_back(std::to_string(job._id) + " " + getJobStateName(job._state));
+    });
+
+    const auto succeeded = jobs.run(CommandTarget{false, "a", ""}, "first", []() { return 0; });
+    const auto failed = jobs.run(CommandTarget{false, "b", ""}, "second", []() { return 3; });
+    auto job = jobs.wait(succeeded);
+    ASSERT_TRUE(job);
+    EXPECT_EQ(job->_state, JobInfo::State::done);
+    EXPECT_EQ(job->_command_line, "first");
+    job = jobs.wait(failed);
+    ASSERT_TRUE(job);
+    EXPECT_EQ(job->_state, JobInfo::State::failed);
+    EXPECT_EQ(job->_result, 3);
+    EXPECT_FALSE(jobs.getJob(100u));
+    EXPECT_FALSE(jobs.wait(100u));
+
+    // the second job on the same target is queued until the first one ends
+    std::condition_variable released;
+    bool release = false;
+    const auto blocking = jobs.run(CommandTarget{false, "a", ""}, "blocking", [&]() {
+        std::unique_lock<std::mutex> lck(mutex);
+        released.wait_for(lck, std::chrono::seconds(10), [&]() { return release; });
+        return 0;
+    });
+    const auto queued = jobs.run(CommandTarget{false, "a", "p"}, "queued", []() { return 0; });
+    job = jobs.cancel(queued);
+    ASSERT_TRUE(job);
+    EXPECT_EQ(job->_state, JobInfo::State::cancelled);
+    EXPECT_EQ(jobs.wait(queued)->_state, JobInfo::State::cancelled);
+    {
+        std::lock_guard<std::mutex> lck(mutex);
+        release = true;
+    }
+    released.notify_all();
+    EXPECT_EQ(jobs.wait(blocking)->_state, JobInfo::State::done);
+    // a job which already ended is not cancelled
+    EXPECT_EQ(jobs.cancel(blocking)->_state, JobInfo::State::done);
+    EXPECT_EQ(jobs.getJobs().size(), 4u);
+
+    std::lock_guard<std::mutex> lck(mutex);
+    EXPECT_EQ(std::count(events.begin(), events.end(), std::to_string(succeeded) + " running"), 1);
+    EXPECT_EQ(std::count(events.begin(), events.end(), std::to_string(failed) + " failed"), 1);
+    EXPECT_EQ(std::count(events.begin(), events.end(), std::to_string(queued) + " cancelled"), 1);
+    EXPECT_EQ(std::count(events.begin(), events.end(), std::to_string(queued) + " running"), 0);
+}
+
+TEST(ControlToolJobQueue, keepsTheMostRecentEndedJobs)
+{
+    JobQueue jobs([](const JobInfo&) {}, 2u);
+    std::uint64_t last_id = 0u;
+    for (std::size_t index = 0u; index < JobQueue::max_ended_jobs + 10u; ++index) {
+        last_id = jobs.run(CommandTarget{false, "a", ""}, "job", []() { return 0; });
+    }
+    EXPECT_EQ(jobs.wait(last_id)->_state, JobInfo::State::done);
+    EXPECT_EQ(jobs.getJobs().size(), JobQueue::max_ended_jobs);
+    EXPECT_FALSE(jobs.getJob(1u));
+}
+
+TEST(ControlToolJobQueue, forgetsACancelledJobBeforeItsTurn)
+{
+    JobQueue jobs([](const JobInfo&) {}, 2u);
+    std::mutex mutex;
+    std::condition_variable released;
+    bool release = false;
+    jobs.run(CommandTarget{false, "x", ""}, "blocking", [&]() {
+        std::unique_lock<std::mutex> lck(mutex);
+        released.wait_for(lck, std::chrono::seconds(10), [&]() { return release; });
+        return 0;
+    });
+    const auto cancelled = jobs.run(CommandTarget{false, "x", ""}, "cancelled", []() { return 0; });
+    EXPECT_EQ(jobs.cancel(cancelled)->_state, JobInfo::State::cancelled);
+
+    // the jobs on another target end meanwhile, the cancelled job is forgotten
+    std::uint64_t last_id = 0u;
+    for (std::size_t index = 0u; index < JobQueue::max_ended_jobs + 10u; ++index) {
+        last_id = jobs.run(CommandTarget{false, "y", ""}, "job", []() { return 0; });
+    }
+    EXPECT_EQ(jobs.wait(last_id)->_state, JobInfo::State::done);
+    EXPECT_FALSE(jobs.getJob(cancelled));
+
+    {
+        std::lock_guard<std::mutex> lck(mutex);
+        release = true;
+    }
+    released.notify_all();
+    // runs after the blocking job, which is forgotten when it ends, and the task of the
+    // cancelled job
+    const auto next = jobs.run(CommandTarget{false, "x", ""}, "next", []() { return 0; });
+    EXPECT_EQ(jobs.wait(next)->_state, JobInfo::State::done);
+}
@@ -21,17 +21,23 @@ You may add additional accurate notices of copyright ownership.
 #include "binary_tool_path.h"
 #include "control_tool_websocket_test.h"
 
+#include "../../../../../src/fep_control_tool/control_tool_common_helper.h"
+
 #include <a_util/filesystem.h>
 #include <a_util/strings.h>
 #include <boost/asio/connect.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/process.hpp>
 #include <chrono>
 #include <fep_system/fep_system.h>
+#include <fstream>
 #include <gtest/gtest.h>
 #include <json/json.h>
+#include <map>
+#include <set>
 #include <thread>
 #include <unordered_set>
 #include  <future>
@@ -159,3 +165,181 @@ TEST_F(ControlToolWebsocket, testSystemHandling_multiClient)
     ASSERT_TRUE(testSystemHandling(client1));
     ASSERT_TRUE(testSystemHandling(client2));
 }
+
+TEST_F(ControlToolWebsocket, testChainedCommands)
+{
+    bp::child c(binary_tool_path + " --websocket --json");
+
+    ControlToolClient client;
+
+    bool is_connected = client.connectWebsocket();
+    ASSERT_EQ(is_connected, true);
+
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+    const auto receiveArray = [&client, &reader]() {
+        const std::string answer = client.receiveMessage();
+        Json::Value messages;
+        std::string parse_errors;
+        EXPECT_TRUE(reader->parse(
+            answer.c_str(), answer.c_str() + answer.size(), &messages, &parse_errors))
+            << parse_errors;
+        EXPECT_TRUE(messages.isArray()) << answer;
+        return messages;
+    };
+
+    // the command after a failed '&&' is skipped, the one after ';' runs
+    client.sendMessage("getCurrentWorkingDirectory && noSuchCommand && getCurrentWorkingDirectory;"
+                       " getCurrentWorkingDirectory");
+    Json::Value messages = receiveArray();
+    ASSERT_EQ(messages.size(), 3u);
+    EXPECT_EQ(messages[0]["action"].asString(), "getCurrentWorkingDirectory");
+    EXPECT_EQ(messages[1]["action"].asString(), "processCommandline");
+    EXPECT_EQ(messages[2]["action"].asString(), "getCurrentWorkingDirectory");
+
+    client.sendMessage(R"([{"cmd": "getCurrentWorkingDirectory"}, {"cmd": "noSuchCommand"}])");
+    messages = receiveArray();
+    ASSERT_EQ(messages.size(), 2u);
+    EXPECT_EQ(messages[0]["status"].asInt(), 0);
+    EXPECT_NE(messages[1]["status"].asInt(), 0);
+
+    // the answers of the parallel commands of a script are part of the frame as well
+    const auto script_file = boost::filesystem::temp_directory_path() /
+                             boost::filesystem::unique_path("fep_control_script_%%%%%%.txt");
+    {
+        std::ofstream script(script_file.string());
+        script << "parallel {\n"
+               << "    getCurrentWorkingDirectory\n"
+               << "    getCurrentWorkingDirectory\n"
+               << "}\n";
+    }
+    for (const char* option: {"", " --auto-parallel"}) {
+        client.sendMessage("source " + quoteNameIfNecessary(script_file.string()) + option +
+                           "; getCurrentWorkingDirectory");
+        messages = receiveArray();
+        ASSERT_EQ(messages.size(), 4u) << option;
+        EXPECT_EQ(messages[0]["action"].asString(), "getCurrentWorkingDirectory");
+        EXPECT_EQ(messages[1]["action"].asString(), "getCurrentWorkingDirectory");
+        EXPECT_EQ(messages[2]["action"].asString(), "source");
+        EXPECT_EQ(messages[3]["action"].asString(), "getCurrentWorkingDirectory");
+    }
+    boost::filesystem::remove(script_file);
+
+    ASSERT_EQ(client.closeWebsocket(), true);
+}
+
+TEST_F(ControlToolWebsocket, testJsonCommandsEchoTheirId)
+{
+    bp::child c(binary_tool_path + " --websocket --json");
+
+    ControlToolClient client;
+
+    bool is_connected = client.connectWebsocket();
+    ASSERT_EQ(is_connected, true);
+
+    // the requests are sent without waiting for the answers
+    client.sendMessage(R"({"id": 1, "cmd": "getCurrentWorkingDirectory"})");
+    client.sendMessage(R"({"id": "second", "cmd": "noSuchCommand", "args": ["a b", 2]})");
+    client.sendMessage(R"({"id": 3, "args": []})");
+
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+    // the answers may arrive in another order, they are found by their id
+    std::map<std::string, Json::Value> answers;
+    for (int index = 0; index < 3; ++index) {
+        const std::string answer = client.receiveMessage();
+        Json::Value message;
+        std::string parse_errors;
+        ASSERT_TRUE(reader->parse(
+            answer.c_str(), answer.c_str() + answer.size(), &message, &parse_errors))
+            << parse_errors;
+        answers[message["id"].asString()] = message;
+    }
+    ASSERT_EQ(answers.size(), 3u);
+    EXPECT_EQ(answers["1"]["id"], Json::Value(1));
+    EXPECT_EQ(answers["1"]["action"].asString(), "getCurrentWorkingDirectory");
+    EXPECT_NE(answers["second"]["status"].asInt(), 0);
+    EXPECT_NE(answers["3"]["status"].asInt(), 0);
+
+    // also the commands of a script run by the workers of source answer with the id
+    const auto script_file = boost::filesystem::temp_directory_path() /
+                             boost::filesystem::unique_path("fep_control_script_%%%%%%.txt");
+    {
+        std::ofstream script(script_file.string());
+        script << "getCurrentWorkingDirectory\n"
+               << "parallel {\n"
+               << "    getCurrentWorkingDirectory\n"
+               << "    getCurrentWorkingDirectory\n"
+               << "}\n";
+    }
+    Json::Value request;
+    request["id"] = 5;
+    request["cmd"] = "source";
+    request["args"].append(script_file.string());
+    Json::StreamWriterBuilder writer_builder;
+    writer_builder.settings_["indentation"] = "";
+    client.sendMessage(Json::writeString(writer_builder, request));
+    for (int index = 0; index < 4; ++index) {
+        const std::string answer = client.receiveMessage();
+        Json::Value message;
+        std::string parse_errors;
+        ASSERT_TRUE(reader->parse(
+            answer.c_str(), answer.c_str() + answer.size(), &message, &parse_errors))
+            << parse_errors;
+        EXPECT_EQ(message["id"], Json::Value(5)) << answer;
+        EXPECT_EQ(message["action"].asString(),
+                  index < 3 ? "getCurrentWorkingDirectory" : "source");
+    }
+    boost::filesystem::remove(script_file);
+
+    ASSERT_EQ(client.closeWebsocket(), true);
+}
+
+TEST_F(ControlToolWebsocket, testPipelinedRequests)
+{
+    bp::child c(binary_tool_path + " --websocket --json");
+
+    ControlToolClient client;
+
+    bool is_connected = client.connectWebsocket();
+    ASSERT_EQ(is_connected, true);
+
+    // all requests are sent before the first answer is read, each one is answered once
+    constexpr int request_count = 20;
+    for (int id = 0; id < request_count; ++id) {
+        client.sendMessage(R"({"id": )" + std::to_string(id) +
+                           R"(, "cmd": "getCurrentWorkingDirectory"})");
+    }
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> const reader(builder.newCharReader());
+    std::set<int> answered_ids;
+    for (int index = 0; index < request_count; ++index) {
+        const std::string answer = client.receiveMessage();
+        Json::Value message;
+        std::string parse_errors;
+        ASSERT_TRUE(reader->parse(
+            answer.c_str(), answer.c_str() + answer.size(), &message, &parse_errors))
+            << parse_errors;
+        EXPECT_EQ(message["status"].asInt(), 0);
+        answered_ids.insert(message["id"].asInt());
+    }
+    EXPECT_EQ(answered_ids.size(), static_cast<std::size_t>(request_count));
+
+    // a text command waits for the requests before it
+    client.sendMessage(R"({"id": "last", "cmd": "getCurrentWorkingDirectory"})");
+    client.sendMessage("getCurrentWorkingDirectory");
+    std::string answer = client.receiveMessage();
+    EXPECT_NE(answer.find("\"last\""), std::string::npos) << answer;
+    answer = client.receiveMessage();
+    EXPECT_EQ(answer.find("\"id\""), std::string::npos) << answer;
+
+    // so does the error of an invalid line
+    client.sendMessage("getCurrentWorkingDirectory");
+    client.sendMessage(R"({"cmd": )");
+    answer = client.receiveMessage();
+    EXPECT_NE(answer.find("getCurrentWorkingDirectory"), std::string::npos) << answer;
+    answer = client.receiveMessage();
+    EXPECT_NE(answer.find("Invalid command line"), std::string::npos) << answer;
+
+    ASSERT_EQ(client.closeWebsocket(), true);
+}